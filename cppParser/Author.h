@@ -3,10 +3,16 @@
 #define AUTHOR_H
 
 #include "mystring.h"
+#include "mystringview.h"
+#include "myutility.h"
+#include "internpool.h"
+
+class InstituteMatcher;
+class InstituteSet;
 
 class Author {
 private:
-    MyString name;
+    InternedString name;    // Shared with equal names once interned
     MyString affiliation;
 
 public:
@@ -14,13 +20,17 @@ public:
     Author();
     Author(const MyString& author_name);
     Author(const MyString& author_name, const MyString& author_affiliation);
+    Author(MyString&& author_name);
+    Author(const InternedString& author_name);
     Author(const Author& other);
+    Author(Author&& other);
 
     // Destructor
     ~Author();
 
     // Assignment operator
     Author& operator=(const Author& other);
+    Author& operator=(Author&& other);
 
     // Comparison operators for sorting
     bool operator==(const Author& other) const;
@@ -30,20 +40,38 @@ public:
     // Accessors
     const MyString& get_name() const;
     const MyString& get_affiliation() const;
+    const InternedString& get_interned_name() const;
 
     // Mutators
     void set_name(const MyString& author_name);
     void set_affiliation(const MyString& author_affiliation);
 
+    // Replaces the name with the pool's shared copy
+    void intern(InternPool& pool);
+
     // Utility methods
     bool is_from_institute(const MyString& institute_name) const;
+    bool is_from_institute(const InstituteMatcher& institute) const;   // No allocation
+
+    // Adds the institutes of the set found in the name or affiliation to
+    // found, as InstituteSet::collect does, and returns their new count
+    unsigned int collect_institutes(const InstituteSet& institutes, unsigned int* found,
+                                    unsigned int found_count, unsigned char* seen) const;
     MyString to_string() const;
     bool empty() const;
     void clear();
 
-    // Static parsing method
+    // Static parsing methods
     static bool parse_author_field(const MyString& author_field, Author* authors, 
                                   int max_authors, int& author_count);
+    static bool parse_author_field(const MyStringView& author_field, Author* authors,
+                                  int max_authors, int& author_count);
+
+    // Splitting helpers: author_list strips the surrounding braces, then
+    // next_author_name yields one trimmed, non-empty name per call
+    static MyStringView author_list(const MyStringView& author_field);
+    static bool next_author_name(MyStringView& remaining, MyStringView& author_name);
+    static int count_authors(const MyStringView& author_list);
 };
 
 #endif // AUTHOR_H
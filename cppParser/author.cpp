@@ -1,5 +1,7 @@
 // author.cpp - Author class implementation
 #include "Author.h"
+#include "institutematcher.h"
+#include "instituteset.h"
 
 // Constructors
 Author::Author() : name(), affiliation() {}
@@ -9,8 +11,14 @@ Author::Author(const MyString& author_name) : name(author_name), affiliation() {
 Author::Author(const MyString& author_name, const MyString& author_affiliation) 
     : name(author_name), affiliation(author_affiliation) {}
 
+Author::Author(MyString&& author_name) : name(my_move(author_name)), affiliation() {}
+
+Author::Author(const InternedString& author_name) : name(author_name), affiliation() {}
+
 Author::Author(const Author& other) : name(other.name), affiliation(other.affiliation) {}
 
+Author::Author(Author&& other) : name(my_move(other.name)), affiliation(my_move(other.affiliation)) {}
+
 // Destructor
 Author::~Author() {
     // MyString destructor handles cleanup
@@ -25,6 +33,14 @@ Author& Author::operator=(const Author& other) {
     return *this;
 }
 
+Author& Author::operator=(Author&& other) {
+    if (this != &other) {
+        name = my_move(other.name);
+        affiliation = my_move(other.affiliation);
+    }
+    return *this;
+}
+
 // Comparison operators
 bool Author::operator==(const Author& other) const {
     return name == other.name && affiliation == other.affiliation;
@@ -36,59 +52,63 @@ bool Author::operator!=(const Author& other) const {
 
 bool Author::operator<(const Author& other) const {
     if (name != other.name) {
-        return name < other.name;
+        return name.str() < other.name.str();
     }
     return affiliation < other.affiliation;
 }
 
 // Accessors
 const MyString& Author::get_name() const {
-    return name;
+    return name.str();
 }
 
 const MyString& Author::get_affiliation() const {
     return affiliation;
 }
 
+const InternedString& Author::get_interned_name() const {
+    return name;
+}
+
 // Mutators
 void Author::set_name(const MyString& author_name) {
-    name = author_name;
+    name = InternedString(author_name);
 }
 
 void Author::set_affiliation(const MyString& author_affiliation) {
     affiliation = author_affiliation;
 }
 
+void Author::intern(InternPool& pool) {
+    pool.intern(name);
+}
+
 // Utility methods
 bool Author::is_from_institute(const MyString& institute_name) const {
-    if (institute_name.empty()) return false;
-
-    // Create lowercase versions for comparison
-    MyString name_lower = name;
-    name_lower.to_lower();
-
-    MyString institute_lower = institute_name;
-    institute_lower.to_lower();
+    InstituteMatcher institute(institute_name);
+    return is_from_institute(institute);
+}
 
-    // Simple check - look for institute name in author name or affiliation
-    // In real implementation, this could be more sophisticated
-    bool found_in_name = (name_lower.find(institute_lower) != name_lower.length());
+// Looks for the institute name in the author name or affiliation
+bool Author::is_from_institute(const InstituteMatcher& institute) const {
+    return institute.matches(name.str()) ||
+           (!affiliation.empty() && institute.matches(affiliation));
+}
 
-    bool found_in_affiliation = false;
+unsigned int Author::collect_institutes(const InstituteSet& institutes, unsigned int* found,
+                                        unsigned int found_count, unsigned char* seen) const {
+    found_count = institutes.collect(name.str(), found, found_count, seen);
     if (!affiliation.empty()) {
-        MyString affil_lower = affiliation;
-        affil_lower.to_lower();
-        found_in_affiliation = (affil_lower.find(institute_lower) != affil_lower.length());
+        found_count = institutes.collect(affiliation, found, found_count, seen);
     }
-
-    return found_in_name || found_in_affiliation;
+    return found_count;
 }
 
 MyString Author::to_string() const {
     if (affiliation.empty()) {
-        return name;
+        return name.str();
     } else {
-        return name + MyString(" (") + affiliation + MyString(")");
+        return name.str() + MyString(" (") + affiliation + MyString(")");
     }
 }
 
@@ -101,50 +121,67 @@ void Author::clear() {
     affiliation.clear();
 }
 
-// Static parsing method
+// Static parsing methods
 bool Author::parse_author_field(const MyString& author_field, Author* authors, 
                                int max_authors, int& author_count) {
+    return parse_author_field(MyStringView(author_field), authors, max_authors, author_count);
+}
+
+bool Author::parse_author_field(const MyStringView& author_field, Author* authors,
+                               int max_authors, int& author_count) {
+    author_count = 0;
     if (author_field.empty() || !authors) {
-        author_count = 0;
         return false;
     }
 
-    author_count = 0;
-    MyString field_copy = author_field;
-    field_copy.trim();
+    // Only the names themselves are copied
+    MyStringView remaining = author_list(author_field);
+    MyStringView author_name;
+    while (author_count < max_authors && next_author_name(remaining, author_name)) {
+        authors[author_count] = Author(author_name.to_string());
+        author_count++;
+    }
+
+    return author_count > 0;
+}
+
+MyStringView Author::author_list(const MyStringView& author_field) {
+    MyStringView field = author_field.trimmed();
 
     // Remove braces if present
-    if (!field_copy.empty() && field_copy[0] == '{') {
-        field_copy = field_copy.substr(1);
-        if (!field_copy.empty() && field_copy[field_copy.length() - 1] == '}') {
-            field_copy = field_copy.substr(0, field_copy.length() - 1);
+    if (field.starts_with("{")) {
+        field.remove_prefix(1);
+        if (field.ends_with("}")) {
+            field.remove_suffix(1);
         }
     }
+    return field;
+}
 
-    // Split by " and " to separate authors
-    unsigned long pos = 0;
-    while (pos < field_copy.length() && author_count < max_authors) {
-        // Find next " and "
-        unsigned long next_and = field_copy.find(" and ", pos);
+bool Author::next_author_name(MyStringView& remaining, MyStringView& author_name) {
+    // Split by " and " to separate authors, skipping empty names
+    const MyStringView separator(" and ");
+    while (!remaining.empty()) {
+        unsigned long next_and = remaining.find(separator);
+        author_name = remaining.substr(0, next_and).trimmed();
 
-        MyString author_name;
-        if (next_and == field_copy.length()) {
-            // Last author
-            author_name = field_copy.substr(pos);
+        if (next_and == remaining.length()) {
+            remaining = MyStringView(); // Last author
         } else {
-            // Extract author name up to " and "
-            author_name = field_copy.substr(pos, next_and - pos);
-        }
-
-        author_name.trim();
-        if (!author_name.empty()) {
-            authors[author_count] = Author(author_name);
-            author_count++;
+            remaining.remove_prefix(next_and + separator.length()); // Skip " and "
         }
 
-        if (next_and == field_copy.length()) break;
-        pos = next_and + 5; // Skip " and "
+        if (!author_name.empty()) return true;
     }
+    return false;
+}
 
-    return author_count > 0;
+int Author::count_authors(const MyStringView& author_list) {
+    MyStringView remaining = author_list;
+    MyStringView author_name;
+    int count = 0;
+    while (next_author_name(remaining, author_name)) {
+        count++;
+    }
+    return count;
 }
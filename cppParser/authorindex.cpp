@@ -0,0 +1,442 @@
+// authorindex.cpp - Entries of each author, keyed by a normalized name
+#include "authorindex.h"
+
+static const unsigned int MAX_NAME_TOKENS = 32;
+static const char PROTECTED_SPACE = '\x01';     // Space, comma or period inside braces
+static const long UNKNOWN_NAME = -1;            // Pooled name not normalized yet
+static const long NO_AUTHOR = -2;               // Pooled name with an empty key
+
+// U+00C0..U+017F (Latin-1 letters and Latin Extended-A) without their
+// accents; '?' marks the signs U+00D7 and U+00F7
+static const char LATIN_LETTERS[] =
+    "AAAAAAACEEEEIIIIDNOOOOO?OUUUUYTsaaaaaaaceeeeiiiidnooooo?ouuuuyty"
+    "AaAaAaCcCcCcCcDdDdEeEeEeEeEeGgGgGgGgHhHhIiIiIiIiIiIiJjKkkLlLlLlLlLl"
+    "NnNnNnnNnOoOoOoOoRrRrRrSsSsSsSsTtTtTtUuUuUuUuUuUuWwYyYZzZzZzs";
+
+// LaTeX commands that stand for letters; every other command word (the
+// accents \c, \v, \u, \H and so on, or unknown ones) is dropped
+static const char* const LATEX_LETTERS[][2] = {
+    {"ss", "ss"}, {"ae", "ae"}, {"AE", "AE"}, {"oe", "oe"}, {"OE", "OE"}, {"aa", "a"},
+    {"AA", "A"}, {"o", "o"}, {"O", "O"}, {"l", "l"}, {"L", "L"}, {"i", "i"}, {"j", "j"},
+    {"dh", "d"}, {"DH", "D"}, {"th", "th"}, {"TH", "TH"}
+};
+
+static const char* latex_letters(const char* command, unsigned long length) {
+    for (unsigned long i = 0; i < sizeof(LATEX_LETTERS) / sizeof(LATEX_LETTERS[0]); i++) {
+        const char* name = LATEX_LETTERS[i][0];
+        if (MyString::strlen(name) == length && memcmp(name, command, length) == 0) {
+            return LATEX_LETTERS[i][1];
+        }
+    }
+    return nullptr;
+}
+
+// Letters of the tables above spelled with two ASCII letters
+static const char* two_letter_spelling(unsigned int code_point) {
+    switch (code_point) {
+    case 0xC6: return "AE";
+    case 0xE6: return "ae";
+    case 0xDE: return "TH";
+    case 0xFE: return "th";
+    case 0xDF: return "ss";
+    case 0x152: return "OE";
+    case 0x153: return "oe";
+    default: return nullptr;
+    }
+}
+
+static bool is_ascii_letter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_name_letter(char c) {
+    return is_ascii_letter(c) || (c >= '0' && c <= '9') || (unsigned char)c >= 0x80;
+}
+
+// Strips the markup of a name, keeping its case: LaTeX accents and braces
+// disappear, letter commands and UTF-8 Latin letters become ASCII, '~'
+// and other whitespace become spaces. Inside braces, spaces, commas and
+// periods become PROTECTED_SPACE so "{Barnes and Noble}" stays one token.
+static MyString fold_name(const MyStringView& name) {
+    const char* text = name.data();
+    unsigned long length = name.length();
+    MyString folded;
+    folded.reserve(length);     // Never grows: each spelling is at most as long as its source
+
+    unsigned int depth = 0;
+    unsigned long i = 0;
+    while (i < length) {
+        char c = text[i];
+        unsigned char byte = (unsigned char)c;
+        if (c == '{') {
+            depth++;
+            i++;
+        } else if (c == '}') {
+            if (depth > 0) depth--;
+            i++;
+        } else if (c == '\\') {
+            unsigned long start = ++i;
+            while (i < length && is_ascii_letter(text[i])) i++;
+            if (i > start) {
+                const char* letters = latex_letters(text + start, i - start);
+                if (letters) folded.append(letters, MyString::strlen(letters));
+                while (i < length && text[i] == ' ') i++;   // TeX skips spaces after a command word
+            } else if (i < length) {
+                i++;    // Control symbol: an accent such as \' or an escaped character
+            }
+        } else if (byte >= 0xC3 && byte <= 0xC5 && i + 1 < length && ((unsigned char)text[i + 1] & 0xC0) == 0x80) {
+            unsigned int code_point = ((byte & 0x1F) << 6) | ((unsigned char)text[i + 1] & 0x3F);
+            const char* letters = two_letter_spelling(code_point);
+            char letter = LATIN_LETTERS[code_point - 0xC0];
+            if (letters) {
+                folded.append(letters, 2);
+            } else if (letter != '?') {
+                folded.append(&letter, 1);
+            }
+            i += 2;
+        } else {
+            if (c == '~' || c == '\t' || c == '\n' || c == '\r') c = ' ';
+            if (depth > 0 && (c == ' ' || c == ',' || c == '.')) c = PROTECTED_SPACE;
+            folded.append(&c, 1);
+            i++;
+        }
+    }
+    return folded;
+}
+
+// Splits text at spaces and periods into at most max non-empty tokens;
+// the last one takes whatever is left over
+static unsigned int split_tokens(const MyStringView& text, MyStringView* tokens, unsigned int max) {
+    unsigned int count = 0;
+    unsigned long start = 0;
+    for (unsigned long i = 0; i <= text.length(); i++) {
+        if (i < text.length() && text[i] != ' ' && text[i] != '.') continue;
+        if (i > start) {
+            if (count < max) {
+                tokens[count++] = MyStringView(text.data() + start, i - start);
+            } else {
+                const char* first = tokens[max - 1].data();
+                tokens[max - 1] = MyStringView(first, text.data() + i - first);
+            }
+        }
+        start = i + 1;
+    }
+    return count;
+}
+
+// "von" tokens are those whose first letter is lowercase
+static bool starts_lowercase(const MyStringView& token) {
+    for (unsigned long i = 0; i < token.length(); i++) {
+        if (is_ascii_letter(token[i])) return token[i] >= 'a' && token[i] <= 'z';
+        if ((unsigned char)token[i] >= 0x80) return false;
+    }
+    return false;
+}
+
+// Surname tokens in lowercase, every run of other characters as one
+// space; apostrophes join ("O'Brien" is "obrien")
+static void append_surname(MyString& key, const MyStringView* tokens, unsigned int count) {
+    for (unsigned int t = 0; t < count; t++) {
+        bool pending_space = !key.empty();
+        for (unsigned long i = 0; i < tokens[t].length(); i++) {
+            char c = tokens[t][i];
+            if (c == '\'' || c == '`') continue;
+            if (!is_name_letter(c)) {
+                pending_space = !key.empty();
+                continue;
+            }
+            if (pending_space) {
+                key.append(" ", 1);
+                pending_space = false;
+            }
+            char folded = MyString::tolower(c);
+            key.append(&folded, 1);
+        }
+    }
+}
+
+// ", " and then the first letter of each given name, hyphenated parts
+// counting as names of their own; a UTF-8 initial is copied whole
+static void append_initials(MyString& key, const MyStringView* tokens, unsigned int count) {
+    bool first = true;
+    for (unsigned int t = 0; t < count; t++) {
+        const MyStringView& token = tokens[t];
+        bool name_start = true;
+        for (unsigned long i = 0; i < token.length(); i++) {
+            char c = token[i];
+            if (c == '-' || c == PROTECTED_SPACE) {
+                name_start = true;
+                continue;
+            }
+            if (!name_start || !is_name_letter(c)) continue;
+
+            key.append(first ? ", " : " ", first ? 2 : 1);
+            first = false;
+            name_start = false;
+            unsigned long end = i + 1;
+            if ((unsigned char)c >= 0x80) {
+                while (end < token.length() && ((unsigned char)token[end] & 0xC0) == 0x80) end++;
+                key.append(token.data() + i, end - i);
+                i = end - 1;
+            } else {
+                char folded = MyString::tolower(c);
+                key.append(&folded, 1);
+            }
+        }
+    }
+}
+
+// Follows BibTeX: with no comma the surname starts at the first lowercase
+// ("von") token before the last one, or is the last token; with commas it
+// is everything before the first, and the given names follow the last
+MyString AuthorIndex::normalize(const MyStringView& name) {
+    MyString folded = fold_name(name);
+    MyStringView text(folded);
+
+    MyStringView parts[3];
+    unsigned int part_count = 0;
+    unsigned long start = 0;
+    for (unsigned long i = 0; i <= text.length(); i++) {
+        if (i < text.length() && text[i] != ',') continue;
+        if (part_count < 3) {
+            parts[part_count++] = text.substr(start, i - start);
+        } else {
+            parts[2] = MyStringView(parts[2].data(), text.data() + i - parts[2].data());
+        }
+        start = i + 1;
+    }
+
+    MyStringView surname_tokens[MAX_NAME_TOKENS];
+    MyStringView given_tokens[MAX_NAME_TOKENS];
+    const MyStringView* surname = surname_tokens;
+    const MyStringView* given = given_tokens;
+    unsigned int surname_count, given_count;
+    if (part_count == 1) {
+        unsigned int count = split_tokens(parts[0], surname_tokens, MAX_NAME_TOKENS);
+        unsigned int first = count > 0 ? count - 1 : 0;
+        for (unsigned int i = 0; i + 1 < count; i++) {
+            if (starts_lowercase(surname_tokens[i])) {
+                first = i;
+                break;
+            }
+        }
+        surname = surname_tokens + first;
+        surname_count = count - first;
+        given = surname_tokens;
+        given_count = first;
+    } else {
+        surname_count = split_tokens(parts[0], surname_tokens, MAX_NAME_TOKENS);
+        given_count = split_tokens(parts[part_count - 1], given_tokens, MAX_NAME_TOKENS);
+    }
+
+    MyString key;
+    append_surname(key, surname, surname_count);
+    if (key.empty() || (given_count == 0 && key == "others")) return MyString();
+    append_initials(key, given, given_count);
+    return key;
+}
+
+// Constructor
+AuthorIndex::AuthorIndex() : listed_count(0) {}
+
+// Building
+// Letters of a spelling outside LaTeX command words, so "Søren Øster"
+// outweighs both "S{\o}ren {\O}ster" and "S. Øster"
+static unsigned long spelling_weight(const MyString& name) {
+    unsigned long weight = 0;
+    for (unsigned long i = 0; i < name.length(); i++) {
+        if (name[i] == '\\') {
+            while (i + 1 < name.length() && is_ascii_letter(name[i + 1])) i++;
+        } else if (is_name_letter(name[i])) {
+            weight++;
+        }
+    }
+    return weight;
+}
+
+long AuthorIndex::author_id(const MyStringView& key) const {
+    unsigned long hash = key.hash();
+    unsigned long cursor = key_lookup.probe_start(hash);
+    unsigned long id;
+    while (key_lookup.next_candidate(hash, cursor, id)) {
+        if (MyStringView(authors[id].key) == key) return (long)id;
+    }
+    return -1;
+}
+
+// Names interned in pool are normalized once and then found by their id
+long AuthorIndex::intern_author(const Author& author, const InternPool& pool) {
+    const InternedString& name = author.get_interned_name();
+    unsigned int pool_id = name.get_id();
+    bool pooled = pool_id < pool.size() && &pool.get(pool_id) == &name.str();
+    if (pooled && pool_id < pooled_authors.get_size() && pooled_authors[pool_id] != UNKNOWN_NAME) {
+        return pooled_authors[pool_id];
+    }
+
+    long id = NO_AUTHOR;
+    MyString key = normalize(name.str());
+    if (!key.empty()) {
+        id = author_id(key);
+        if (id < 0) {
+            AuthorRecord* record = authors.emplace_back();
+            if (!record) return NO_AUTHOR;     // Not cached, so a later entry retries
+            id = (long)authors.get_size() - 1;
+            record->key = my_move(key);
+            key_lookup.insert(MyStringView(record->key).hash(), (unsigned long)id);
+        }
+        if (spelling_weight(name.str()) > spelling_weight(authors[id].name)) authors[id].name = name.str();
+    }
+
+    if (pooled) {
+        while (pooled_authors.get_size() <= pool_id) pooled_authors.push_back(UNKNOWN_NAME);
+        pooled_authors[pool_id] = id;
+    }
+    return id;
+}
+
+void AuthorIndex::add_entry(const BibEntry& entry, unsigned long position, const InternPool& pool) {
+    for (int i = 0; i < entry.get_author_count(); i++) {
+        long id = intern_author(entry.get_author(i), pool);
+        if (id < 0) continue;
+
+        MyVector<unsigned long>& positions = authors[id].positions;
+        if (positions.empty()) listed_count++;
+        else if (positions[positions.get_size() - 1] == position) continue;    // Listed twice
+        positions.push_back(position);
+    }
+}
+
+// Lists that end before the first removed position are left alone
+void AuthorIndex::remove_positions(const unsigned long* removed, unsigned long count) {
+    if (count == 0) return;
+    for (unsigned long id = 0; id < authors.get_size(); id++) {
+        MyVector<unsigned long>& positions = authors[id].positions;
+        unsigned long size = positions.get_size();
+        if (size == 0 || positions[size - 1] < removed[0]) continue;
+
+        unsigned long kept = 0, below = 0;    // below: removed positions passed so far
+        for (unsigned long i = 0; i < size; i++) {
+            unsigned long position = positions[i];
+            while (below < count && removed[below] < position) below++;
+            if (below < count && removed[below] == position) continue;
+            positions[kept++] = position - below;
+        }
+        while (positions.get_size() > kept) positions.pop_back();
+        if (kept == 0) listed_count--;
+    }
+}
+
+void AuthorIndex::clear() {
+    authors.clear();
+    key_lookup.clear();
+    pooled_authors.clear();
+    listed_count = 0;
+}
+
+// Queries
+long AuthorIndex::find_author(const MyStringView& name) const {
+    MyString key = normalize(name);
+    long id = key.empty() ? -1 : author_id(key);
+    return id >= 0 && !authors[id].positions.empty() ? id : -1;
+}
+
+unsigned long AuthorIndex::find(long author, const unsigned long*& found) const {
+    found = nullptr;
+    if (author < 0 || (unsigned long)author >= authors.get_size() || authors[author].positions.empty()) {
+        return 0;
+    }
+    found = &authors[author].positions[0];
+    return authors[author].positions.get_size();
+}
+
+unsigned long AuthorIndex::get_author_count() const {
+    return listed_count;
+}
+
+const MyString& AuthorIndex::get_name(long author) const {
+    static const MyString empty_string;
+    return author >= 0 && (unsigned long)author < authors.get_size() ? authors[author].name : empty_string;
+}
+
+const MyString& AuthorIndex::get_key(long author) const {
+    static const MyString empty_string;
+    return author >= 0 && (unsigned long)author < authors.get_size() ? authors[author].key : empty_string;
+}
+
+// Ranking heap: the worst author is at the root; of equal counts the
+// greater key is worse
+struct AuthorRank {
+    unsigned long entry_count;
+    const MyString* key;
+    long author;
+};
+
+static bool rank_worse(const AuthorRank& a, const AuthorRank& b) {
+    return a.entry_count < b.entry_count ||
+           (a.entry_count == b.entry_count && MyString::strcmp(a.key->c_str(), b.key->c_str()) > 0);
+}
+
+static void rank_sift_down(AuthorRank* heap, unsigned long root, unsigned long count) {
+    for (;;) {
+        unsigned long worst = root, left = root * 2 + 1, right = left + 1;
+        if (left < count && rank_worse(heap[left], heap[worst])) worst = left;
+        if (right < count && rank_worse(heap[right], heap[worst])) worst = right;
+        if (worst == root) return;
+        AuthorRank swapped = heap[root];
+        heap[root] = heap[worst];
+        heap[worst] = swapped;
+        root = worst;
+    }
+}
+
+static void rank_sift_up(AuthorRank* heap, unsigned long child) {
+    while (child > 0) {
+        unsigned long parent = (child - 1) / 2;
+        if (!rank_worse(heap[child], heap[parent])) return;
+        AuthorRank swapped = heap[child];
+        heap[child] = heap[parent];
+        heap[parent] = swapped;
+        child = parent;
+    }
+}
+
+unsigned long AuthorIndex::top(unsigned int k, MyVector<AuthorCount>& result) const {
+    if (k > listed_count) k = (unsigned int)listed_count;
+    if (k == 0) return 0;
+
+    AuthorRank* heap = (AuthorRank*)malloc(sizeof(AuthorRank) * k);
+    if (!heap) return 0;
+    unsigned long heap_size = 0;
+    for (unsigned long id = 0; id < authors.get_size(); id++) {
+        AuthorRank rank = {authors[id].positions.get_size(), &authors[id].key, (long)id};
+        if (rank.entry_count == 0) continue;
+        if (heap_size < k) {
+            heap[heap_size++] = rank;
+            rank_sift_up(heap, heap_size - 1);
+        } else if (rank_worse(heap[0], rank)) {
+            heap[0] = rank;
+            rank_sift_down(heap, 0, heap_size);
+        }
+    }
+
+    // Popping the worst author to the back leaves the heap sorted best first
+    for (unsigned long size = heap_size; size > 1; size--) {
+        AuthorRank worst = heap[0];
+        heap[0] = heap[size - 1];
+        heap[size - 1] = worst;
+        rank_sift_down(heap, 0, size - 1);
+    }
+    result.reserve(result.get_size() + heap_size);
+    for (unsigned long i = 0; i < heap_size; i++) {
+        AuthorCount* counted = result.emplace_back();
+        if (!counted) {
+            heap_size = i;
+            break;
+        }
+        counted->name = authors[heap[i].author].name;
+        counted->key = authors[heap[i].author].key;
+        counted->entry_count = heap[i].entry_count;
+    }
+    free(heap);
+    return heap_size;
+}
@@ -0,0 +1,61 @@
+// authorindex.h - Entries of each author, keyed by a normalized name
+#ifndef AUTHORINDEX_H
+#define AUTHORINDEX_H
+
+#include "bibdatabase.h"
+
+// Positions of the entries of a BibDatabase listed under each author.
+// Spellings of one name share an author: "Bhattacharya, Arani", "Arani
+// Bhattacharya", "A. Bhattacharya" and "Bhattach{\=a}rya, A." all have
+// the key "bhattacharya, a" (see normalize). Each distinct interned name
+// is normalized once. Entries are appended with add_entry(); after
+// remove_positions() the later positions are renumbered in place, so
+// neither needs a rebuild.
+class AuthorIndex {
+private:
+    struct AuthorRecord {
+        MyString key;                       // normalize() of the name
+        MyString name;                      // Fullest spelling seen
+        MyVector<unsigned long> positions;  // Ascending, each entry once
+    };
+
+    MyVector<AuthorRecord> authors;
+    HashIndex key_lookup;                   // Hash of a key -> author id
+    MyVector<long> pooled_authors;          // Intern pool id -> author id, or below 0
+    unsigned long listed_count;             // Authors with at least one entry
+
+    long author_id(const MyStringView& key) const;
+    long intern_author(const Author& author, const InternPool& pool);
+
+public:
+    AuthorIndex();
+
+    // Building - positions must be added in ascending order; names of
+    // entries from pool are looked up by their interned id
+    void add_entry(const BibEntry& entry, unsigned long position, const InternPool& pool);
+
+    // Forgets the entries at removed (ascending) and shifts every later
+    // position down by the number removed before it
+    void remove_positions(const unsigned long* removed, unsigned long count);
+    void clear();
+
+    // Queries - find() points found at the entry positions of an author
+    long find_author(const MyStringView& name) const;  // -1 if no entry lists it
+    unsigned long find(long author, const unsigned long*& found) const;
+    unsigned long get_author_count() const;             // Authors with entries
+    const MyString& get_name(long author) const;
+    const MyString& get_key(long author) const;
+
+    // The k authors with the most entries, most first; equal counts are
+    // ordered by key. Returns how many were appended.
+    unsigned long top(unsigned int k, MyVector<AuthorCount>& result) const;
+
+    // "surname, initials" in lowercase ASCII where possible: LaTeX
+    // accents and UTF-8 Latin letters fold to their base letters, braces
+    // disappear, "von" particles stay with the surname, "Jr" parts are
+    // dropped, and given names become their initials ("Jean-Pierre" gives
+    // "j p"). Empty for an empty name or "others".
+    static MyString normalize(const MyStringView& name);
+};
+
+#endif // AUTHORINDEX_H
@@ -0,0 +1,2124 @@
+// benchmark.cpp - Performance benchmarks for the BibTeX parser components
+#include "bibdatabase.h"
+#include "bibcolumns.h"
+#include "institutematcher.h"
+#include "instituteset.h"
+#include "bufferedreader.h"
+#include "bufferedwriter.h"
+#include "secondaryindex.h"
+#include "textindex.h"
+#include "authorindex.h"
+
+// System calls and C runtime functions
+extern "C" {
+    int open(const char* path, int flags, ...);
+    int close(int fd);
+    long read(int fd, void* buf, unsigned long count);
+    long write(int fd, const void* buf, unsigned long count);
+    int printf(const char* format, ...);
+    int snprintf(char* str, unsigned long size, const char* format, ...);
+    int clock_gettime(int clock_id, void* tp);
+    int fflush(void* stream);
+    int fork();
+    int waitpid(int pid, int* status, int options);
+    void _exit(int status);
+    long sysconf(int name);
+    double log(double x);
+}
+
+// Layout-compatible with glibc's struct mallinfo2
+struct BenchMallinfo {
+    unsigned long arena, ordblks, smblks, hblks, hblkhd;
+    unsigned long usmblks, fsmblks, uordblks, fordblks, keepcost;
+};
+
+extern "C" BenchMallinfo mallinfo2();
+
+// Bytes currently handed out by malloc (small-block heap plus mmap'd blocks)
+static unsigned long heap_in_use() {
+    BenchMallinfo info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+#ifndef O_RDONLY
+#define O_RDONLY 0
+#endif
+#ifndef O_WRONLY
+#define O_WRONLY 1
+#endif
+#ifndef O_CREAT
+#define O_CREAT 64
+#endif
+#ifndef O_TRUNC
+#define O_TRUNC 512
+#endif
+
+#define CLOCK_MONOTONIC_ID 1
+#define SC_PAGESIZE_ID 30
+
+// Resident set size of this process, from /proc/self/statm
+static unsigned long resident_bytes() {
+    int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0) return 0;
+    char buffer[128];
+    long n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buffer[n] = '\0';
+
+    // Second field: resident pages
+    unsigned long i = 0, pages = 0;
+    while (i < (unsigned long)n && buffer[i] != ' ') i++;
+    for (i++; i < (unsigned long)n && buffer[i] >= '0' && buffer[i] <= '9'; i++) {
+        pages = pages * 10 + (unsigned long)(buffer[i] - '0');
+    }
+    return pages * (unsigned long)sysconf(SC_PAGESIZE_ID);
+}
+
+// Layout-compatible with struct timespec on 64-bit Linux
+struct BenchTimespec {
+    long tv_sec;
+    long tv_nsec;
+};
+
+// Simple wall-clock stopwatch
+class BenchTimer {
+private:
+    BenchTimespec start_time;
+
+public:
+    BenchTimer() { reset(); }
+
+    void reset() {
+        clock_gettime(CLOCK_MONOTONIC_ID, &start_time);
+    }
+
+    double elapsed_seconds() const {
+        BenchTimespec now;
+        clock_gettime(CLOCK_MONOTONIC_ID, &now);
+        return (double)(now.tv_sec - start_time.tv_sec) +
+               (double)(now.tv_nsec - start_time.tv_nsec) / 1e9;
+    }
+};
+
+// Function prototypes
+void print_usage(const char* program_name);
+unsigned long parse_number(const char* str);
+bool generate_bib_file(const char* filename, unsigned long megabytes);
+int bench_read(const char* filename);
+int bench_alloc(const char* filename);
+int bench_memory(const char* filename);
+int bench_sort(unsigned long count);
+int bench_lookup(unsigned long count);
+int bench_parallel(const char* filename, int max_threads);
+int bench_tokenize(const char* filename);
+int bench_scan(const char* filename);
+int bench_fields(unsigned long count);
+int bench_arena(const char* filename);
+int bench_intern(const char* filename);
+int bench_columns(const char* filename, const char* institute);
+int bench_institute(const char* filename, const char* institute);
+int bench_institutes(const char* filename, int name_count, char* names[]);
+int bench_institute_threads(const char* filename, int max_threads);
+int bench_snapshot(const char* filename);
+int bench_save(unsigned long count, const char* filename);
+int bench_growth(const char* filename);
+int bench_indexes(const char* filename);
+int bench_text(const char* source, const char* query);
+int bench_authors(const char* filename);
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    MyString mode(argv[1]);
+
+    if (mode == "gen" && argc == 4) {
+        return generate_bib_file(argv[2], parse_number(argv[3])) ? 0 : 1;
+    } else if (mode == "read" && argc == 3) {
+        return bench_read(argv[2]);
+    } else if (mode == "alloc" && argc == 3) {
+        return bench_alloc(argv[2]);
+    } else if (mode == "memory" && argc == 3) {
+        return bench_memory(argv[2]);
+    } else if (mode == "sort" && argc == 3) {
+        return bench_sort(parse_number(argv[2]));
+    } else if (mode == "lookup" && argc == 3) {
+        return bench_lookup(parse_number(argv[2]));
+    } else if (mode == "scan" && argc == 3) {
+        return bench_scan(argv[2]);
+    } else if (mode == "indexes" && argc == 3) {
+        return bench_indexes(argv[2]);
+    } else if (mode == "authors" && argc == 3) {
+        return bench_authors(argv[2]);
+    } else if (mode == "text" && (argc == 3 || argc == 4)) {
+        return bench_text(argv[2], argc == 4 ? argv[3] : nullptr);
+    } else if (mode == "growth" && argc == 3) {
+        return bench_growth(argv[2]);
+    } else if (mode == "save" && argc == 4) {
+        return bench_save(parse_number(argv[2]), argv[3]);
+    } else if (mode == "snapshot" && argc == 3) {
+        return bench_snapshot(argv[2]);
+    } else if (mode == "institute-threads" && (argc == 3 || argc == 4)) {
+        return bench_institute_threads(argv[2], argc == 4 ? (int)parse_number(argv[3]) : online_cpu_count());
+    } else if (mode == "institutes" && argc >= 4) {
+        return bench_institutes(argv[2], argc - 3, argv + 3);
+    } else if (mode == "institute" && (argc == 3 || argc == 4)) {
+        return bench_institute(argv[2], argc == 4 ? argv[3] : "IIITD");
+    } else if (mode == "columns" && (argc == 3 || argc == 4)) {
+        return bench_columns(argv[2], argc == 4 ? argv[3] : "IIITD");
+    } else if (mode == "intern" && argc == 3) {
+        return bench_intern(argv[2]);
+    } else if (mode == "arena" && argc == 3) {
+        return bench_arena(argv[2]);
+    } else if (mode == "fields" && argc == 3) {
+        return bench_fields(parse_number(argv[2]));
+    } else if (mode == "tokenize" && argc == 3) {
+        return bench_tokenize(argv[2]);
+    } else if (mode == "parallel" && (argc == 3 || argc == 4)) {
+        return bench_parallel(argv[2], argc == 4 ? (int)parse_number(argv[3]) : online_cpu_count());
+    }
+
+    print_usage(argv[0]);
+    return 1;
+}
+
+void print_usage(const char* program_name) {
+    printf("Usage: %s <mode> [arguments]\n", program_name);
+    printf("\n");
+    printf("Modes:\n");
+    printf("  gen <file> <megabytes>  Generate a synthetic .bib file\n");
+    printf("  read <file>             Compare byte-at-a-time and buffered line reading\n");
+    printf("  alloc <file>            Count MyString heap allocations while loading\n");
+    printf("  memory <file>           Report heap bytes per loaded entry\n");
+    printf("  sort <count>            Sort count synthetic entries with each algorithm\n");
+    printf("  lookup <count>          Time key lookups, merges and removals on count entries\n");
+    printf("  tokenize <file>         Tokenizer throughput alone and inside load_from_file\n");
+    printf("  scan <file>             Structural index and tokenizer speed per SIMD level\n");
+    printf("  fields <count>          Time count rounds of BibEntry::set_field dispatch\n");
+    printf("  arena <file>            Load time, RSS and teardown with and without the string arena\n");
+    printf("  intern <file>           Venue and author equality: interned handles vs string compares\n");
+    printf("  columns <file> [inst]   Scans over BibEntry rows vs BibColumns (default institute: IIITD)\n");
+    printf("  institute <file> [inst] Institute matching: lowercase copies vs InstituteMatcher\n");
+    printf("  institutes <file> <inst>...  One InstituteMatcher pass per name vs one InstituteSet pass\n");
+    printf("  institute-threads <file> [max]  Institute author scan with 1..max threads\n");
+    printf("  snapshot <file>         Parse vs binary snapshot load (writes <file>.snap)\n");
+    printf("  save <count> <file>     save_to_file throughput on count synthetic entries\n");
+    printf("  growth <file>           String appends, entry vectors and to_string with geometric growth\n");
+    printf("  indexes <file>          Year range, type and venue queries: scans vs secondary indexes\n");
+    printf("  text <file|count> [query]  Full-text index build, size and AND/OR/phrase/top-10 queries\n");
+    printf("  authors <file>          Per-author queries and top-10: scans vs the author index, with edits\n");
+    printf("  parallel <file> [max]   Load time with 1..max threads (default: all processors)\n");
+}
+
+unsigned long parse_number(const char* str) {
+    unsigned long value = 0;
+    for (; str && *str >= '0' && *str <= '9'; str++) {
+        value = value * 10 + (unsigned long)(*str - '0');
+    }
+    return value;
+}
+
+// Synthetic input generation
+bool generate_bib_file(const char* filename, unsigned long megabytes) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Error: Cannot create file %s\n", filename);
+        return false;
+    }
+
+    static const char* surnames[] = {
+        "Bhattacharya", "Maity", "Xu", "Chaudhary", "Singh", "Goel", "Porter",
+        "Balasubramanian", "Paramita", "Srivastava", "Mondal", "Aggarwal"
+    };
+    static const char* venues[] = {
+        "USENIX Annual Technical Conference", "Computer Communications",
+        "ACM MobiSys", "IEEE INFOCOM", "ACM SenSys", "NSDI"
+    };
+    static const char* words[] = {
+        "energy", "smartphone", "video", "network", "latency", "edge",
+        "wireless", "sensor", "cloud", "throughput", "display", "system"
+    };
+
+    const unsigned long target = megabytes * 1024UL * 1024UL;
+    const unsigned long out_size = 1UL << 20;
+    char* out = (char*)malloc(out_size + 8192);
+    if (!out) {
+        close(fd);
+        return false;
+    }
+
+    unsigned long written = 0;
+    unsigned long used = 0;
+    unsigned long n = 0;
+    unsigned long seed = 12345;
+
+    while (written + used < target) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        unsigned long r = seed >> 33;
+
+        used += snprintf(out + used, 512,
+                         "@inproceedings{entry%lu,\n"
+                         "    abbr = {SYN},\n"
+                         "    abstract = {",
+                         n);
+        // Long single-line abstract, similar to the real sample file
+        for (int w = 0; w < 120; w++) {
+            used += snprintf(out + used, 64, "%s%s", w ? " " : "",
+                             words[(r + w * 7) % 12]);
+        }
+        used += snprintf(out + used, 2048,
+                         ".},\n"
+                         "    author = {%s, Arani and %s, Mukulika and %s, Jian},\n"
+                         "    booktitle = {%s},\n"
+                         "    doi = {10.1145/%lu.%lu},\n"
+                         "    pdf = {https://example.org/pdf/entry%lu.pdf},\n"
+                         "    title = {Synthetic %s %s Study Number %lu},\n"
+                         "    year = {%lu}\n"
+                         "}\n\n",
+                         surnames[r % 12], surnames[(r >> 4) % 12], surnames[(r >> 8) % 12],
+                         venues[(r >> 12) % 6], 3000000 + n, r % 100000, n,
+                         words[(r >> 16) % 12], words[(r >> 20) % 12], n,
+                         1990 + (r >> 24) % 36);
+        n++;
+
+        if (used >= out_size) {
+            write(fd, out, used);
+            written += used;
+            used = 0;
+        }
+    }
+
+    if (used > 0) {
+        write(fd, out, used);
+        written += used;
+    }
+
+    free(out);
+    close(fd);
+    printf("Generated %lu entries (%lu bytes) in %s\n", n, written, filename);
+    return true;
+}
+
+// Line reading: the original one-byte-per-read() loop versus BufferedReader
+int bench_read(const char* filename) {
+    // Baseline: one read() system call per byte
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open file %s\n", filename);
+        return 1;
+    }
+
+    BenchTimer timer;
+    unsigned long syscalls = 1;
+    unsigned long bytes = 0;
+    unsigned long lines = 0;
+    MyString line;
+    char c;
+
+    while (true) {
+        long got = read(fd, &c, 1);
+        syscalls++;
+        if (got <= 0) break;
+        bytes++;
+        if (c == '\n') lines++;
+    }
+    close(fd);
+    syscalls++;
+
+    double unbuffered_time = timer.elapsed_seconds();
+    double mb = (double)bytes / (1024.0 * 1024.0);
+
+    printf("=== Line reading: %s (%.1f MB, %lu lines) ===\n", filename, mb, lines);
+    printf("%-22s %14s %10s %10s\n", "reader", "syscalls", "seconds", "MB/s");
+    printf("%-22s %14lu %10.3f %10.1f\n", "read(fd, &c, 1)", syscalls,
+           unbuffered_time, mb / unbuffered_time);
+
+    // Buffered: one read() system call per block
+    BufferedReader reader;
+    if (!reader.open(filename)) {
+        printf("Error: Cannot open file %s\n", filename);
+        return 1;
+    }
+
+    timer.reset();
+    unsigned long buffered_lines = 0;
+    while (reader.read_line(line)) {
+        buffered_lines++;
+    }
+    reader.close();
+    double buffered_time = timer.elapsed_seconds();
+
+    printf("%-22s %14lu %10.3f %10.1f\n", "BufferedReader", reader.get_syscall_count(),
+           buffered_time, mb / buffered_time);
+
+    // Full database load in both modes
+    static const BibDatabase::LoadMode modes[] = { BibDatabase::LOAD_BUFFERED, BibDatabase::LOAD_MAPPED };
+    static const char* mode_names[] = { "buffered", "mapped" };
+
+    printf("\n%-22s %14s %10s %10s\n", "load_from_file", "entries", "seconds", "MB/s");
+    for (int m = 0; m < 2; m++) {
+        BibDatabase database("Benchmark");
+        database.set_verbose(false);
+        timer.reset();
+        database.load_from_file(filename, modes[m]);
+        double load_time = timer.elapsed_seconds();
+
+        printf("%-22s %14lu %10.3f %10.1f\n", mode_names[m], database.size(),
+               load_time, mb / load_time);
+    }
+
+    return buffered_lines >= lines ? 0 : 1;
+}
+
+// MyString heap allocations made while loading a file
+int bench_alloc(const char* filename) {
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+
+    MyString::reset_allocation_count();
+    BenchTimer timer;
+    if (!database.load_from_file(filename)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    double load_time = timer.elapsed_seconds();
+    unsigned long allocations = MyString::get_allocation_count();
+
+    printf("=== MyString allocations: %s ===\n", filename);
+    printf("entries:              %lu\n", database.size());
+    printf("heap allocations:     %lu\n", allocations);
+    printf("allocations / entry:  %.1f\n", (double)allocations / (double)database.size());
+    printf("load time:            %.3f s\n", load_time);
+    return 0;
+}
+
+// Heap footprint of a loaded database
+int bench_memory(const char* filename) {
+    unsigned long before = heap_in_use();
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(filename)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    unsigned long used = heap_in_use() - before;
+    unsigned long entries = database.size();
+
+    unsigned long authors = 0;
+    for (unsigned long i = 0; i < entries; i++) {
+        authors += database.get_entry(i).get_author_count();
+    }
+
+    printf("=== Memory: %s ===\n", filename);
+    printf("entries:              %lu\n", entries);
+    printf("authors:              %lu\n", authors);
+    printf("sizeof(BibEntry):     %lu bytes\n", (unsigned long)sizeof(BibEntry));
+    printf("sizeof(Author):       %lu bytes\n", (unsigned long)sizeof(Author));
+    printf("interned strings:     %u (%lu bytes of text)\n", database.get_intern_pool().size(),
+           database.get_intern_pool().get_text_bytes());
+    printf("heap in use:          %lu bytes\n", used);
+    printf("heap bytes / entry:   %.1f\n", (double)used / (double)entries);
+    return 0;
+}
+
+// Orders entries by citation key, to exercise the comparator parameter
+struct EntryKeyLess {
+    bool operator()(const BibEntry& a, const BibEntry& b) const {
+        return a.get_entry_key() < b.get_entry_key();
+    }
+};
+
+// Fills a vector with count entries with pseudo-random years and titles
+static void make_sort_entries(MyVector<BibEntry>& entries, unsigned long count) {
+    static const char* words[] = {
+        "Energy", "Smartphone", "Video", "Network", "Latency", "Edge",
+        "Wireless", "Sensor", "Cloud", "Throughput", "Display", "System"
+    };
+
+    char buffer[128];
+    unsigned long seed = 42;
+    for (unsigned long i = 0; i < count; i++) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        unsigned long r = seed >> 33;
+
+        snprintf(buffer, sizeof(buffer), "key%lu", r);
+        BibEntry* added = entries.emplace_back(MyString(buffer));
+        if (!added) return;
+        BibEntry& entry = *added;
+        snprintf(buffer, sizeof(buffer), "%s %s for %s Systems %lu", words[r % 12],
+                 words[(r >> 4) % 12], words[(r >> 8) % 12], (r >> 12) % 1000);
+        entry.set_title(buffer);
+        snprintf(buffer, sizeof(buffer), "%lu", 1990 + (r >> 24) % 36);
+        entry.set_year(buffer);
+    }
+}
+
+template<typename Compare>
+static bool is_sorted(const MyVector<BibEntry>& entries, Compare comp) {
+    for (unsigned long i = 1; i < entries.get_size(); i++) {
+        if (comp(entries[i], entries[i - 1])) return false;
+    }
+    return true;
+}
+
+int bench_sort(unsigned long count) {
+    printf("=== Sorting %lu synthetic entries ===\n", count);
+    printf("%-34s %10s %8s\n", "algorithm", "seconds", "sorted");
+
+    bool all_sorted = true;
+    for (int run = 0; run < 4; run++) {
+        MyVector<BibEntry> entries;
+        make_sort_entries(entries, count);
+
+        const char* name = "";
+        bool sorted = false;
+        BenchTimer timer;
+        if (run == 0) {
+            name = "introsort (year desc, title)";
+            entries.sort();
+        } else if (run == 1) {
+            name = "merge sort (year desc, title)";
+            entries.stable_sort();
+        } else if (run == 2) {
+            name = "merge sort (citation key)";
+            entries.stable_sort(EntryKeyLess());
+        } else {
+            // Key records + one permutation pass
+            BibDatabase database("Benchmark");
+            for (unsigned long i = 0; i < count; i++) {
+                database.add_entry(my_move(entries[i]));
+            }
+            entries.clear();
+
+            name = "sort_entries (key records)";
+            timer.reset();
+            database.sort_entries();
+            double seconds = timer.elapsed_seconds();
+
+            sorted = true;
+            for (unsigned long i = 1; i < database.size(); i++) {
+                if (database.get_entry(i) < database.get_entry(i - 1)) sorted = false;
+            }
+            all_sorted = all_sorted && sorted;
+            printf("%-34s %10.3f %8s\n", name, seconds, sorted ? "yes" : "NO");
+            continue;
+        }
+        double seconds = timer.elapsed_seconds();
+
+        if (run == 2) {
+            sorted = is_sorted(entries, EntryKeyLess());
+        } else {
+            sorted = is_sorted(entries, MyLess<BibEntry>());
+        }
+        all_sorted = all_sorted && sorted;
+        printf("%-34s %10.3f %8s\n", name, seconds, sorted ? "yes" : "NO");
+    }
+
+    return all_sorted ? 0 : 1;
+}
+
+// Builds a database of count entries keyed "<prefix><i>" for i in [first, first + count)
+static void make_keyed_database(BibDatabase& database, const char* prefix,
+                                unsigned long first, unsigned long count) {
+    char buffer[64];
+    for (unsigned long i = first; i < first + count; i++) {
+        snprintf(buffer, sizeof(buffer), "%s%lu", prefix, i);
+        BibEntry entry = BibEntry(MyString(buffer));
+        entry.set_title("Synthetic Entry");
+        entry.set_year("2020");
+        database.add_entry(my_move(entry));
+    }
+}
+
+// Appends an entry keyed "<prefix><i>" for the first i whose key hash has
+// home slot range_first..range_last in a table of capacity slots
+static void add_entry_in_slots(BibDatabase& database, const char* prefix, unsigned long& i,
+                               unsigned long capacity, unsigned long range_first, unsigned long range_last,
+                               const char* title) {
+    char buffer[64];
+    while (true) {
+        snprintf(buffer, sizeof(buffer), "%s%lu", prefix, i++);
+        MyString key(buffer);
+        unsigned long home = key.hash() & (capacity - 1);
+        if (home < range_first || home > range_last) continue;
+        BibEntry entry = BibEntry(key);
+        entry.set_title(title);
+        database.add_entry(my_move(entry));
+        return;
+    }
+}
+
+// Two entries with the same key whose probe chain wraps past the end of
+// a capacity-slot key index; find_entry must return the first of them
+// before and after the index grows, as the linear scan did
+static bool duplicate_key_survives_growth(unsigned long capacity) {
+    BibDatabase database("Duplicates");
+    unsigned long filler = 0, duplicate = 0;
+    // Fillers home in the lower half, so they stay clear of the last slots
+    for (unsigned long i = 0; i + 2 < capacity / 2; i++) {
+        add_entry_in_slots(database, "fill", filler, capacity, 0, capacity / 2 - 1, "filler");
+    }
+    add_entry_in_slots(database, "dup", duplicate, capacity, capacity - 1, capacity - 1, "first");
+    BibEntry second = BibEntry(database.get_entry(database.size() - 1).get_entry_key());
+    second.set_title("second");
+    database.add_entry(my_move(second));
+
+    // Entries move when the vector grows, so keep the title rather than the pointer
+    MyString key = database.get_entry(database.size() - 1).get_entry_key();
+    const BibEntry* before = database.find_entry(key);
+    bool first_before = before && before->get_title() == "first";
+    for (unsigned long i = 0; i < capacity / 2 + 2; i++) {
+        add_entry_in_slots(database, "grow", filler, capacity, 0, capacity - 1, "filler");
+    }
+    const BibEntry* after = database.find_entry(key);
+    return first_before && after && after->get_title() == "first";
+}
+
+int bench_lookup(unsigned long count) {
+    if (count == 0) count = 1;
+    printf("=== Key lookups on %lu entries ===\n", count);
+
+    BenchTimer timer;
+    BibDatabase database("Lookup");
+    make_keyed_database(database, "key", 0, count);
+    printf("add_entry (indexed):        %8.3f s\n", timer.elapsed_seconds());
+
+    // Hits in a scattered order, then misses
+    char buffer[64];
+    unsigned long found = 0;
+    timer.reset();
+    for (unsigned long i = 0; i < count; i++) {
+        snprintf(buffer, sizeof(buffer), "key%lu", (i * 7919) % count);
+        if (database.find_entry(MyString(buffer))) found++;
+    }
+    double hit_seconds = timer.elapsed_seconds();
+
+    unsigned long missed = 0;
+    timer.reset();
+    for (unsigned long i = 0; i < count; i++) {
+        snprintf(buffer, sizeof(buffer), "absent%lu", i);
+        if (!database.find_entry(MyString(buffer))) missed++;
+    }
+    double miss_seconds = timer.elapsed_seconds();
+    printf("find_entry hits:            %8.1f ns/lookup (%lu/%lu found)\n",
+           hit_seconds * 1e9 / count, found, count);
+    printf("find_entry misses:          %8.1f ns/lookup (%lu/%lu missed)\n",
+           miss_seconds * 1e9 / count, missed, count);
+
+    // Reference: the old linear scan, sampled since it is O(n) per lookup
+    unsigned long samples = count < 1000 ? count : 1000;
+    unsigned long scanned = 0;
+    timer.reset();
+    for (unsigned long i = 0; i < samples; i++) {
+        snprintf(buffer, sizeof(buffer), "key%lu", (i * 7919) % count);
+        MyString key(buffer);
+        for (unsigned long j = 0; j < database.size(); j++) {
+            if (database.get_entry(j).get_entry_key() == key) {
+                scanned++;
+                break;
+            }
+        }
+    }
+    printf("linear scan (reference):    %8.1f ns/lookup\n",
+           timer.elapsed_seconds() * 1e9 / samples);
+
+    // Merge a database that overlaps the first one by half
+    BibDatabase other("Other");
+    make_keyed_database(other, "key", count / 2, count);
+    timer.reset();
+    database += other;
+    printf("operator+= (half overlap):  %8.3f s, %lu entries after merge\n",
+           timer.elapsed_seconds(), database.size());
+
+    // Removal compacts the vector and rebuilds the index
+    timer.reset();
+    bool removed = database.remove_entry(MyString("key0"));
+    double remove_seconds = timer.elapsed_seconds();
+    bool consistent = removed && !database.find_entry(MyString("key0"));
+    printf("remove_entry:               %8.3f s\n", remove_seconds);
+
+    // Positions change after sorting; every key must still resolve to itself
+    database.sort_entries();
+    for (unsigned long i = 0; i < database.size(); i++) {
+        const BibEntry* entry = database.find_entry(database.get_entry(i).get_entry_key());
+        if (entry != &database.get_entry(i)) consistent = false;
+    }
+
+    // Duplicate keys keep resolving to the earliest entry as the index grows
+    bool earliest = true;
+    for (unsigned long capacity = 16; capacity <= 1024; capacity *= 2) {
+        earliest = earliest && duplicate_key_survives_growth(capacity);
+    }
+    printf("duplicates after growth:    %s\n", earliest ? "earliest" : "NOT EARLIEST");
+
+    bool ok = found == count && missed == count && scanned == samples &&
+              database.size() == count + count / 2 - 1 && consistent && earliest;
+    printf("index consistent:           %s\n", ok ? "yes" : "NO");
+    return ok ? 0 : 1;
+}
+
+// Order-sensitive checksum over every stored field of every entry
+static unsigned long database_checksum(const BibDatabase& database) {
+    unsigned long sum = database.size();
+    for (unsigned long i = 0; i < database.size(); i++) {
+        const BibEntry& entry = database.get_entry(i);
+        sum = sum * 31 + entry.to_string().hash();
+        sum = sum * 31 + entry.get_abstract().hash();
+    }
+    return sum;
+}
+
+int bench_parallel(const char* filename, int max_threads) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        printf("Error: Cannot map file %s\n", filename);
+        return 1;
+    }
+    double mb = (double)file.size() / (1024.0 * 1024.0);
+    file.close();
+    if (max_threads < 1) max_threads = 1;
+
+    printf("=== Parallel load: %s (%.1f MB, %d processors online) ===\n",
+           filename, mb, online_cpu_count());
+    printf("%-8s %10s %10s %10s %8s %10s\n", "threads", "entries", "seconds", "MB/s", "speedup", "matches");
+
+    bool all_match = true;
+    unsigned long reference = 0;
+    double base_time = 0.0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        BibDatabase database("Benchmark");
+        database.set_verbose(false);
+        database.set_thread_count(threads);
+
+        BenchTimer timer;
+        database.load_from_file(filename);
+        double load_time = timer.elapsed_seconds();
+
+        // Thread count 1 is the sequential parser and defines the expected result
+        unsigned long checksum = database_checksum(database);
+        if (threads == 1) {
+            reference = checksum;
+            base_time = load_time;
+        }
+        bool match = checksum == reference;
+        all_match = all_match && match;
+
+        printf("%-8d %10lu %10.3f %10.1f %7.2fx %10s\n", threads, database.size(), load_time,
+               mb / load_time, base_time / load_time, match ? "yes" : "NO");
+    }
+
+    return all_match ? 0 : 1;
+}
+
+// Counts tokenizer events without building entries
+struct CountingHandler : public BibTokenHandler {
+    unsigned long entries;
+    unsigned long fields;
+    unsigned long value_bytes;
+    unsigned long errors;
+
+    CountingHandler() : entries(0), fields(0), value_bytes(0), errors(0) {}
+
+    void on_entry_begin(const MyString&, const MyString&) {}
+    void on_field(const MyString&, MyString& value) {
+        fields++;
+        value_bytes += value.length();
+    }
+    void on_entry_end() { entries++; }
+    void on_error(const MyString&) { errors++; }
+};
+
+int bench_tokenize(const char* filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        printf("Error: Cannot map file %s\n", filename);
+        return 1;
+    }
+    double mb = (double)file.size() / (1024.0 * 1024.0);
+
+    printf("=== Tokenizer: %s (%.1f MB) ===\n", filename, mb);
+    printf("%-28s %10s %10s %10s\n", "pass", "entries", "seconds", "MB/s");
+
+    // Tokenizer alone over the whole mapping
+    CountingHandler mapped_counts;
+    BenchTimer timer;
+    {
+        BibTokenizer tokenizer(&mapped_counts);
+        tokenizer.feed(file.get_data(), file.size());
+        tokenizer.finish();
+    }
+    double seconds = timer.elapsed_seconds();
+    file.close();
+    printf("%-28s %10lu %10.3f %10.1f\n", "tokenize (mapped)", mapped_counts.entries,
+           seconds, mb / seconds);
+
+    // Tokenizer alone, fed 1 MiB blocks; state carries across block edges
+    CountingHandler block_counts;
+    BufferedReader reader;
+    if (!reader.open(filename)) {
+        printf("Error: Cannot open file %s\n", filename);
+        return 1;
+    }
+    timer.reset();
+    {
+        BibTokenizer tokenizer(&block_counts);
+        const char* block;
+        unsigned long length;
+        while (reader.read_block(block, length)) {
+            tokenizer.feed(block, length);
+        }
+        tokenizer.finish();
+    }
+    seconds = timer.elapsed_seconds();
+    reader.close();
+    printf("%-28s %10lu %10.3f %10.1f\n", "tokenize (1 MiB blocks)", block_counts.entries,
+           seconds, mb / seconds);
+
+    // Complete loads, including entry construction
+    static const BibDatabase::LoadMode modes[] = { BibDatabase::LOAD_BUFFERED, BibDatabase::LOAD_MAPPED };
+    static const char* mode_names[] = { "load_from_file (buffered)", "load_from_file (mapped)" };
+    for (int m = 0; m < 2; m++) {
+        BibDatabase database("Benchmark");
+        database.set_verbose(false);
+        timer.reset();
+        database.load_from_file(filename, modes[m]);
+        seconds = timer.elapsed_seconds();
+        printf("%-28s %10lu %10.3f %10.1f\n", mode_names[m], database.size(), seconds, mb / seconds);
+    }
+
+    printf("\nfields: %lu, value bytes: %lu, errors: %lu\n",
+           mapped_counts.fields, mapped_counts.value_bytes, mapped_counts.errors);
+
+    bool same = mapped_counts.entries == block_counts.entries &&
+                mapped_counts.fields == block_counts.fields &&
+                mapped_counts.value_bytes == block_counts.value_bytes;
+    return same ? 0 : 1;
+}
+
+int bench_scan(const char* filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        printf("Error: Cannot map file %s\n", filename);
+        return 1;
+    }
+    const char* data = file.get_data();
+    unsigned long size = file.size();
+    double mb = (double)size / (1024.0 * 1024.0);
+
+    StructuralScanLevel best = best_structural_scan_level();
+    printf("=== Structural scan: %s (%.1f MB, best level: %s) ===\n",
+           filename, mb, structural_scan_level_name(best));
+    printf("%-8s %12s %12s %14s %14s\n", "level", "bitmap s", "bitmap MB/s", "tokenize MB/s", "structural");
+
+    // Bitmaps are built per 64 KiB slice, as the tokenizer's index does
+    static const unsigned long SLICE = 64 * 1024;
+    unsigned long* bits = (unsigned long*)malloc(SLICE / 8);
+    if (!bits) return 1;
+
+    bool consistent = true;
+    unsigned long reference_count = 0, reference_sum = 0;
+    for (int level = SCAN_SCALAR; level <= (int)best; level++) {
+        set_structural_scan_level((StructuralScanLevel)level);
+
+        unsigned long count = 0, sum = 0;
+        BenchTimer timer;
+        for (unsigned long offset = 0; offset < size; offset += SLICE) {
+            unsigned long length = size - offset < SLICE ? size - offset : SLICE;
+            structural_bitmap(data + offset, length, bits);
+            for (unsigned long w = 0; w < (length + 63) / 64; w++) {
+                count += (unsigned long)__builtin_popcountl(bits[w]);
+                sum = sum * 31 + bits[w];
+            }
+        }
+        double bitmap_seconds = timer.elapsed_seconds();
+
+        CountingHandler counts;
+        timer.reset();
+        {
+            BibTokenizer tokenizer(&counts);
+            tokenizer.feed(data, size);
+            tokenizer.finish();
+        }
+        double tokenize_seconds = timer.elapsed_seconds();
+
+        // Every level must find exactly the same bytes
+        if (level == SCAN_SCALAR) {
+            reference_count = count;
+            reference_sum = sum;
+        } else if (count != reference_count || sum != reference_sum) {
+            consistent = false;
+        }
+
+        printf("%-8s %12.3f %12.1f %14.1f %14lu\n", structural_scan_level_name((StructuralScanLevel)level),
+               bitmap_seconds, mb / bitmap_seconds, mb / tokenize_seconds, count);
+    }
+
+    free(bits);
+    file.close();
+    set_structural_scan_level(best);
+
+    printf("\nbitmaps identical across levels: %s\n", consistent ? "yes" : "NO");
+    return consistent ? 0 : 1;
+}
+
+// Field names as they occur in typical files, including ones without a member
+static const char* BENCH_FIELD_NAMES[] = {
+    "title", "year", "booktitle", "journal", "doi", "pages", "volume", "number",
+    "publisher", "address", "abbr", "abstract", "url", "month", "note", "keywords"
+};
+static const int BENCH_FIELD_NAME_COUNT = 16;
+
+// The comparison chain set_field used before lookup_field()
+static int chained_field_index(const MyString& name) {
+    static const char* known[] = {
+        "title", "author", "year", "booktitle", "journal", "doi", "abstract", "pdf",
+        "code", "ppt", "abbr", "pages", "volume", "number", "publisher", "address"
+    };
+    for (int i = 0; i < 16; i++) {
+        if (name == known[i]) return i;
+    }
+    return -1;
+}
+
+int bench_fields(unsigned long count) {
+    MyVector<MyString> names;
+    for (int i = 0; i < BENCH_FIELD_NAME_COUNT; i++) {
+        names.push_back(MyString(BENCH_FIELD_NAMES[i]));
+    }
+    unsigned long calls = count * BENCH_FIELD_NAME_COUNT;
+
+    printf("=== Field dispatch: %lu rounds of %d names ===\n", count, BENCH_FIELD_NAME_COUNT);
+    printf("%-24s %10s %12s\n", "pass", "seconds", "ns/field");
+
+    // Name resolution alone, the old way
+    long matched = 0;
+    BenchTimer timer;
+    for (unsigned long round = 0; round < count; round++) {
+        for (int i = 0; i < BENCH_FIELD_NAME_COUNT; i++) {
+            matched += chained_field_index(names[i]);
+        }
+    }
+    double seconds = timer.elapsed_seconds();
+    printf("%-24s %10.3f %12.1f\n", "comparison chain", seconds, seconds * 1e9 / (double)calls);
+
+    // Full set_field calls with short (inline) values
+    BibEntry entry;
+    timer.reset();
+    for (unsigned long round = 0; round < count; round++) {
+        for (int i = 0; i < BENCH_FIELD_NAME_COUNT; i++) {
+            entry.set_field(names[i], MyString("2024"));
+        }
+    }
+    seconds = timer.elapsed_seconds();
+    printf("%-24s %10.3f %12.1f\n", "set_field (switch)", seconds, seconds * 1e9 / (double)calls);
+
+    printf("\nextra fields kept: %d (checksum %ld)\n", entry.get_extra_field_count(), matched);
+    return entry.get_extra_field_count() == 4 ? 0 : 1;
+}
+
+// One load/teardown cycle, run in a child process so each mode starts
+// from a fresh heap and its RSS is not hidden by memory freed earlier
+static void run_arena_pass(const char* filename, bool use_arena) {
+    unsigned long rss_before = resident_bytes();
+    unsigned long allocations_before = MyString::get_allocation_count();
+
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    database.set_arena_enabled(use_arena);
+
+    BenchTimer timer;
+    database.load_from_file(filename);
+    double load_seconds = timer.elapsed_seconds();
+
+    unsigned long rss = resident_bytes() - rss_before;
+    unsigned long allocations = MyString::get_allocation_count() - allocations_before;
+    unsigned long entries = database.size();
+    unsigned long blocks = database.get_arena().get_block_count();
+    unsigned long arena_used = database.get_arena().get_bytes_used();
+
+    timer.reset();
+    database.clear();
+    double teardown_seconds = timer.elapsed_seconds();
+
+    printf("%-8s %10lu %10.3f %10.1f %12lu %10.3f %8lu %10.1f\n", use_arena ? "arena" : "malloc",
+           entries, load_seconds, (double)rss / (1024.0 * 1024.0), allocations, teardown_seconds,
+           blocks, (double)arena_used / (1024.0 * 1024.0));
+}
+
+int bench_arena(const char* filename) {
+    printf("=== String arena: %s ===\n", filename);
+    printf("%-8s %10s %10s %10s %12s %10s %8s %10s\n", "mode", "entries", "load s", "RSS MB",
+           "mallocs", "teardown s", "blocks", "arena MB");
+
+    for (int pass = 0; pass < 2; pass++) {
+        fflush(nullptr); // Otherwise the child inherits and repeats buffered output
+        int pid = fork();
+        if (pid < 0) {
+            printf("Error: fork failed\n");
+            return 1;
+        }
+        if (pid == 0) {
+            run_arena_pass(filename, pass == 1);
+            fflush(nullptr);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (status != 0) return 1;
+    }
+    return 0;
+}
+
+int bench_intern(const char* filename) {
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(filename)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+
+    // Every entry against a fixed sample of up to 1000 entries
+    unsigned long entries = database.size();
+    unsigned long sample = entries < 1000 ? entries : 1000;
+    printf("=== Interning: %s (%lu entries, %u distinct strings) ===\n", filename, entries,
+           database.get_intern_pool().size());
+    printf("%-24s %10s %12s %12s\n", "pass", "seconds", "ns/compare", "matches");
+
+    unsigned long handle_matches = 0;
+    BenchTimer timer;
+    for (unsigned long s = 0; s < sample; s++) {
+        const BibEntry& probe = database.get_entry(s);
+        for (unsigned long i = 0; i < entries; i++) {
+            const BibEntry& entry = database.get_entry(i);
+            if (probe.same_venue(entry)) handle_matches++;
+            if (probe.get_author_count() > 0 && entry.get_author_count() > 0 &&
+                probe.get_author(0) == entry.get_author(0)) {
+                handle_matches++;
+            }
+        }
+    }
+    double handle_seconds = timer.elapsed_seconds();
+
+    unsigned long string_matches = 0;
+    timer.reset();
+    for (unsigned long s = 0; s < sample; s++) {
+        const BibEntry& probe = database.get_entry(s);
+        for (unsigned long i = 0; i < entries; i++) {
+            const BibEntry& entry = database.get_entry(i);
+            if (probe.get_booktitle() == entry.get_booktitle() &&
+                probe.get_journal() == entry.get_journal()) {
+                string_matches++;
+            }
+            if (probe.get_author_count() > 0 && entry.get_author_count() > 0 &&
+                probe.get_author(0).get_name() == entry.get_author(0).get_name() &&
+                probe.get_author(0).get_affiliation() == entry.get_author(0).get_affiliation()) {
+                string_matches++;
+            }
+        }
+    }
+    double string_seconds = timer.elapsed_seconds();
+
+    double compares = (double)(sample * entries * 2);
+    printf("%-24s %10.3f %12.2f %12lu\n", "interned handles", handle_seconds,
+           handle_seconds * 1e9 / compares, handle_matches);
+    printf("%-24s %10.3f %12.2f %12lu\n", "string compares", string_seconds,
+           string_seconds * 1e9 / compares, string_matches);
+
+    printf("\nsame results: %s\n", handle_matches == string_matches ? "yes" : "NO");
+    return handle_matches == string_matches ? 0 : 1;
+}
+
+// Field-by-field equality, including the fields to_string() leaves out
+static bool same_entry(const BibEntry& a, const BibEntry& b) {
+    if (a.get_entry_type() != b.get_entry_type() || a.get_entry_key() != b.get_entry_key() ||
+        a.get_title() != b.get_title() || a.get_year() != b.get_year() ||
+        a.get_year_as_int() != b.get_year_as_int() || a.get_title_key() != b.get_title_key() ||
+        a.get_booktitle() != b.get_booktitle() || a.get_journal() != b.get_journal() ||
+        a.get_doi() != b.get_doi() || a.get_abstract() != b.get_abstract() ||
+        a.get_pdf_url() != b.get_pdf_url() || a.get_code_url() != b.get_code_url() ||
+        a.get_ppt_url() != b.get_ppt_url() || a.get_abbr() != b.get_abbr() ||
+        a.get_pages() != b.get_pages() || a.get_volume() != b.get_volume() ||
+        a.get_number() != b.get_number() || a.get_publisher() != b.get_publisher() ||
+        a.get_address() != b.get_address() ||
+        a.get_author_count() != b.get_author_count() ||
+        a.get_extra_field_count() != b.get_extra_field_count()) {
+        return false;
+    }
+    for (int i = 0; i < a.get_author_count(); i++) {
+        if (a.get_author(i) != b.get_author(i)) return false;
+    }
+    for (int i = 0; i < a.get_extra_field_count(); i++) {
+        if (a.get_extra_field(i).name != b.get_extra_field(i).name ||
+            a.get_extra_field(i).value != b.get_extra_field(i).value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int bench_columns(const char* filename, const char* institute) {
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(filename)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    unsigned long entries = database.size();
+    MyString institute_name(institute);
+
+    BenchTimer timer;
+    BibColumns columns(database);
+    double build_seconds = timer.elapsed_seconds();
+
+    printf("=== Columnar scans: %s (%lu entries, build %.3f s) ===\n", filename, entries, build_seconds);
+    printf("%-28s %12s %12s %10s %14s\n", "scan (x20)", "rows s", "columns s", "speedup", "result");
+
+    static const int ROUNDS = 20;
+    static const int FIRST_YEAR = 1900, LAST_YEAR = 2100;
+    unsigned long row_years[LAST_YEAR - FIRST_YEAR + 1];
+    unsigned long column_years[LAST_YEAR - FIRST_YEAR + 1];
+    bool consistent = true;
+
+    // Count by year
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int y = 0; y <= LAST_YEAR - FIRST_YEAR; y++) row_years[y] = 0;
+        for (unsigned long i = 0; i < entries; i++) {
+            int year = database.get_entry(i).get_year_as_int();
+            if (year >= FIRST_YEAR && year <= LAST_YEAR) row_years[year - FIRST_YEAR]++;
+        }
+    }
+    double row_seconds = timer.elapsed_seconds();
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        columns.count_by_year(column_years, FIRST_YEAR, LAST_YEAR);
+    }
+    double column_seconds = timer.elapsed_seconds();
+    unsigned long dated = 0;
+    for (int y = 0; y <= LAST_YEAR - FIRST_YEAR; y++) {
+        if (row_years[y] != column_years[y]) consistent = false;
+        dated += column_years[y];
+    }
+    printf("%-28s %12.4f %12.4f %9.1fx %14lu\n", "count by year", row_seconds, column_seconds,
+           row_seconds / column_seconds, dated);
+
+    // Count one entry type
+    unsigned long row_kind = 0, column_kind = 0;
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        row_kind = 0;
+        for (unsigned long i = 0; i < entries; i++) {
+            if (MyString::strcmp(database.get_entry(i).get_entry_type().c_str(), "inproceedings") == 0) {
+                row_kind++;
+            }
+        }
+    }
+    row_seconds = timer.elapsed_seconds();
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        column_kind = columns.count_kind(BibColumns::KIND_INPROCEEDINGS);
+    }
+    column_seconds = timer.elapsed_seconds();
+    if (row_kind != column_kind) consistent = false;
+    printf("%-28s %12.4f %12.4f %9.1fx %14lu\n", "count inproceedings", row_seconds, column_seconds,
+           row_seconds / column_seconds, column_kind);
+
+    // Institute authors (without the per-entry printing of BibDatabase)
+    int row_authors = 0, column_authors = 0;
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        row_authors = 0;
+        for (unsigned long i = 0; i < entries; i++) {
+            row_authors += database.get_entry(i).count_institute_authors(institute_name);
+        }
+    }
+    row_seconds = timer.elapsed_seconds();
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        column_authors = columns.count_institute_authors(institute_name);
+    }
+    column_seconds = timer.elapsed_seconds();
+    if (row_authors != column_authors) consistent = false;
+    printf("%-28s %12.4f %12.4f %9.1fx %14d\n", "institute authors", row_seconds, column_seconds,
+           row_seconds / column_seconds, column_authors);
+
+    // Materialize everything back and compare
+    unsigned long mismatches = 0;
+    timer.reset();
+    for (unsigned long i = 0; i < entries; i++) {
+        BibEntry entry = columns.materialize(i);
+        if (!same_entry(entry, database.get_entry(i))) mismatches++;
+    }
+    printf("\nmaterialize + compare all: %.3f s, mismatches: %lu\n", timer.elapsed_seconds(), mismatches);
+    printf("scan results identical: %s\n", consistent ? "yes" : "NO");
+    return consistent && mismatches == 0 ? 0 : 1;
+}
+
+// The matching Author::is_from_institute did before InstituteMatcher:
+// lowercase copies of the pattern, name and affiliation on every call
+static bool copy_lower_match(const Author& author, const MyString& institute_name) {
+    if (institute_name.empty()) return false;
+
+    MyString name_lower = author.get_name();
+    name_lower.to_lower();
+    MyString institute_lower = institute_name;
+    institute_lower.to_lower();
+    if (name_lower.find(institute_lower) != name_lower.length()) return true;
+
+    if (author.get_affiliation().empty()) return false;
+    MyString affil_lower = author.get_affiliation();
+    affil_lower.to_lower();
+    return affil_lower.find(institute_lower) != affil_lower.length();
+}
+
+int bench_institute(const char* filename, const char* institute) {
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(filename)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    unsigned long entries = database.size();
+    MyString institute_name(institute);
+
+    unsigned long authors = 0;
+    for (unsigned long i = 0; i < entries; i++) {
+        authors += (unsigned long)database.get_entry(i).get_author_count();
+    }
+
+    static const int ROUNDS = 20;
+    printf("=== Institute matching: %s (%lu entries, %lu authors, \"%s\", x%d) ===\n",
+           filename, entries, authors, institute, ROUNDS);
+    printf("%-24s %10s %12s %12s %10s\n", "pass", "seconds", "ns/author", "allocations", "matches");
+
+    unsigned long copy_matches = 0;
+    unsigned long allocations = MyString::get_allocation_count();
+    BenchTimer timer;
+    for (int round = 0; round < ROUNDS; round++) {
+        copy_matches = 0;
+        for (unsigned long i = 0; i < entries; i++) {
+            const BibEntry& entry = database.get_entry(i);
+            for (int j = 0; j < entry.get_author_count(); j++) {
+                if (copy_lower_match(entry.get_author(j), institute_name)) copy_matches++;
+            }
+        }
+    }
+    double copy_seconds = timer.elapsed_seconds();
+    unsigned long copy_allocations = MyString::get_allocation_count() - allocations;
+
+    unsigned long matcher_matches = 0;
+    allocations = MyString::get_allocation_count();
+    timer.reset();
+    InstituteMatcher matcher(institute_name);
+    unsigned long build_allocations = MyString::get_allocation_count() - allocations;
+    for (int round = 0; round < ROUNDS; round++) {
+        matcher_matches = 0;
+        for (unsigned long i = 0; i < entries; i++) {
+            const BibEntry& entry = database.get_entry(i);
+            for (int j = 0; j < entry.get_author_count(); j++) {
+                if (entry.get_author(j).is_from_institute(matcher)) matcher_matches++;
+            }
+        }
+    }
+    double matcher_seconds = timer.elapsed_seconds();
+    unsigned long scan_allocations = MyString::get_allocation_count() - allocations - build_allocations;
+
+    double checks = (double)(authors * ROUNDS);
+    if (checks == 0) checks = 1;
+    printf("%-24s %10.3f %12.2f %12lu %10lu\n", "lowercase copies", copy_seconds,
+           copy_seconds * 1e9 / checks, copy_allocations, copy_matches);
+    printf("%-24s %10.3f %12.2f %12lu %10lu\n", "InstituteMatcher", matcher_seconds,
+           matcher_seconds * 1e9 / checks, scan_allocations, matcher_matches);
+
+    printf("\nmatcher build allocations: %lu, allocations while matching: %lu\n",
+           build_allocations, scan_allocations);
+    printf("same results: %s\n", copy_matches == matcher_matches ? "yes" : "NO");
+    return copy_matches == matcher_matches && scan_allocations == 0 ? 0 : 1;
+}
+
+int bench_institutes(const char* filename, int name_count, char* names[]) {
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(filename)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    unsigned long entries = database.size();
+
+    InstituteSet institutes;
+    for (int i = 0; i < name_count; i++) {
+        institutes.add(MyString(names[i]));
+    }
+    unsigned int count = institutes.size();
+    BenchTimer timer;
+    if (count == 0 || !institutes.build()) {
+        printf("Error: No institute names\n");
+        return 1;
+    }
+    double build_seconds = timer.elapsed_seconds();
+
+    static const int ROUNDS = 10;
+    printf("=== Multi-institute counting: %s (%lu entries, %u institutes, x%d) ===\n",
+           filename, entries, count, ROUNDS);
+
+    // One matcher and one pass over all authors per institute
+    int* pass_counts = (int*)malloc(sizeof(int) * count);
+    int* set_counts = (int*)malloc(sizeof(int) * count);
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (unsigned int k = 0; k < count; k++) {
+            InstituteMatcher matcher(institutes.get_name(k));
+            pass_counts[k] = 0;
+            for (unsigned long i = 0; i < entries; i++) {
+                pass_counts[k] += database.get_entry(i).count_institute_authors(matcher);
+            }
+        }
+    }
+    double pass_seconds = timer.elapsed_seconds();
+
+    timer.reset();
+    for (int round = 0; round < ROUNDS; round++) {
+        database.count_institute_authors(institutes, set_counts);
+    }
+    double set_seconds = timer.elapsed_seconds();
+
+    printf("%-32s %10s\n", "pass", "seconds");
+    printf("%-32s %10.3f\n", "one matcher pass per institute", pass_seconds);
+    printf("%-32s %10.3f  (build %.6f s, %.1fx)\n", "one automaton pass", set_seconds, build_seconds,
+           pass_seconds / set_seconds);
+
+    bool consistent = true;
+    printf("\n%-32s %10s\n", "institute", "authors");
+    for (unsigned int k = 0; k < count; k++) {
+        printf("%-32s %10d\n", institutes.get_name(k).c_str(), set_counts[k]);
+        if (pass_counts[k] != set_counts[k]) consistent = false;
+    }
+    free(pass_counts);
+    free(set_counts);
+
+    printf("\nsame results: %s\n", consistent ? "yes" : "NO");
+    return consistent ? 0 : 1;
+}
+
+int bench_institute_threads(const char* filename, int max_threads) {
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(filename)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    if (max_threads < 1) max_threads = 1;
+
+    static const char* const NAMES[] = {
+        "IIITD", "IIT Delhi", "IISc", "University", "Bhattacharya", "Singh"
+    };
+    InstituteSet institutes;
+    for (unsigned long i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); i++) {
+        institutes.add(MyString(NAMES[i]));
+    }
+    institutes.build();
+
+    unsigned long authors = 0;
+    for (unsigned long i = 0; i < database.size(); i++) {
+        authors += (unsigned long)database.get_entry(i).get_author_count();
+    }
+
+    static const int ROUNDS = 5;
+    printf("=== Institute scan: %s (%lu entries, %lu authors, %u institutes, x%d, %d processors online) ===\n",
+           filename, database.size(), authors, institutes.size(), ROUNDS, online_cpu_count());
+    printf("%-8s %10s %12s %8s %10s %10s\n", "threads", "seconds", "Mauthors/s", "speedup", "found", "same");
+
+    bool all_match = true;
+    unsigned long reference = 0;
+    double base_time = 0.0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        database.set_thread_count(threads);
+        MyVector<InstituteMatch> matches;
+
+        BenchTimer timer;
+        for (int round = 0; round < ROUNDS; round++) {
+            database.find_institute_authors(institutes, matches);
+        }
+        double seconds = timer.elapsed_seconds();
+
+        // Order-sensitive, so a reordered reduction shows up
+        unsigned long checksum = matches.get_size();
+        for (unsigned long m = 0; m < matches.get_size(); m++) {
+            checksum = checksum * 31 + matches[m].entry;
+            checksum = checksum * 31 + (unsigned long)matches[m].author;
+            checksum = checksum * 31 + matches[m].institute;
+        }
+        if (threads == 1) {
+            reference = checksum;
+            base_time = seconds;
+        }
+        bool match = checksum == reference;
+        all_match = all_match && match;
+
+        printf("%-8d %10.3f %12.1f %7.2fx %10lu %10s\n", threads, seconds,
+               (double)authors * ROUNDS / seconds / 1e6, base_time / seconds, matches.get_size(),
+               match ? "yes" : "NO");
+    }
+
+    return all_match ? 0 : 1;
+}
+
+int bench_snapshot(const char* filename) {
+    MyString source_name(filename);
+    MyString snapshot_name = source_name + MyString(".snap");
+
+    SourceStamp source;
+    BenchTimer timer;
+    if (!source.capture(filename)) {
+        printf("Error: Cannot read %s\n", filename);
+        return 1;
+    }
+    double stamp_seconds = timer.elapsed_seconds();
+
+    BibDatabase parsed("Benchmark");
+    parsed.set_verbose(false);
+    timer.reset();
+    if (!parsed.load_from_file(source_name)) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    double parse_seconds = timer.elapsed_seconds();
+
+    timer.reset();
+    if (!parsed.save_snapshot(snapshot_name, source)) {
+        printf("Error: Cannot write %s\n", snapshot_name.c_str());
+        return 1;
+    }
+    double save_seconds = timer.elapsed_seconds();
+
+    MappedFile mapped;
+    mapped.open(snapshot_name.c_str());
+    unsigned long snapshot_bytes = mapped.size();
+    mapped.close();
+
+    printf("=== Snapshot: %s (%lu entries, %lu-byte snapshot) ===\n", filename, parsed.size(),
+           snapshot_bytes);
+    printf("%-28s %10s\n", "step", "seconds");
+    printf("%-28s %10.3f\n", "stamp source (size, hash)", stamp_seconds);
+    printf("%-28s %10.3f\n", "parse .bib", parse_seconds);
+    printf("%-28s %10.3f\n", "save snapshot", save_seconds);
+
+    bool all_match = true;
+    for (int arena = 0; arena < 2; arena++) {
+        BibDatabase loaded("Benchmark");
+        loaded.set_verbose(false);
+        loaded.set_arena_enabled(arena == 1);
+        timer.reset();
+        bool ok = loaded.load_snapshot(snapshot_name, source_name);
+        double load_seconds = timer.elapsed_seconds();
+
+        bool match = ok && database_checksum(loaded) == database_checksum(parsed);
+        all_match = all_match && match;
+        printf("%-28s %10.3f  %.1fx faster, same entries: %s\n",
+               arena == 1 ? "load snapshot (arena)" : "load snapshot", load_seconds,
+               parse_seconds / load_seconds, match ? "yes" : "NO");
+    }
+
+    return all_match ? 0 : 1;
+}
+
+// Fills a database with count entries shaped like a typical paper record
+static void make_save_database(BibDatabase& database, unsigned long count) {
+    static const char* surnames[] = {
+        "Bhattacharya", "Maity", "Xu", "Chaudhary", "Singh", "Goel", "Porter", "Srivastava"
+    };
+    static const char* venues[] = {
+        "USENIX Annual Technical Conference", "ACM MobiSys", "IEEE INFOCOM", "NSDI"
+    };
+
+    char buffer[256];
+    unsigned long seed = 7;
+    for (unsigned long i = 0; i < count; i++) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        unsigned long r = seed >> 33;
+
+        snprintf(buffer, sizeof(buffer), "paper%lu", i);
+        BibEntry entry = BibEntry(MyString(buffer));
+        entry.set_entry_type("inproceedings");
+        snprintf(buffer, sizeof(buffer), "Measuring Energy and Latency of Mobile Systems, Part %lu", r % 1000);
+        entry.set_title(buffer);
+        for (unsigned long a = 0; a < 2 + r % 3; a++) {
+            snprintf(buffer, sizeof(buffer), "A. %s", surnames[(r >> (a * 3)) % 8]);
+            entry.add_author(Author(buffer));
+        }
+        snprintf(buffer, sizeof(buffer), "%lu", 2000 + r % 25);
+        entry.set_year(buffer);
+        entry.set_booktitle(venues[(r >> 8) % 4]);
+        snprintf(buffer, sizeof(buffer), "10.1145/%lu.%lu", r % 100000, i);
+        entry.set_doi(buffer);
+        entry.set_abstract(r % 2 ? "We measure the energy use of video streaming on smartphones across "
+                                   "networks and show where the latency goes."
+                                 : "A short abstract.");
+        database.add_entry(my_move(entry));
+    }
+}
+
+int bench_save(unsigned long count, const char* filename) {
+    if (count == 0) count = 1;
+    BibDatabase database("Benchmark");
+    make_save_database(database, count);
+    printf("=== Writing %lu entries to %s ===\n", count, filename);
+    printf("%-32s %10s %10s %12s\n", "method", "seconds", "MB/s", "syscalls");
+
+    // Previous implementation: one MyString per entry, two write() calls each
+    MyString reference_name = MyString(filename) + MyString(".old");
+    BenchTimer timer;
+    int fd = open(reference_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Error: Cannot create file %s\n", reference_name.c_str());
+        return 1;
+    }
+    unsigned long bytes = 0;
+    for (unsigned long i = 0; i < database.size(); i++) {
+        MyString text = database.get_entry(i).to_string();
+        write(fd, text.c_str(), text.length());
+        write(fd, "\n", 1);
+        bytes += text.length() + 1;
+    }
+    close(fd);
+    double old_seconds = timer.elapsed_seconds();
+    printf("%-32s %10.3f %10.1f %12lu\n", "to_string + write() per entry", old_seconds,
+           bytes / old_seconds / 1e6, 2 * database.size() + 2);
+
+    // The same loop as save_to_file, to count its system calls
+    timer.reset();
+    BufferedWriter writer;
+    if (!writer.open(filename)) {
+        printf("Error: Cannot create file %s\n", filename);
+        return 1;
+    }
+    for (unsigned long i = 0; i < database.size(); i++) {
+        database.get_entry(i).write_to(writer);
+        writer.put('\n');
+    }
+    bool written = writer.close();
+    double writer_seconds = timer.elapsed_seconds();
+    printf("%-32s %10.3f %10.1f %12lu\n", "write_to + BufferedWriter", writer_seconds,
+           writer.get_bytes_written() / writer_seconds / 1e6, writer.get_syscall_count());
+
+    timer.reset();
+    bool saved = database.save_to_file(MyString(filename));
+    double save_seconds = timer.elapsed_seconds();
+    printf("%-32s %10.3f %10.1f\n", "save_to_file", save_seconds, bytes / save_seconds / 1e6);
+
+    MappedFile old_file, new_file;
+    bool same = written && saved && old_file.open(reference_name.c_str()) && new_file.open(filename) &&
+                old_file.size() == new_file.size() && old_file.size() == bytes &&
+                memcmp(old_file.get_data(), new_file.get_data(), bytes) == 0;
+    printf("%.1fx faster, identical output: %s\n", old_seconds / save_seconds, same ? "yes" : "NO");
+    return same ? 0 : 1;
+}
+
+int bench_growth(const char* filename) {
+    static const unsigned long APPENDS = 20000;
+    printf("=== Growth: %lu appends, %s ===\n", APPENDS, filename);
+    printf("%-36s %10s %12s\n", "operation", "seconds", "mallocs");
+
+    // Reserving exactly one piece ahead reproduces the old exact-size growth
+    bool same = true;
+    unsigned long lengths[2];
+    for (int geometric = 0; geometric < 2; geometric++) {
+        MyString text;
+        MyString::reset_allocation_count();
+        BenchTimer timer;
+        for (unsigned long i = 0; i < APPENDS; i++) {
+            if (!geometric) text.reserve(text.length() + 8);
+            text.append("piece-of", 8);
+        }
+        printf("%-36s %10.3f %12lu\n", geometric ? "MyString::append (geometric)" : "MyString::append (exact, old)",
+               timer.elapsed_seconds(), MyString::get_allocation_count());
+        lengths[geometric] = text.length();
+    }
+    same = lengths[0] == lengths[1] && lengths[1] == APPENDS * 8;
+
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    BenchTimer timer;
+    if (!database.load_from_file(MyString(filename))) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+    printf("%-36s %10.3f %12s\n", "load_from_file (vector pre-sized)", timer.elapsed_seconds(), "");
+
+    // Entry vectors filled by doubling vs reserved up front
+    for (int reserved = 0; reserved < 2; reserved++) {
+        MyVector<BibEntry> copies;
+        MyString::reset_allocation_count();
+        timer.reset();
+        if (reserved) copies.reserve(database.size());
+        for (unsigned long i = 0; i < database.size(); i++) {
+            copies.push_back(database.get_entry(i));
+        }
+        printf("%-36s %10.3f %12lu\n", reserved ? "MyVector push_back (reserved)" : "MyVector push_back (doubling)",
+               timer.elapsed_seconds(), MyString::get_allocation_count());
+        same = same && copies.get_size() == database.size();
+        copies.shrink_to_fit();
+        same = same && copies.get_capacity() == database.size();
+    }
+
+    MyString::reset_allocation_count();
+    timer.reset();
+    unsigned long total = 0;
+    for (unsigned long i = 0; i < database.size(); i++) {
+        total += database.get_entry(i).to_string().length();
+    }
+    printf("%-36s %10.3f %12lu\n", "BibEntry::to_string (every entry)", timer.elapsed_seconds(),
+           MyString::get_allocation_count());
+
+    same = same && total > 0;
+    printf("consistent: %s\n", same ? "yes" : "NO");
+    return same ? 0 : 1;
+}
+
+// What one analytic query matches when every entry is examined
+static unsigned long scan_query(const BibDatabase& database, int query, const MyString& key,
+                                MyVector<unsigned long>& positions) {
+    MyString normalized = SecondaryIndex::normalize(key);
+    for (unsigned long i = 0; i < database.size(); i++) {
+        const BibEntry& entry = database.get_entry(i);
+        bool match;
+        if (query == 0) {
+            int year = entry.get_year_as_int();
+            match = year >= 2020 && year <= 2024;
+        } else if (query == 1) {
+            match = SecondaryIndex::normalize(entry.get_entry_type()) == normalized;
+        } else {
+            match = SecondaryIndex::normalize(entry.get_booktitle()) == normalized ||
+                    SecondaryIndex::normalize(entry.get_journal()) == normalized;
+        }
+        if (match) positions.push_back(i);
+    }
+    return positions.get_size();
+}
+
+static unsigned long index_query(const BibDatabase& database, int query, const MyString& key,
+                                 MyVector<unsigned long>& positions) {
+    if (query == 0) return database.find_by_year(2020, 2024, positions);
+    if (query == 1) return database.find_by_type(key, positions);
+    return database.find_by_venue(key, positions);
+}
+
+int bench_indexes(const char* filename) {
+    static const int REPEATS = 100;
+
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(MyString(filename))) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+
+    // Query the first entry's type and venue, so both exist in the file
+    MyString type = database.empty() ? MyString("article") : database.get_entry(0).get_entry_type();
+    MyString venue;
+    for (unsigned long i = 0; i < database.size() && venue.empty(); i++) {
+        venue = database.get_entry(i).get_booktitle();
+        if (venue.empty()) venue = database.get_entry(i).get_journal();
+    }
+
+    printf("=== Secondary indexes: %s (%lu entries) ===\n", filename, database.size());
+    printf("%-28s %8s %12s %12s %12s %8s\n", "query", "matches", "scan ms", "build ms", "indexed ms", "same");
+
+    static const char* const labels[] = { "year 2020-2024", "type (first entry)", "venue (first entry)" };
+    bool all_same = true;
+    for (int query = 0; query < 3; query++) {
+        MyString key = query == 1 ? type : venue;
+
+        MyVector<unsigned long> scanned;
+        BenchTimer timer;
+        for (int r = 0; r < REPEATS; r++) {
+            scanned.clear();
+            scan_query(database, query, key, scanned);
+        }
+        double scan_ms = timer.elapsed_seconds() * 1e3 / REPEATS;
+
+        // The first query builds the index; later ones only copy positions
+        MyVector<unsigned long> indexed;
+        timer.reset();
+        index_query(database, query, key, indexed);
+        double build_ms = timer.elapsed_seconds() * 1e3;
+        timer.reset();
+        for (int r = 0; r < REPEATS; r++) {
+            indexed.clear();
+            index_query(database, query, key, indexed);
+        }
+        double indexed_ms = timer.elapsed_seconds() * 1e3 / REPEATS;
+
+        // Year ranges come back year by year; compare as sets
+        bool same = scanned.get_size() == indexed.get_size();
+        if (same) {
+            indexed.sort();
+            for (unsigned long i = 0; i < indexed.get_size(); i++) {
+                if (indexed[i] != scanned[i]) same = false;
+            }
+        }
+        all_same = all_same && same;
+        printf("%-28s %8lu %12.3f %12.3f %12.4f %8s\n", labels[query], scanned.get_size(), scan_ms,
+               build_ms, indexed_ms, same ? "yes" : "NO");
+    }
+
+    // Adding an entry drops the indexes; the next query sees it
+    unsigned long before = database.count_by_year(2020, 2024);
+    BibEntry extra(MyString("index-check-entry"));
+    extra.set_title("Index Check");
+    extra.set_year("2022");
+    database.add_entry(my_move(extra));
+    bool updated = database.count_by_year(2020, 2024) == before + 1;
+    printf("index refreshed after add_entry: %s\n", updated ? "yes" : "NO");
+
+    return all_same && updated ? 0 : 1;
+}
+
+// Pseudo-words from a syllable table; word 0 is the most frequent
+static void make_text_word(unsigned long index, char* buffer) {
+    static const char* const syllables[] = {
+        "ka", "lo", "mi", "ne", "ru", "ta", "po", "se", "vi", "da",
+        "go", "hu", "ze", "fa", "ri", "no", "be", "tu", "ca", "mo"
+    };
+    unsigned long length = 0;
+    do {
+        const char* syllable = syllables[index % 20];
+        buffer[length++] = syllable[0];
+        buffer[length++] = syllable[1];
+        index /= 20;
+    } while (index > 0);
+    buffer[length] = '\0';
+}
+
+// Fills a database with count entries whose titles and abstracts draw words
+// from a Zipf-distributed vocabulary, as natural text does
+static void make_text_database(BibDatabase& database, unsigned long count) {
+    static const unsigned long VOCABULARY = 50000;
+    double* cumulative = (double*)malloc(sizeof(double) * VOCABULARY);
+    if (!cumulative) return;
+    double total = 0.0;
+    for (unsigned long w = 0; w < VOCABULARY; w++) {
+        total += 1.0 / (double)(w + 1);
+        cumulative[w] = total;
+    }
+
+    char key[32], word[32];
+    unsigned long seed = 11;
+    for (unsigned long i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "text%lu", i);
+        BibEntry entry = BibEntry(MyString(key));
+        entry.set_entry_type("article");
+        MyString parts[2];
+        for (int part = 0; part < 2; part++) {
+            seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+            unsigned long words = part == 0 ? 6 + (seed >> 33) % 8 : 40 + (seed >> 33) % 60;
+            parts[part].reserve(words * 8);
+            for (unsigned long w = 0; w < words; w++) {
+                seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+                double target = (double)(seed >> 11) / 9007199254740992.0 * total;
+                unsigned long low = 0, high = VOCABULARY - 1;
+                while (low < high) {
+                    unsigned long middle = (low + high) / 2;
+                    if (cumulative[middle] < target) {
+                        low = middle + 1;
+                    } else {
+                        high = middle;
+                    }
+                }
+                make_text_word(low, word);
+                if (w > 0) parts[part].append(w % 9 == 0 ? ", " : " ", w % 9 == 0 ? 2 : 1);
+                parts[part].append(word, MyString::strlen(word));
+            }
+        }
+        entry.set_title(parts[0]);
+        entry.set_abstract(parts[1]);
+        database.add_entry(my_move(entry));
+    }
+    free(cumulative);
+}
+
+// Marks each token of an entry with the query terms it equals (bit i for
+// term i), the gap between title and abstract matching none
+static unsigned long mark_text_tokens(const BibEntry& entry, const MyVector<MyString>& terms,
+                                      MyVector<unsigned int>& marks) {
+    char term[TextTokenizer::MAX_TERM_LENGTH];
+    unsigned long used = 0;
+    for (int part = 0; part < 2; part++) {
+        TextTokenizer tokens(part == 0 ? entry.get_title() : entry.get_abstract());
+        unsigned int length;
+        if (part == 1) {
+            if (used == marks.get_size()) marks.push_back(0);
+            marks[used++] = 0;
+        }
+        while ((length = tokens.next(term)) > 0) {
+            unsigned int mark = 0;
+            for (unsigned long t = 0; t < terms.get_size(); t++) {
+                if (terms[t].length() == length && memcmp(terms[t].c_str(), term, length) == 0) mark |= 1U << t;
+            }
+            if (used == marks.get_size()) marks.push_back(0);
+            marks[used++] = mark;
+        }
+    }
+    return used;
+}
+
+// Entries with every query term (or the phrase), found by reading every
+// title and abstract
+static unsigned long scan_text_query(const BibDatabase& database, const MyStringView& query, bool phrase,
+                                     MyVector<unsigned long>& entries) {
+    MyVector<MyString> terms;
+    TextTokenizer tokens(query);
+    char term[TextTokenizer::MAX_TERM_LENGTH];
+    unsigned int length;
+    while (terms.get_size() < TextIndex::MAX_QUERY_TERMS && (length = tokens.next(term)) > 0) {
+        terms.push_back(MyString(term, length));
+    }
+    if (terms.empty()) return 0;
+
+    unsigned int all = terms.get_size() == 32 ? 0xffffffffU : (1U << terms.get_size()) - 1;
+    MyVector<unsigned int> marks;
+    for (unsigned long i = 0; i < database.size(); i++) {
+        unsigned long count = mark_text_tokens(database.get_entry(i), terms, marks);
+        bool match = false;
+        if (phrase) {
+            for (unsigned long s = 0; s + terms.get_size() <= count && !match; s++) {
+                match = true;
+                for (unsigned long t = 0; t < terms.get_size() && match; t++) {
+                    match = (marks[s + t] & (1U << t)) != 0;
+                }
+            }
+        } else {
+            unsigned int seen = 0;
+            for (unsigned long p = 0; p < count; p++) seen |= marks[p];
+            match = (seen & all) == all;
+        }
+        if (match) entries.push_back(i);
+    }
+    return entries.get_size();
+}
+
+struct TextHitBefore {
+    bool operator()(const TextHit& a, const TextHit& b) const {
+        return a.score > b.score || (a.score == b.score && a.entry < b.entry);
+    }
+};
+
+// Scores every entry with any of the query terms by BM25, with document
+// frequencies, entry lengths and term frequencies all counted here from
+// the titles and abstracts. Contributions are summed in the order top_k
+// uses (ascending upper bound, then query order) so scores match exactly.
+// Appends the k best to hits and every matching entry to any.
+static void scan_text_ranking(const BibDatabase& database, const MyStringView& query, unsigned int k,
+                              MyVector<TextHit>& hits, MyVector<unsigned long>& any) {
+    MyVector<MyString> terms;
+    TextTokenizer tokens(query);
+    char term[TextTokenizer::MAX_TERM_LENGTH];
+    unsigned int length;
+    for (unsigned int read = 0; read < TextIndex::MAX_QUERY_TERMS && (length = tokens.next(term)) > 0; read++) {
+        bool repeated = false;
+        for (unsigned long t = 0; t < terms.get_size() && !repeated; t++) {
+            repeated = terms[t].length() == length && memcmp(terms[t].c_str(), term, length) == 0;
+        }
+        if (!repeated) terms.push_back(MyString(term, length));
+    }
+    unsigned long count = terms.get_size();
+    if (count == 0 || database.empty()) return;
+
+    unsigned long entry_frequency[TextIndex::MAX_QUERY_TERMS] = {0};
+    unsigned long total_length = 0;
+    MyVector<unsigned int> marks;
+    for (unsigned long i = 0; i < database.size(); i++) {
+        unsigned long marked = mark_text_tokens(database.get_entry(i), terms, marks);
+        total_length += marked - 1;     // Not the title/abstract gap
+        unsigned int seen = 0;
+        for (unsigned long p = 0; p < marked; p++) seen |= marks[p];
+        for (unsigned long t = 0; t < count; t++) {
+            if (seen & (1U << t)) entry_frequency[t]++;
+        }
+    }
+
+    double entries = (double)database.size();
+    double weights[TextIndex::MAX_QUERY_TERMS], bounds[TextIndex::MAX_QUERY_TERMS];
+    unsigned long order[TextIndex::MAX_QUERY_TERMS];
+    for (unsigned long t = 0; t < count; t++) {
+        double frequency = (double)entry_frequency[t];
+        weights[t] = log(1.0 + (entries - frequency + 0.5) / (frequency + 0.5));
+        bounds[t] = weights[t] * (TextIndex::BM25_K1 + 1.0);
+        unsigned long j = t;
+        for (; j > 0 && bounds[t] < bounds[order[j - 1]]; j--) order[j] = order[j - 1];
+        order[j] = t;
+    }
+    double average_length = total_length > 0 ? (double)total_length / entries : 1.0;
+
+    MyVector<TextHit> scored;
+    unsigned long frequencies[TextIndex::MAX_QUERY_TERMS];
+    for (unsigned long i = 0; i < database.size(); i++) {
+        unsigned long marked = mark_text_tokens(database.get_entry(i), terms, marks);
+        bool found = false;
+        for (unsigned long t = 0; t < count; t++) {
+            frequencies[t] = 0;
+            for (unsigned long p = 0; p < marked; p++) {
+                if (marks[p] & (1U << t)) frequencies[t]++;
+            }
+            found = found || (frequencies[t] > 0 && entry_frequency[t] > 0);
+        }
+        if (!found) continue;
+
+        double length_norm = TextIndex::BM25_K1 * (1.0 - TextIndex::BM25_B + TextIndex::BM25_B *
+                             (unsigned int)(marked - 1) / average_length);
+        double score = 0.0;
+        for (unsigned long o = 0; o < count; o++) {
+            double frequency = (double)frequencies[order[o]];
+            if (frequency > 0) score += weights[order[o]] * frequency * (TextIndex::BM25_K1 + 1.0) / (frequency + length_norm);
+        }
+        TextHit hit = {i, score};
+        scored.push_back(hit);
+        any.push_back(i);
+    }
+
+    scored.sort(TextHitBefore());
+    for (unsigned long h = 0; h < scored.get_size() && h < k; h++) hits.push_back(scored[h]);
+}
+
+static bool same_positions(const MyVector<unsigned long>& a, const MyVector<unsigned long>& b) {
+    if (a.get_size() != b.get_size()) return false;
+    for (unsigned long i = 0; i < a.get_size(); i++) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+// Microseconds per call of one index query, over enough calls to time
+static double time_text_query(const TextIndex& index, const MyString& query, int kind, unsigned long& matches) {
+    BenchTimer timer;
+    unsigned long calls = 0;
+    do {
+        MyVector<unsigned long> entries;
+        MyVector<TextHit> hits;
+        if (kind == 0) matches = index.find_all(query, entries);
+        else if (kind == 1) matches = index.find_any(query, entries);
+        else if (kind == 2) matches = index.find_phrase(query, entries);
+        else matches = index.top_k(query, 10, hits);
+        calls++;
+    } while (calls < 1000 && timer.elapsed_seconds() < 0.2);
+    return timer.elapsed_seconds() * 1e6 / calls;
+}
+
+int bench_text(const char* source, const char* query) {
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    bool synthetic = source[0] >= '0' && source[0] <= '9';
+    BenchTimer timer;
+    if (synthetic) {
+        make_text_database(database, parse_number(source));
+    } else if (!database.load_from_file(MyString(source))) {
+        printf("Error: Failed to load %s\n", source);
+        return 1;
+    }
+    double load_seconds = timer.elapsed_seconds();
+
+    TextIndex index;
+    timer.reset();
+    index.build(database, 1);
+    double build_seconds = timer.elapsed_seconds();
+    int threads = online_cpu_count();
+    double parallel_seconds = build_seconds;
+    if (threads > 1) {
+        timer.reset();
+        index.build(database, threads);
+        parallel_seconds = timer.elapsed_seconds();
+    }
+
+    MyString index_name = synthetic ? MyString("/tmp/bib-bench-text.idx") : MyString(source) + MyString(".idx");
+    SourceStamp stamp;
+    timer.reset();
+    bool saved = index.save(index_name.c_str(), stamp);
+    double save_seconds = timer.elapsed_seconds();
+    TextIndex loaded;
+    timer.reset();
+    bool reloaded = loaded.load(index_name.c_str(), nullptr);
+    double reload_seconds = timer.elapsed_seconds();
+
+    printf("=== Full-text index: %s (%lu entries, %s in %.2f s) ===\n", synthetic ? "synthetic" : source,
+           database.size(), synthetic ? "generated" : "parsed", load_seconds);
+    printf("terms %lu, index %.1f MB (%.1f bytes/entry)\n", index.get_term_count(), index.get_size() / 1e6,
+           database.empty() ? 0.0 : (double)index.get_size() / database.size());
+    printf("build %.3f s on 1 thread, %.3f s on %d; save %.3f s, load %.4f s (%s)\n", build_seconds,
+           parallel_seconds, threads, save_seconds, reload_seconds, saved && reloaded ? "ok" : "FAILED");
+
+    // Default queries: a rare term, frequent pairs and a phrase from the data
+    MyVector<MyString> queries;
+    if (query) {
+        queries.push_back(MyString(query));
+    } else if (synthetic) {
+        char a[32], b[32], c[32], text[128];
+        static const unsigned long picks[][3] = { {20000, 0, 0}, {0, 1, 0}, {30, 300, 0}, {3, 40, 900} };
+        for (int q = 0; q < 4; q++) {
+            make_text_word(picks[q][0], a);
+            make_text_word(picks[q][1], b);
+            make_text_word(picks[q][2], c);
+            if (q == 0) snprintf(text, sizeof(text), "%s", a);
+            else if (q < 3) snprintf(text, sizeof(text), "%s %s", a, b);
+            else snprintf(text, sizeof(text), "%s %s %s", a, b, c);
+            queries.push_back(MyString(text));
+        }
+    }
+    if (!query && !database.empty()) {
+        MyVector<MyString> words;
+        TextTokenizer tokens(database.get_entry(database.size() / 2).get_title());
+        char term[TextTokenizer::MAX_TERM_LENGTH];
+        unsigned int length;
+        while (words.get_size() < 2 && (length = tokens.next(term)) > 0) words.push_back(MyString(term, length));
+        if (words.get_size() == 2) queries.push_back(words[0] + MyString(" ") + words[1]);
+        if (!synthetic && !words.empty()) queries.push_back(words[0]);
+    }
+
+    printf("%-24s %8s %10s %10s %10s %10s %10s %6s\n", "query", "AND", "scan ms", "AND us", "OR us",
+           "phrase us", "top10 us", "same");
+    bool all_same = saved && reloaded;
+    for (unsigned long q = 0; q < queries.get_size(); q++) {
+        const MyString& text = queries[q];
+        MyVector<unsigned long> scanned, scanned_phrase, scanned_any, found, found_phrase, found_any;
+        timer.reset();
+        scan_text_query(database, text, false, scanned);
+        double scan_ms = timer.elapsed_seconds() * 1e3;
+        scan_text_query(database, text, true, scanned_phrase);
+        index.find_all(text, found);
+        loaded.find_phrase(text, found_phrase);
+        index.find_any(text, found_any);
+
+        // Pruned ranking must agree with BM25 computed from the text itself
+        MyVector<TextHit> top, reference;
+        index.top_k(text, 10, top);
+        scan_text_ranking(database, text, 10, reference, scanned_any);
+        bool same = same_positions(scanned, found) && same_positions(scanned_phrase, found_phrase) &&
+                    same_positions(scanned_any, found_any) && top.get_size() == reference.get_size();
+        for (unsigned long h = 0; h < top.get_size() && same; h++) {
+            same = top[h].entry == reference[h].entry && top[h].score == reference[h].score;
+        }
+        all_same = all_same && same;
+
+        unsigned long matches;
+        double and_us = time_text_query(index, text, 0, matches);
+        double or_us = time_text_query(index, text, 1, matches);
+        double phrase_us = time_text_query(index, text, 2, matches);
+        double top_us = time_text_query(index, text, 3, matches);
+        printf("%-24.24s %8lu %10.2f %10.1f %10.1f %10.1f %10.1f %6s\n", text.c_str(), scanned.get_size(),
+               scan_ms, and_us, or_us, phrase_us, top_us, same ? "yes" : "NO");
+    }
+
+    return all_same ? 0 : 1;
+}
+
+// Without an index, every author of every entry is normalized and compared
+static unsigned long scan_author(const BibDatabase& database, const MyString& key,
+                                 MyVector<unsigned long>& positions) {
+    for (unsigned long i = 0; i < database.size(); i++) {
+        const BibEntry& entry = database.get_entry(i);
+        for (int a = 0; a < entry.get_author_count(); a++) {
+            if (AuthorIndex::normalize(entry.get_author(a).get_name()) == key) {
+                positions.push_back(i);
+                break;
+            }
+        }
+    }
+    return positions.get_size();
+}
+
+static bool same_top_authors(const BibDatabase& a, const BibDatabase& b, unsigned int k) {
+    MyVector<AuthorCount> first, second;
+    a.top_authors(k, first);
+    b.top_authors(k, second);
+    if (first.get_size() != second.get_size()) return false;
+    for (unsigned long i = 0; i < first.get_size(); i++) {
+        if (first[i].key != second[i].key || first[i].entry_count != second[i].entry_count) return false;
+    }
+    return true;
+}
+
+int bench_authors(const char* filename) {
+    static const int REPEATS = 1000;
+    static const unsigned long EDITS = 200;
+
+    BibDatabase database("Benchmark");
+    database.set_verbose(false);
+    if (!database.load_from_file(MyString(filename))) {
+        printf("Error: Failed to load %s\n", filename);
+        return 1;
+    }
+
+    // The first author of entries spread over the file, spelled as written there
+    MyVector<MyString> names;
+    for (unsigned long i = 0; i < 4 && !database.empty(); i++) {
+        const BibEntry& entry = database.get_entry(i * (database.size() - 1) / 3);
+        if (entry.get_author_count() > 0) names.push_back(entry.get_author(0).get_name());
+    }
+
+    printf("=== Author index: %s (%lu entries) ===\n", filename, database.size());
+    BenchTimer timer;
+    MyVector<AuthorCount> top;
+    database.top_authors(10, top);
+    printf("index build (first query):  %10.3f ms\n", timer.elapsed_seconds() * 1e3);
+    printf("%-36s %8s %12s %12s %6s\n", "author", "entries", "scan ms", "indexed us", "same");
+
+    bool all_same = true;
+    for (unsigned long n = 0; n < names.get_size(); n++) {
+        MyString key = AuthorIndex::normalize(names[n]);
+        MyVector<unsigned long> scanned, indexed;
+        timer.reset();
+        scan_author(database, key, scanned);
+        double scan_ms = timer.elapsed_seconds() * 1e3;
+
+        timer.reset();
+        for (int r = 0; r < REPEATS; r++) {
+            indexed.clear();
+            database.find_by_author(names[n], indexed);
+        }
+        double indexed_us = timer.elapsed_seconds() * 1e6 / REPEATS;
+
+        bool same = scanned.get_size() == indexed.get_size();
+        for (unsigned long i = 0; same && i < indexed.get_size(); i++) same = indexed[i] == scanned[i];
+        all_same = all_same && same;
+        printf("%-36s %8lu %12.3f %12.3f %6s\n", names[n].c_str(), indexed.get_size(), scan_ms, indexed_us,
+               same ? "yes" : "NO");
+    }
+
+    timer.reset();
+    for (int r = 0; r < 10; r++) {
+        top.clear();
+        database.top_authors(10, top);
+    }
+    printf("top 10 authors:             %10.3f ms\n", timer.elapsed_seconds() * 1e3 / 10);
+
+    // Edits update the index in place; it must match one built from scratch.
+    // The first add after a load grows the entry vector, so it is not timed.
+    char key[48];
+    for (unsigned long i = 0; i <= EDITS && !database.empty(); i++) {
+        if (i == 1) timer.reset();
+        BibEntry copy = database.get_entry(i * 7919 % database.size());
+        snprintf(key, sizeof(key), "author-bench-%lu", i);
+        copy.set_entry_key(MyString(key));
+        database.add_entry(my_move(copy));
+    }
+    double add_us = timer.elapsed_seconds() * 1e6 / EDITS;
+    timer.reset();
+    for (unsigned long i = 0; i < EDITS; i += 2) {
+        snprintf(key, sizeof(key), "author-bench-%lu", i);
+        database.remove_entry(MyString(key));
+    }
+    double remove_ms = timer.elapsed_seconds() * 1e3 / (EDITS / 2);
+    printf("add_entry with index:       %10.3f us\n", add_us);
+    printf("remove_entry with index:    %10.3f ms\n", remove_ms);
+
+    BibDatabase rebuilt(database);  // Copies start without an author index
+    bool incremental = same_top_authors(database, rebuilt, 50);
+    for (unsigned long n = 0; n < names.get_size(); n++) {
+        if (database.count_by_author(names[n]) != rebuilt.count_by_author(names[n])) incremental = false;
+    }
+    printf("incremental index matches a rebuild: %s\n", incremental ? "yes" : "NO");
+
+    return all_same && incremental ? 0 : 1;
+}
@@ -0,0 +1,417 @@
+// bibcolumns.cpp - Implementation of the column-oriented database snapshot
+#include "bibcolumns.h"
+#include "institutematcher.h"
+
+static const char* KIND_NAMES[BibColumns::KIND_COUNT] = {
+    "article", "inproceedings", "incollection", "book", "phdthesis",
+    "mastersthesis", "techreport", "misc", "other"
+};
+
+// Field names passed to BibEntry::set_field for cold fields without a setter
+static const char* COLD_FIELD_NAMES[] = {
+    "", "", "", "", "", "", "", "", "", "abbr", "pages", "volume", "number", "publisher", "address"
+};
+
+// Writes value in decimal; returns the length
+static unsigned long format_year(int value, char* buffer) {
+    char digits[16];
+    unsigned long n = 0;
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    unsigned long length = 0;
+    if (value < 0) buffer[length++] = '-';
+    while (n > 0) buffer[length++] = digits[--n];
+    return length;
+}
+
+// Id of the author's name in pool, or NO_ID if the name is not one of its
+// nodes (empty, or set on the entry after it was added)
+static unsigned int pooled_name_id(const InternPool& pool, const Author& author) {
+    unsigned int id = author.get_interned_name().get_id();
+    if (id < pool.size() && &pool.get(id) == &author.get_name()) return id;
+    return InternedString::NO_ID;
+}
+
+// Constructors
+BibColumns::BibColumns()
+    : entry_count(0), author_slot_count(0), years(nullptr), kinds(nullptr),
+      author_offsets(nullptr), author_name_ids(nullptr), name_count(0),
+      cold_offsets(nullptr), cold_fields(nullptr), cold_text(nullptr) {
+    keys.text = titles.text = affiliations.text = names.text = nullptr;
+    keys.offsets = titles.offsets = affiliations.offsets = names.offsets = nullptr;
+}
+
+BibColumns::BibColumns(const BibDatabase& database)
+    : entry_count(0), author_slot_count(0), years(nullptr), kinds(nullptr),
+      author_offsets(nullptr), author_name_ids(nullptr), name_count(0),
+      cold_offsets(nullptr), cold_fields(nullptr), cold_text(nullptr) {
+    keys.text = titles.text = affiliations.text = names.text = nullptr;
+    keys.offsets = titles.offsets = affiliations.offsets = names.offsets = nullptr;
+    build(database);
+}
+
+// Destructor
+BibColumns::~BibColumns() {
+    clear();
+}
+
+// Column helpers
+MyStringView BibColumns::column_view(const TextColumn& column, unsigned long index) {
+    return MyStringView(column.text + column.offsets[index],
+                        column.offsets[index + 1] - column.offsets[index]);
+}
+
+bool BibColumns::allocate_column(TextColumn& column, unsigned long count, unsigned long bytes) {
+    column.text = (char*)malloc(bytes > 0 ? bytes : 1);
+    column.offsets = (unsigned long*)malloc(sizeof(unsigned long) * (count + 1));
+    if (column.offsets) column.offsets[0] = 0;
+    return column.text && column.offsets;
+}
+
+void BibColumns::free_column(TextColumn& column) {
+    if (column.text) free(column.text);
+    if (column.offsets) free(column.offsets);
+    column.text = nullptr;
+    column.offsets = nullptr;
+}
+
+MyStringView BibColumns::cold_view(const ColdField& field) const {
+    return MyStringView(cold_text + field.offset, field.length);
+}
+
+// Records one cold field; with fields null it only counts
+void BibColumns::put_cold_field(ColdField* fields, char* text, unsigned long& count,
+                                unsigned long& text_bytes, unsigned long id, const MyString& value) {
+    if (fields) {
+        fields[count].field = id;
+        fields[count].offset = text_bytes;
+        fields[count].length = value.length();
+        memcpy(text + text_bytes, value.c_str(), value.length());
+    }
+    count++;
+    text_bytes += value.length();
+}
+
+// Lists the fields of entry that have no hot column. Returns their count
+// and advances text_bytes past their text; fills fields and text unless
+// fields is null.
+unsigned long BibColumns::gather_cold_fields(const BibEntry& entry, ColdField* fields, char* text,
+                                             unsigned long& text_bytes) {
+    unsigned long count = 0;
+
+    if (kind_from_type(entry.get_entry_type()) == KIND_OTHER && !entry.get_entry_type().empty()) {
+        put_cold_field(fields, text, count, text_bytes, COLD_TYPE, entry.get_entry_type());
+    }
+
+    // The year column holds the value; keep the text only if it differs
+    const MyString& year = entry.get_year();
+    if (!year.empty()) {
+        char buffer[16];
+        unsigned long length = format_year(entry.get_year_as_int(), buffer);
+        if (length != year.length() || memcmp(buffer, year.c_str(), length) != 0) {
+            put_cold_field(fields, text, count, text_bytes, COLD_YEAR, year);
+        }
+    }
+
+    const MyString* values[] = {
+        &entry.get_booktitle(), &entry.get_journal(), &entry.get_doi(), &entry.get_abstract(),
+        &entry.get_pdf_url(), &entry.get_code_url(), &entry.get_ppt_url(), &entry.get_abbr(),
+        &entry.get_pages(), &entry.get_volume(), &entry.get_number(), &entry.get_publisher(),
+        &entry.get_address()
+    };
+    for (unsigned long i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        if (!values[i]->empty()) {
+            put_cold_field(fields, text, count, text_bytes, COLD_BOOKTITLE + i, *values[i]);
+        }
+    }
+
+    for (int i = 0; i < entry.get_extra_field_count(); i++) {
+        const BibEntry::ExtraField& extra = entry.get_extra_field(i);
+        put_cold_field(fields, text, count, text_bytes, COLD_EXTRA_NAME, extra.name);
+        put_cold_field(fields, text, count, text_bytes, COLD_EXTRA_VALUE, extra.value);
+    }
+    return count;
+}
+
+// Building
+bool BibColumns::build(const BibDatabase& database) {
+    clear();
+
+    // Author names are numbered by first appearance; the database's intern
+    // pool ids make the de-duplication a table lookup
+    const InternPool& pool = database.get_intern_pool();
+    unsigned long pool_size = pool.size();
+    unsigned int* name_map = (unsigned int*)malloc(sizeof(unsigned int) * (pool_size > 0 ? pool_size : 1));
+    if (!name_map) return false;
+    for (unsigned long i = 0; i < pool_size; i++) name_map[i] = InternedString::NO_ID;
+
+    // Pass 1: sizes
+    unsigned long count = database.size();
+    unsigned long key_bytes = 0, title_bytes = 0, slots = 0, affiliation_bytes = 0;
+    unsigned long name_bytes = 0, names_found = 0, cold_count = 0, cold_bytes = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        const BibEntry& entry = database.get_entry(i);
+        key_bytes += entry.get_entry_key().length();
+        title_bytes += entry.get_title().length();
+        cold_count += gather_cold_fields(entry, nullptr, nullptr, cold_bytes);
+
+        for (int a = 0; a < entry.get_author_count(); a++) {
+            const Author& author = entry.get_author(a);
+            affiliation_bytes += author.get_affiliation().length();
+            slots++;
+
+            // Names outside the pool get a names slot each
+            unsigned int id = pooled_name_id(pool, author);
+            if (id == InternedString::NO_ID || name_map[id] == InternedString::NO_ID) {
+                if (id != InternedString::NO_ID) name_map[id] = (unsigned int)names_found;
+                names_found++;
+                name_bytes += author.get_name().length();
+            }
+        }
+    }
+
+    // Allocate every column at its final size
+    years = (int*)malloc(sizeof(int) * (count > 0 ? count : 1));
+    kinds = (unsigned char*)malloc(count > 0 ? count : 1);
+    author_offsets = (unsigned long*)malloc(sizeof(unsigned long) * (count + 1));
+    author_name_ids = (unsigned int*)malloc(sizeof(unsigned int) * (slots > 0 ? slots : 1));
+    cold_offsets = (unsigned long*)malloc(sizeof(unsigned long) * (count + 1));
+    cold_fields = (ColdField*)malloc(sizeof(ColdField) * (cold_count > 0 ? cold_count : 1));
+    cold_text = (char*)malloc(cold_bytes > 0 ? cold_bytes : 1);
+    bool allocated = allocate_column(keys, count, key_bytes) &&
+                     allocate_column(titles, count, title_bytes) &&
+                     allocate_column(affiliations, slots, affiliation_bytes) &&
+                     allocate_column(names, names_found, name_bytes);
+    if (!allocated || !years || !kinds || !author_offsets || !author_name_ids ||
+        !cold_offsets || !cold_fields || !cold_text) {
+        free(name_map);
+        clear();
+        return false;
+    }
+
+    // Pass 2: fill
+    unsigned long slot = 0, cold_index = 0, cold_position = 0;
+    author_offsets[0] = 0;
+    cold_offsets[0] = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        const BibEntry& entry = database.get_entry(i);
+        years[i] = entry.get_year_as_int();
+        kinds[i] = (unsigned char)kind_from_type(entry.get_entry_type());
+
+        const MyString& key = entry.get_entry_key();
+        memcpy(keys.text + keys.offsets[i], key.c_str(), key.length());
+        keys.offsets[i + 1] = keys.offsets[i] + key.length();
+
+        const MyString& title = entry.get_title();
+        memcpy(titles.text + titles.offsets[i], title.c_str(), title.length());
+        titles.offsets[i + 1] = titles.offsets[i] + title.length();
+
+        for (int a = 0; a < entry.get_author_count(); a++) {
+            const Author& author = entry.get_author(a);
+            unsigned int id = pooled_name_id(pool, author);
+            unsigned int name_index = id == InternedString::NO_ID ? (unsigned int)name_count : name_map[id];
+            author_name_ids[slot] = name_index;
+
+            // First use of a name: append it to the names column
+            if (name_index == name_count) {
+                const MyString& name = author.get_name();
+                memcpy(names.text + names.offsets[name_count], name.c_str(), name.length());
+                names.offsets[name_count + 1] = names.offsets[name_count] + name.length();
+                name_count++;
+            }
+
+            const MyString& affiliation = author.get_affiliation();
+            memcpy(affiliations.text + affiliations.offsets[slot], affiliation.c_str(), affiliation.length());
+            affiliations.offsets[slot + 1] = affiliations.offsets[slot] + affiliation.length();
+            slot++;
+        }
+        author_offsets[i + 1] = slot;
+
+        cold_index += gather_cold_fields(entry, cold_fields + cold_index, cold_text, cold_position);
+        cold_offsets[i + 1] = cold_index;
+    }
+
+    free(name_map);
+    entry_count = count;
+    author_slot_count = slots;
+    return true;
+}
+
+void BibColumns::clear() {
+    if (years) free(years);
+    if (kinds) free(kinds);
+    if (author_offsets) free(author_offsets);
+    if (author_name_ids) free(author_name_ids);
+    if (cold_offsets) free(cold_offsets);
+    if (cold_fields) free(cold_fields);
+    if (cold_text) free(cold_text);
+    years = nullptr;
+    kinds = nullptr;
+    author_offsets = nullptr;
+    author_name_ids = nullptr;
+    cold_offsets = nullptr;
+    cold_fields = nullptr;
+    cold_text = nullptr;
+
+    free_column(keys);
+    free_column(titles);
+    free_column(affiliations);
+    free_column(names);
+
+    entry_count = 0;
+    author_slot_count = 0;
+    name_count = 0;
+}
+
+unsigned long BibColumns::size() const {
+    return entry_count;
+}
+
+// Hot column accessors
+int BibColumns::get_year(unsigned long index) const {
+    return index < entry_count ? years[index] : 0;
+}
+
+BibColumns::EntryKind BibColumns::get_kind(unsigned long index) const {
+    return index < entry_count ? (EntryKind)kinds[index] : KIND_OTHER;
+}
+
+MyStringView BibColumns::get_key(unsigned long index) const {
+    return index < entry_count ? column_view(keys, index) : MyStringView();
+}
+
+MyStringView BibColumns::get_title(unsigned long index) const {
+    return index < entry_count ? column_view(titles, index) : MyStringView();
+}
+
+unsigned long BibColumns::get_author_count(unsigned long index) const {
+    return index < entry_count ? author_offsets[index + 1] - author_offsets[index] : 0;
+}
+
+MyStringView BibColumns::get_author_name(unsigned long index, unsigned long author) const {
+    if (author >= get_author_count(index)) return MyStringView();
+    return column_view(names, author_name_ids[author_offsets[index] + author]);
+}
+
+const int* BibColumns::get_years() const {
+    return years;
+}
+
+const unsigned char* BibColumns::get_kinds() const {
+    return kinds;
+}
+
+// Scans
+// counts must hold last_year - first_year + 1 elements; other years are skipped
+void BibColumns::count_by_year(unsigned long* counts, int first_year, int last_year) const {
+    if (last_year < first_year) return;
+    unsigned long span = (unsigned long)(last_year - first_year) + 1;
+    for (unsigned long i = 0; i < span; i++) counts[i] = 0;
+
+    for (unsigned long i = 0; i < entry_count; i++) {
+        unsigned long offset = (unsigned long)(years[i] - first_year);
+        if (offset < span) counts[offset]++;
+    }
+}
+
+unsigned long BibColumns::count_kind(EntryKind kind) const {
+    unsigned long count = 0;
+    for (unsigned long i = 0; i < entry_count; i++) {
+        count += kinds[i] == (unsigned char)kind;
+    }
+    return count;
+}
+
+// Each distinct name is matched once; the author table is then a pass
+// over 32-bit name indexes
+int BibColumns::count_institute_authors(const MyString& institute_name) const {
+    if (institute_name.empty() || author_slot_count == 0) return 0;
+
+    InstituteMatcher institute(institute_name);
+
+    bool* name_matches = (bool*)malloc(name_count > 0 ? name_count : 1);
+    if (!name_matches) return 0;
+    for (unsigned long i = 0; i < name_count; i++) {
+        name_matches[i] = institute.matches(column_view(names, i));
+    }
+
+    int total = 0;
+    for (unsigned long slot = 0; slot < author_slot_count; slot++) {
+        if (name_matches[author_name_ids[slot]] ||
+            (affiliations.offsets[slot + 1] != affiliations.offsets[slot] &&
+             institute.matches(column_view(affiliations, slot)))) {
+            total++;
+        }
+    }
+
+    free(name_matches);
+    return total;
+}
+
+// Materialization
+BibEntry BibColumns::materialize(unsigned long index) const {
+    if (index >= entry_count) return BibEntry();
+
+    BibEntry entry(column_view(keys, index).to_string());
+    if (kinds[index] != KIND_OTHER) {
+        entry.set_entry_type(MyString(KIND_NAMES[kinds[index]]));
+    }
+    if (titles.offsets[index + 1] != titles.offsets[index]) {
+        entry.set_title(column_view(titles, index).to_string());
+    }
+    if (years[index] != 0) {
+        char buffer[16];
+        unsigned long length = format_year(years[index], buffer);
+        entry.set_year(MyString(buffer, length));   // A cold year below overrides this
+    }
+
+    for (unsigned long slot = author_offsets[index]; slot < author_offsets[index + 1]; slot++) {
+        Author author(column_view(names, author_name_ids[slot]).to_string());
+        if (affiliations.offsets[slot + 1] != affiliations.offsets[slot]) {
+            author.set_affiliation(column_view(affiliations, slot).to_string());
+        }
+        entry.add_author(my_move(author));
+    }
+
+    for (unsigned long f = cold_offsets[index]; f < cold_offsets[index + 1]; f++) {
+        const ColdField& field = cold_fields[f];
+        MyString value = cold_view(field).to_string();
+        switch (field.field) {
+        case COLD_TYPE:      entry.set_entry_type(value); break;
+        case COLD_YEAR:      entry.set_year(value); break;
+        case COLD_BOOKTITLE: entry.set_booktitle(value); break;
+        case COLD_JOURNAL:   entry.set_journal(value); break;
+        case COLD_DOI:       entry.set_doi(value); break;
+        case COLD_ABSTRACT:  entry.set_abstract(value); break;
+        case COLD_PDF:       entry.set_pdf_url(value); break;
+        case COLD_CODE:      entry.set_code_url(value); break;
+        case COLD_PPT:       entry.set_ppt_url(value); break;
+        case COLD_EXTRA_NAME: {
+            // The value always follows its name
+            f++;
+            entry.set_extra_field(value, cold_view(cold_fields[f]).to_string());
+            break;
+        }
+        default:
+            entry.set_field(MyString(COLD_FIELD_NAMES[field.field]), my_move(value));
+            break;
+        }
+    }
+    return entry;
+}
+
+// Entry type names
+const char* BibColumns::kind_name(EntryKind kind) {
+    return kind >= 0 && kind < KIND_COUNT ? KIND_NAMES[kind] : KIND_NAMES[KIND_OTHER];
+}
+
+BibColumns::EntryKind BibColumns::kind_from_type(const MyString& entry_type) {
+    for (int kind = 0; kind < KIND_OTHER; kind++) {
+        if (MyString::strcmp(entry_type.c_str(), KIND_NAMES[kind]) == 0) return (EntryKind)kind;
+    }
+    return KIND_OTHER;
+}
@@ -0,0 +1,113 @@
+// bibcolumns.h - Column-oriented snapshot of a BibDatabase for analytic scans
+#ifndef BIBCOLUMNS_H
+#define BIBCOLUMNS_H
+
+#include "bibdatabase.h"
+
+// Read-only structure-of-arrays copy of a database. The fields scans look
+// at (year, type, key, title, authors) live in separate contiguous arrays,
+// so a pass over one of them touches nothing else. Every other field is
+// kept in a cold section that only materialize() reads; it rebuilds an
+// equal BibEntry on demand.
+class BibColumns {
+public:
+    // Entry types with a dedicated code; anything else is KIND_OTHER
+    enum EntryKind {
+        KIND_ARTICLE, KIND_INPROCEEDINGS, KIND_INCOLLECTION, KIND_BOOK, KIND_PHDTHESIS,
+        KIND_MASTERSTHESIS, KIND_TECHREPORT, KIND_MISC, KIND_OTHER, KIND_COUNT
+    };
+
+private:
+    // Strings stored back to back: string i is text[offsets[i], offsets[i + 1])
+    struct TextColumn {
+        char* text;
+        unsigned long* offsets;
+    };
+
+    // Fields outside the hot columns, in the order materialize() applies them
+    enum ColdFieldId {
+        COLD_TYPE, COLD_YEAR, COLD_BOOKTITLE, COLD_JOURNAL, COLD_DOI, COLD_ABSTRACT,
+        COLD_PDF, COLD_CODE, COLD_PPT, COLD_ABBR, COLD_PAGES, COLD_VOLUME, COLD_NUMBER,
+        COLD_PUBLISHER, COLD_ADDRESS,
+        COLD_EXTRA_NAME, COLD_EXTRA_VALUE       // Always in pairs
+    };
+
+    struct ColdField {
+        unsigned long field;    // ColdFieldId
+        unsigned long offset;   // Into cold_text
+        unsigned long length;
+    };
+
+    unsigned long entry_count;
+    unsigned long author_slot_count;
+
+    // Hot columns, one element per entry
+    int* years;                     // 0 when the year is missing
+    unsigned char* kinds;           // EntryKind
+    TextColumn keys;
+    TextColumn titles;
+    unsigned long* author_offsets;  // Entry i owns slots [author_offsets[i], author_offsets[i + 1])
+
+    // Flat author table, one element per author slot
+    unsigned int* author_name_ids;  // Index into names
+    TextColumn affiliations;
+
+    // Distinct author names
+    TextColumn names;
+    unsigned long name_count;
+
+    // Cold section
+    unsigned long* cold_offsets;    // Entry i owns fields [cold_offsets[i], cold_offsets[i + 1])
+    ColdField* cold_fields;
+    char* cold_text;
+
+    static MyStringView column_view(const TextColumn& column, unsigned long index);
+    static bool allocate_column(TextColumn& column, unsigned long count, unsigned long bytes);
+    static void free_column(TextColumn& column);
+    static void put_cold_field(ColdField* fields, char* text, unsigned long& count,
+                               unsigned long& text_bytes, unsigned long id, const MyString& value);
+    static unsigned long gather_cold_fields(const BibEntry& entry, ColdField* fields, char* text,
+                                            unsigned long& text_bytes);
+    MyStringView cold_view(const ColdField& field) const;
+
+    // Disable copying - the arrays have a single owner
+    BibColumns(const BibColumns& other);
+    BibColumns& operator=(const BibColumns& other);
+
+public:
+    // Constructors
+    BibColumns();
+    explicit BibColumns(const BibDatabase& database);
+
+    // Destructor
+    ~BibColumns();
+
+    // Replaces the contents with a snapshot of database
+    bool build(const BibDatabase& database);
+    void clear();
+    unsigned long size() const;
+
+    // Hot column accessors
+    int get_year(unsigned long index) const;
+    EntryKind get_kind(unsigned long index) const;
+    MyStringView get_key(unsigned long index) const;
+    MyStringView get_title(unsigned long index) const;
+    unsigned long get_author_count(unsigned long index) const;
+    MyStringView get_author_name(unsigned long index, unsigned long author) const;
+    const int* get_years() const;
+    const unsigned char* get_kinds() const;
+
+    // Scans
+    void count_by_year(unsigned long* counts, int first_year, int last_year) const;
+    unsigned long count_kind(EntryKind kind) const;
+    int count_institute_authors(const MyString& institute_name) const; // Same total as BibDatabase's
+
+    // Builds the full entry back from the columns
+    BibEntry materialize(unsigned long index) const;
+
+    // Entry type names
+    static const char* kind_name(EntryKind kind);
+    static EntryKind kind_from_type(const MyString& entry_type);
+};
+
+#endif // BIBCOLUMNS_H
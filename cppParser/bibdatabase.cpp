@@ -1,46 +1,98 @@
 // bibdatabase.cpp - Bibliography database class implementation
 #include "bibdatabase.h"
+#include "secondaryindex.h"
+#include "authorindex.h"
+#include "placement_new.h"
 
-// System calls for file I/O
+// C runtime functions
 extern "C" {
-    int open(const char* path, int flags, ...);
-    int close(int fd);
-    long read(int fd, void* buf, unsigned long count);
-    long write(int fd, const void* buf, unsigned long count);
+    void* memchr(const void* s, int c, unsigned long n);
     int printf(const char* format, ...);
+    int vprintf(const char* format, __builtin_va_list args);
+    int vsnprintf(char* str, unsigned long size, const char* format, __builtin_va_list args);
 }
 
-// File flags
-#ifndef O_RDONLY
-#define O_RDONLY 0
-#endif
-#ifndef O_WRONLY
-#define O_WRONLY 1
-#endif
-#ifndef O_CREAT
-#define O_CREAT 64
-#endif
-#ifndef O_TRUNC
-#define O_TRUNC 512
-#endif
-
 // Constructors
-BibDatabase::BibDatabase() : entries(), database_name("Unnamed Database") {}
-
-BibDatabase::BibDatabase(const MyString& name) : entries(), database_name(name) {}
+BibDatabase::BibDatabase()
+    : string_arena(), arena_enabled(false), entries(), intern_pool(), database_name("Unnamed Database"),
+      verbose(true), thread_count(1), year_index(nullptr), type_index(nullptr), venue_index(nullptr),
+      author_index(nullptr), deferred_messages(nullptr) {}
+
+BibDatabase::BibDatabase(const MyString& name)
+    : string_arena(), arena_enabled(false), entries(), intern_pool(), database_name(name), verbose(true),
+      thread_count(1), year_index(nullptr), type_index(nullptr), venue_index(nullptr),
+      author_index(nullptr), deferred_messages(nullptr) {}
+
+BibDatabase::BibDatabase(const BibDatabase& other)
+    : string_arena(), arena_enabled(other.arena_enabled), entries(), intern_pool(),
+      database_name(other.database_name), verbose(other.verbose), key_index(other.key_index),
+      thread_count(other.thread_count), year_index(nullptr), type_index(nullptr), venue_index(nullptr),
+      author_index(nullptr), deferred_messages(nullptr) {
+    StringArenaScope scope(active_arena());
+    entries = other.entries;
+    intern_all_entries();
+}
 
-BibDatabase::BibDatabase(const BibDatabase& other) : entries(other.entries), database_name(other.database_name) {}
+BibDatabase::BibDatabase(BibDatabase&& other)
+    : string_arena(my_move(other.string_arena)), arena_enabled(other.arena_enabled),
+      entries(my_move(other.entries)), intern_pool(my_move(other.intern_pool)),
+      database_name(my_move(other.database_name)),
+      verbose(other.verbose), key_index(my_move(other.key_index)),
+      thread_count(other.thread_count), year_index(other.year_index), type_index(other.type_index),
+      venue_index(other.venue_index), author_index(other.author_index), deferred_messages(nullptr) {
+    other.year_index = nullptr;
+    other.type_index = nullptr;
+    other.venue_index = nullptr;
+    other.author_index = nullptr;
+}
 
 // Destructor
 BibDatabase::~BibDatabase() {
-    // MyVector destructor handles cleanup
+    // MyVector destructor handles the entries
+    invalidate_indexes();
 }
 
 // Assignment operator
 BibDatabase& BibDatabase::operator=(const BibDatabase& other) {
     if (this != &other) {
+        // Drop the old strings before their arena, then copy into a fresh one
+        invalidate_indexes();
+        entries.clear();
+        string_arena.release();
+        arena_enabled = other.arena_enabled;
+
+        StringArenaScope scope(active_arena());
         entries = other.entries;
+        intern_pool.clear();
+        intern_all_entries();
         database_name = other.database_name;
+        verbose = other.verbose;
+        key_index = other.key_index;
+        thread_count = other.thread_count;
+    }
+    return *this;
+}
+
+BibDatabase& BibDatabase::operator=(BibDatabase&& other) {
+    if (this != &other) {
+        entries = my_move(other.entries);
+        intern_pool = my_move(other.intern_pool);
+        string_arena = my_move(other.string_arena);
+        arena_enabled = other.arena_enabled;
+        database_name = my_move(other.database_name);
+        verbose = other.verbose;
+        key_index = my_move(other.key_index);
+        thread_count = other.thread_count;
+
+        invalidate_indexes();
+        year_index = other.year_index;
+        type_index = other.type_index;
+        venue_index = other.venue_index;
+        author_index = other.author_index;
+        other.year_index = nullptr;
+        other.type_index = nullptr;
+        other.venue_index = nullptr;
+        other.author_index = nullptr;
     }
     return *this;
 }
@@ -55,7 +107,7 @@ BibDatabase BibDatabase::operator+(const BibDatabase& other) const {
 BibDatabase& BibDatabase::operator+=(const BibDatabase& other) {
     for (unsigned long i = 0; i < other.entries.get_size(); i++) {
         const BibEntry& entry = other.entries[i];
-        // Check if entry with same key already exists
+        // Check if entry with same key already exists (constant-time lookup)
         if (find_entry(entry.get_entry_key()) == nullptr) {
             add_entry(entry);
         }
@@ -63,146 +115,576 @@ BibDatabase& BibDatabase::operator+=(const BibDatabase& other) {
     return *this;
 }
 
-// File I/O helper methods
-bool BibDatabase::read_line(int fd, char* buffer, int max_len) {
-    int pos = 0;
-    char c;
+// Parsing helper methods
+// Turns tokenizer events into BibEntry objects stored in a database.
+// In arena mode only the stored strings are built inside the arena; the
+// tokenizer's own growing buffers stay on the heap.
+struct BibDatabase::EntryBuilder : public BibTokenHandler {
+    BibDatabase& database;
+    BibEntry entry;
+    int stored;
+    StringArena* arena;
 
-    while (pos < max_len - 1) {
-        long bytes_read = read(fd, &c, 1);
-        if (bytes_read <= 0) {
-            // End of file or error
-            break;
-        }
+    EntryBuilder(BibDatabase& target)
+        : database(target), entry(), stored(0), arena(target.active_arena()) {}
 
-        if (c == '\n') {
-            // End of line
-            break;
-        }
+    void on_entry_begin(const MyString& type, const MyString& key) {
+        StringArenaScope scope(arena);
+        entry.clear();
+        entry.set_entry_type(type);
+        entry.set_entry_key(key);
+    }
 
-        buffer[pos++] = c;
+    void on_field(const MyString& name, MyString& value) {
+        // Copy into an exact-size buffer (from the arena when enabled); the
+        // tokenizer keeps its geometrically grown buffer for the next value
+        StringArenaScope scope(arena);
+        entry.set_field(name, MyString(value.c_str(), value.length()), &database.intern_pool);
     }
 
-    buffer[pos] = '\0';
-    return pos > 0;
-}
+    void on_entry_end() {
+        if (database.store_parsed_entry(entry)) stored++;
+    }
 
-bool BibDatabase::is_whitespace_line(const MyString& line) {
-    MyString trimmed = line;
-    trimmed.trim();
-    return trimmed.empty();
-}
+    void on_error(const MyString& message) {
+        database.report("Warning: %s\n", message.c_str());
+    }
+};
 
 // File operations
-bool BibDatabase::load_from_file(const MyString& filename) {
+bool BibDatabase::load_from_file(const MyString& filename, LoadMode mode) {
     if (filename.empty()) {
         printf("Error: Empty filename\n");
         return false;
     }
 
-    int fd = open(filename.c_str(), O_RDONLY);
-    if (fd < 0) {
+    // Fall back to buffered reading for inputs that cannot be mapped
+    MappedFile mapped;
+    if (mode == LOAD_MAPPED && !mapped.open(filename.c_str())) {
+        mode = LOAD_BUFFERED;
+    }
+
+    BufferedReader reader;
+    if (mode == LOAD_BUFFERED && !reader.open(filename.c_str())) {
         printf("Error: Cannot open file %s\n", filename.c_str());
         return false;
     }
 
     clear(); // Clear existing entries
 
-    char line_buffer[MAX_LINE_LENGTH];
-    MyString current_line;
+    if (verbose) {
+        printf("Parsing BibTeX file: %s\n", filename.c_str());
+    }
+
     int total_entries = 0;
+    if (mode == LOAD_MAPPED) {
+        if (thread_count > 1) {
+            total_entries = parse_parallel(mapped.get_data(), mapped.size());
+        } else {
+            total_entries = parse_mapped(mapped.get_data(), mapped.size());
+        }
+        mapped.close();
+    } else {
+        total_entries = parse_buffered(reader);
+        reader.close();
+    }
+
+    if (verbose) {
+        printf("\n=== Summary ===\n");
+        printf("Total BibTeX entries processed: %d\n", total_entries);
+    }
+
+    return total_entries > 0;
+}
+
+int BibDatabase::parse_buffered(BufferedReader& reader) {
+    EntryBuilder builder(*this);
+    BibTokenizer tokenizer(&builder);
 
-    printf("Parsing BibTeX file: %s\n", filename.c_str());
+    // Each block goes straight to the tokenizer; no line assembly
+    const char* block;
+    unsigned long length;
+    while (reader.read_block(block, length)) {
+        tokenizer.feed(block, length);
+    }
+    tokenizer.finish();
+
+    return builder.stored;
+}
+
+int BibDatabase::parse_mapped(const char* data, unsigned long length) {
+    if (!data) return 0;
+
+    reserve_for_input(data, length);
+    EntryBuilder builder(*this);
+    BibTokenizer tokenizer(&builder);
+    tokenizer.feed(data, length);
+    tokenizer.finish();
 
-    while (read_line(fd, line_buffer, MAX_LINE_LENGTH)) {
-        current_line = MyString(line_buffer);
+    return builder.stored;
+}
+
+// Entries normally start with '@' at the beginning of a line (after
+// indentation). Counting those with memchr is much cheaper than parsing,
+// and sizes the entry vector and key index so they never grow during the
+// load; '@' signs inside values (emails) rarely start a line.
+static unsigned long count_entry_markers(const char* data, unsigned long length) {
+    const char* end = data + length;
+    unsigned long count = 0;
+    for (const char* cursor = data; cursor < end; ) {
+        const char* at = (const char*)memchr(cursor, '@', end - cursor);
+        if (!at) break;
+        const char* first = at;
+        while (first > data && (first[-1] == ' ' || first[-1] == '\t')) first--;
+        if (first == data || first[-1] == '\n') count++;
+        cursor = at + 1;
+    }
+    return count;
+}
 
-        // Skip empty lines and comments
-        if (is_whitespace_line(current_line)) {
-            continue;
+void BibDatabase::reserve_for_input(const char* data, unsigned long length) {
+    unsigned long expected = entries.get_size() + count_entry_markers(data, length);
+    entries.reserve(expected);
+    key_index.reserve(expected);
+}
+
+// Parallel loading
+// Chunks start at a line beginning with '@' (after indentation), which is
+// where top-level entries normally start. If such a line is really inside
+// a braced value, the chunk before it does not end between entries;
+// parse_parallel notices and parses the file sequentially instead.
+static const char* next_chunk_boundary(const char* from, const char* end) {
+    const char* cursor = from;
+    while (true) {
+        const char* newline = (const char*)memchr(cursor, '\n', end - cursor);
+        if (!newline) return end;
+        cursor = newline + 1;
+
+        const char* first = cursor;
+        while (first < end && (*first == ' ' || *first == '\t')) first++;
+        if (first < end && *first == '@') return cursor;
+    }
+}
+
+struct BibDatabase::ParseChunk {
+    const char* begin;
+    const char* end;
+    BibDatabase database;
+    MyVector<DeferredMessage> messages;
+    int entry_count;
+    bool ended_between_entries;
+    bool defined_macros;
+
+    ParseChunk()
+        : begin(nullptr), end(nullptr), database(), messages(), entry_count(0),
+          ended_between_entries(true), defined_macros(false) {}
+};
+
+void BibDatabase::parse_chunk_task(void* context, unsigned long index) {
+    ParseChunk& chunk = ((ParseChunk*)context)[index];
+    chunk.database.deferred_messages = &chunk.messages;
+
+    chunk.database.reserve_for_input(chunk.begin, chunk.end - chunk.begin);
+    EntryBuilder builder(chunk.database);
+    BibTokenizer tokenizer(&builder);
+    tokenizer.feed(chunk.begin, chunk.end - chunk.begin);
+    chunk.ended_between_entries = tokenizer.finish();
+    chunk.defined_macros = tokenizer.has_macros();
+    chunk.entry_count = builder.stored;
+
+    chunk.database.deferred_messages = nullptr;
+}
+
+int BibDatabase::parse_parallel(const char* data, unsigned long length) {
+    if (!data) return 0;
+
+    // A few chunks per thread so uneven entries balance out, but none tiny
+    static const unsigned long MIN_CHUNK_SIZE = 64 * 1024;
+    unsigned long chunk_count = (unsigned long)thread_count * 4;
+    if (chunk_count > length / MIN_CHUNK_SIZE) chunk_count = length / MIN_CHUNK_SIZE;
+    if (chunk_count < 2) return parse_mapped(data, length);
+
+    ParseChunk* chunks = (ParseChunk*)malloc(sizeof(ParseChunk) * chunk_count);
+    if (!chunks) return parse_mapped(data, length);
+
+    const char* end = data + length;
+    const char* begin = data;
+    unsigned long used = 0;
+    for (unsigned long i = 0; i < chunk_count && begin < end; i++) {
+        const char* chunk_end = end;
+        if (i + 1 < chunk_count) {
+            const char* target = data + length / chunk_count * (i + 1);
+            chunk_end = next_chunk_boundary(target > begin ? target : begin, end);
         }
+        new (&chunks[used]) ParseChunk();
+        chunks[used].begin = begin;
+        chunks[used].end = chunk_end;
+        chunks[used].database.set_verbose(false);
+        chunks[used].database.set_arena_enabled(arena_enabled);
+        used++;
+        begin = chunk_end;
+    }
 
-        // Check if this is the start of a new entry
-        MyString trimmed_line = current_line;
-        trimmed_line.trim();
+    parallel_for(thread_count, used, parse_chunk_task, chunks);
 
-        if (!trimmed_line.empty() && trimmed_line[0] == '@') {
-            // Parse this entry
-            if (parse_bib_entry(fd, current_line)) {
-                total_entries++;
-            }
+    // Every chunk but the last must stop between entries, and @string
+    // macros must not be needed by a later chunk; otherwise start over
+    bool independent = true;
+    for (unsigned long i = 0; i + 1 < used; i++) {
+        if (!chunks[i].ended_between_entries || chunks[i].defined_macros) {
+            independent = false;
+        }
+    }
+    if (!independent) {
+        for (unsigned long i = 0; i < used; i++) {
+            chunks[i].~ParseChunk();
         }
+        free(chunks);
+        return parse_mapped(data, length);
     }
 
-    close(fd);
+    // Concatenate in file order, replaying each chunk's messages where
+    // the sequential parser would have printed them
+    unsigned long total_size = entries.get_size();
+    for (unsigned long i = 0; i < used; i++) {
+        total_size += chunks[i].database.size();
+    }
+    entries.reserve(total_size);
+    key_index.reserve(total_size);
 
-    printf("\n=== Summary ===\n");
-    printf("Total BibTeX entries processed: %d\n", total_entries);
+    int total_entries = 0;
+    for (unsigned long i = 0; i < used; i++) {
+        ParseChunk& chunk = chunks[i];
+        unsigned long next_message = 0;
+        for (unsigned long j = 0; j <= chunk.database.size(); j++) {
+            while (next_message < chunk.messages.get_size() &&
+                   chunk.messages[next_message].position <= j) {
+                printf("%s", chunk.messages[next_message].text.c_str());
+                next_message++;
+            }
+            if (j == chunk.database.size()) break;
 
-    return total_entries > 0;
+            BibEntry& entry = chunk.database.get_entry(j);
+            if (verbose) {
+                printf("Added entry: %s\n", entry.get_entry_key().c_str());
+            }
+            add_entry(my_move(entry));
+        }
+        // The moved strings still live in the chunk's arena blocks
+        string_arena.adopt(chunk.database.string_arena);
+        total_entries += chunk.entry_count;
+        chunk.~ParseChunk();
+    }
+    free(chunks);
+
+    return total_entries;
 }
 
 bool BibDatabase::save_to_file(const MyString& filename) const {
     if (filename.empty()) return false;
 
-    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0) {
+    // Entries are serialized straight into the writer's buffer
+    BufferedWriter writer;
+    if (!writer.open(filename.c_str())) {
         printf("Error: Cannot create file %s\n", filename.c_str());
         return false;
     }
 
     for (unsigned long i = 0; i < entries.get_size(); i++) {
-        MyString entry_str = entries[i].to_string();
-        write(fd, entry_str.c_str(), entry_str.length());
-        write(fd, "\n", 1);
+        entries[i].write_to(writer);
+        writer.put('\n');
     }
 
-    close(fd);
+    if (!writer.close()) {
+        printf("Error: Cannot write file %s\n", filename.c_str());
+        return false;
+    }
     return true;
 }
 
-bool BibDatabase::parse_bib_entry(int fd, MyString& current_line) {
-    BibEntry entry;
+// Snapshots
+struct BibDatabase::SnapshotStrings {
+    static const unsigned long NOT_PLACED = (unsigned long)-1;
+
+    BufferedWriter* blob;       // Null while offsets are only being assigned
+    unsigned long size;
+    const InternPool& pool;
+    unsigned long* pooled;      // Blob offset of each pool string once placed
+
+    explicit SnapshotStrings(const InternPool& intern_pool)
+        : blob(nullptr), size(0), pool(intern_pool), pooled(nullptr) {
+        if (pool.size() > 0) pooled = (unsigned long*)malloc(sizeof(unsigned long) * pool.size());
+        restart(nullptr);
+    }
+
+    ~SnapshotStrings() {
+        if (pooled) free(pooled);
+    }
 
-    // Parse the entry header (@inproceedings{key, etc.)
-    if (!entry.parse_entry_header(current_line)) {
-        printf("Warning: Failed to parse entry header: %s\n", current_line.c_str());
+    void restart(BufferedWriter* writer) {
+        blob = writer;
+        size = 0;
+        if (pooled) {
+            for (unsigned int i = 0; i < pool.size(); i++) pooled[i] = NOT_PLACED;
+        }
+    }
+
+    SnapshotString add(const MyString& text) {
+        SnapshotString placed = {0, 0};
+        if (text.empty()) return placed;
+        placed.offset = size;
+        placed.length = text.length();
+        if (blob) blob->write(text.c_str(), text.length() + 1);
+        size += text.length() + 1;
+        return placed;
+    }
+
+    // Strings of this database's pool are placed once
+    SnapshotString add(const InternedString& text) {
+        unsigned int id = text.get_id();
+        if (!pooled || id >= pool.size() || &pool.get(id) != &text.str()) return add(text.str());
+        if (pooled[id] == NOT_PLACED) {
+            pooled[id] = size;
+            return add(text.str());
+        }
+        SnapshotString placed = {pooled[id], text.length()};
+        return placed;
+    }
+};
+
+bool BibDatabase::write_snapshot_sections(BufferedWriter& writer, SnapshotStrings& strings,
+                                          bool records) const {
+    unsigned long next_author = 0, next_extra = 0;
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        const BibEntry& entry = entries[i];
+        SnapshotEntry record;
+        record.fields[SNAPSHOT_TYPE] = strings.add(entry.get_entry_type());
+        record.fields[SNAPSHOT_KEY] = strings.add(entry.get_entry_key());
+        record.fields[SNAPSHOT_TITLE] = strings.add(entry.get_title());
+        record.fields[SNAPSHOT_YEAR] = strings.add(entry.get_year());
+        record.fields[SNAPSHOT_BOOKTITLE] = strings.add(entry.get_interned_booktitle());
+        record.fields[SNAPSHOT_JOURNAL] = strings.add(entry.get_interned_journal());
+        record.fields[SNAPSHOT_DOI] = strings.add(entry.get_doi());
+        record.fields[SNAPSHOT_ABSTRACT] = strings.add(entry.get_abstract());
+        record.fields[SNAPSHOT_PDF] = strings.add(entry.get_pdf_url());
+        record.fields[SNAPSHOT_CODE] = strings.add(entry.get_code_url());
+        record.fields[SNAPSHOT_PPT] = strings.add(entry.get_ppt_url());
+        record.fields[SNAPSHOT_ABBR] = strings.add(entry.get_abbr());
+        record.fields[SNAPSHOT_PAGES] = strings.add(entry.get_pages());
+        record.fields[SNAPSHOT_VOLUME] = strings.add(entry.get_volume());
+        record.fields[SNAPSHOT_NUMBER] = strings.add(entry.get_number());
+        record.fields[SNAPSHOT_PUBLISHER] = strings.add(entry.get_publisher());
+        record.fields[SNAPSHOT_ADDRESS] = strings.add(entry.get_address());
+        record.first_author = next_author;
+        record.first_extra = next_extra;
+        record.author_count = (unsigned int)entry.get_author_count();
+        record.extra_count = (unsigned int)entry.get_extra_field_count();
+        next_author += record.author_count;
+        next_extra += record.extra_count;
+        if (records) writer.write((const char*)&record, sizeof(record));
+    }
+
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        for (int j = 0; j < entries[i].get_author_count(); j++) {
+            const Author& author = entries[i].get_author(j);
+            SnapshotAuthor record;
+            record.name = strings.add(author.get_interned_name());
+            record.affiliation = strings.add(author.get_affiliation());
+            if (records) writer.write((const char*)&record, sizeof(record));
+        }
+    }
+
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        for (int j = 0; j < entries[i].get_extra_field_count(); j++) {
+            const BibEntry::ExtraField& field = entries[i].get_extra_field(j);
+            SnapshotExtra record;
+            record.name = strings.add(field.name);
+            record.value = strings.add(field.value);
+            if (records) writer.write((const char*)&record, sizeof(record));
+        }
+    }
+
+    return !writer.has_failed();
+}
+
+bool BibDatabase::save_snapshot(const MyString& filename, const SourceStamp& source) const {
+    BufferedWriter writer;
+    if (filename.empty() || !writer.open(filename.c_str())) return false;
+
+    SnapshotHeader header = SnapshotHeader();
+    memcpy(header.magic, "BIBSNAP", 8);
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = sizeof(SnapshotHeader);
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.source = source;
+    header.entry_count = entries.get_size();
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        header.author_count += (unsigned long)entries[i].get_author_count();
+        header.extra_count += (unsigned long)entries[i].get_extra_field_count();
+    }
+    header.entries_offset = sizeof(SnapshotHeader);
+    header.authors_offset = header.entries_offset + header.entry_count * sizeof(SnapshotEntry);
+    header.extras_offset = header.authors_offset + header.author_count * sizeof(SnapshotAuthor);
+    header.blob_offset = header.extras_offset + header.extra_count * sizeof(SnapshotExtra);
+
+    // Placeholder header, rewritten once the blob size is known
+    writer.write((const char*)&header, sizeof(header));
+
+    SnapshotStrings strings(intern_pool);
+    write_snapshot_sections(writer, strings, true);
+    header.blob_size = strings.size;
+    strings.restart(&writer);
+    write_snapshot_sections(writer, strings, false);
+    header.file_size = header.blob_offset + header.blob_size;
+
+    writer.write_at(0, &header, sizeof(header));
+    return writer.close();
+}
+
+// True if count elements of element_size starting at offset fit in size bytes
+static bool snapshot_section_fits(unsigned long offset, unsigned long count, unsigned long element_size,
+                                  unsigned long size) {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / element_size;
+}
+
+// Non-empty strings must end, with room for their terminator, inside the
+// blob. The terminators themselves are not read here, which would fault
+// in every page of the blob; a blob that ends in '\0' bounds every string.
+static bool snapshot_string_fits(const SnapshotString& text, unsigned long blob_size) {
+    return text.length == 0 || (text.offset < blob_size && text.length < blob_size - text.offset);
+}
+
+// Long strings of the loaded entries point into the mapping, which the
+// database's arena keeps until clear(); the private mapping lets them be
+// modified in place like any other string
+bool BibDatabase::load_snapshot(const MyString& filename, const MyString& source_filename) {
+    MappedFile file;
+    if (filename.empty() || !file.open(filename.c_str(), true)) return false;
+
+    const char* data = file.get_data();
+    unsigned long size = file.size();
+    if (!data || size < sizeof(SnapshotHeader)) return false;
+
+    const SnapshotHeader& header = *(const SnapshotHeader*)data;
+    if (memcmp(header.magic, "BIBSNAP", 8) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.header_size != sizeof(SnapshotHeader) || header.byte_order != SNAPSHOT_BYTE_ORDER ||
+        header.file_size != size ||
+        !snapshot_section_fits(header.entries_offset, header.entry_count, sizeof(SnapshotEntry), size) ||
+        !snapshot_section_fits(header.authors_offset, header.author_count, sizeof(SnapshotAuthor), size) ||
+        !snapshot_section_fits(header.extras_offset, header.extra_count, sizeof(SnapshotExtra), size) ||
+        !snapshot_section_fits(header.blob_offset, header.blob_size, 1, size)) {
+        return false;
+    }
+    if (!source_filename.empty() && !header.source.matches(source_filename.c_str())) {
         return false;
     }
 
-    // Read and parse fields until we find the closing brace
-    char line_buffer[MAX_LINE_LENGTH];
+    const SnapshotEntry* records = (const SnapshotEntry*)(data + header.entries_offset);
+    const SnapshotAuthor* authors = (const SnapshotAuthor*)(data + header.authors_offset);
+    const SnapshotExtra* extras = (const SnapshotExtra*)(data + header.extras_offset);
+    char* blob = (char*)data + header.blob_offset;
+    if (header.blob_size > 0 && blob[header.blob_size - 1] != '\0') return false;
+
+    // Every index and string range is checked before anything is replaced
+    for (unsigned long i = 0; i < header.entry_count; i++) {
+        const SnapshotEntry& record = records[i];
+        if (record.first_author > header.author_count ||
+            record.author_count > header.author_count - record.first_author ||
+            record.first_extra > header.extra_count ||
+            record.extra_count > header.extra_count - record.first_extra) {
+            return false;
+        }
+        for (int f = 0; f < SNAPSHOT_FIELD_COUNT; f++) {
+            if (!snapshot_string_fits(record.fields[f], header.blob_size)) return false;
+        }
+    }
+    for (unsigned long i = 0; i < header.author_count; i++) {
+        if (!snapshot_string_fits(authors[i].name, header.blob_size) ||
+            !snapshot_string_fits(authors[i].affiliation, header.blob_size)) {
+            return false;
+        }
+    }
+    for (unsigned long i = 0; i < header.extra_count; i++) {
+        if (!snapshot_string_fits(extras[i].name, header.blob_size) ||
+            !snapshot_string_fits(extras[i].value, header.blob_size)) {
+            return false;
+        }
+    }
+
+    StringArena mapping;
+    if (!mapping.adopt_mapping(file)) return false;
+    clear();
+    string_arena.adopt(mapping);
+    StringArenaScope scope(active_arena());
+    entries.reserve(header.entry_count);
+    key_index.reserve(header.entry_count);
+
+    // set_field names of the fields after the key, in SnapshotField order
+    static const char* const FIELD_NAMES[SNAPSHOT_FIELD_COUNT] = {
+        "", "", "title", "year", "booktitle", "journal", "doi", "abstract", "pdf", "code",
+        "ppt", "abbr", "pages", "volume", "number", "publisher", "address"
+    };
+    MyString field_names[SNAPSHOT_FIELD_COUNT];
+    for (int f = SNAPSHOT_TITLE; f < SNAPSHOT_FIELD_COUNT; f++) {
+        field_names[f] = FIELD_NAMES[f];
+    }
 
-    while (read_line(fd, line_buffer, MAX_LINE_LENGTH)) {
-        MyString line(line_buffer);
-        MyString trimmed_line = line;
-        trimmed_line.trim();
+    for (unsigned long i = 0; i < header.entry_count; i++) {
+        const SnapshotEntry& record = records[i];
+        const SnapshotString& key = record.fields[SNAPSHOT_KEY];
+        const SnapshotString& type = record.fields[SNAPSHOT_TYPE];
 
-        // Skip empty lines
-        if (trimmed_line.empty()) {
-            continue;
+        // Built in place; add_entry would move every string once more
+        BibEntry* built = entries.emplace_back(MyString(blob + key.offset, key.length));
+        if (!built) {
+            clear();
+            return false;
+        }
+        BibEntry& entry = *built;
+        entry.set_entry_type(MyString(blob + type.offset, type.length));
+        for (int f = SNAPSHOT_TITLE; f < SNAPSHOT_FIELD_COUNT; f++) {
+            const SnapshotString& value = record.fields[f];
+            if (value.length > 0) {
+                entry.set_field(field_names[f], MyString::wrap_arena(blob + value.offset, value.length),
+                                &intern_pool);
+            }
         }
 
-        // Check if this is just a closing brace - end of entry
-        if (trimmed_line == "}") {
-            break;
+        for (unsigned int j = 0; j < record.author_count; j++) {
+            const SnapshotAuthor& stored = authors[record.first_author + j];
+            Author author(intern_pool.intern(MyStringView(blob + stored.name.offset, stored.name.length)));
+            if (stored.affiliation.length > 0) {
+                author.set_affiliation(MyString(blob + stored.affiliation.offset, stored.affiliation.length));
+            }
+            entry.add_author(my_move(author));
         }
 
-        // Check if line contains field assignment (has '=' sign)
-        if (trimmed_line.find("=") != trimmed_line.length()) {
-            // This is a field line, parse it
-            printf("Parsing field line: %s\n", trimmed_line.c_str());  // Debug output
-            entry.parse_field_line(line);
+        for (unsigned int j = 0; j < record.extra_count; j++) {
+            const SnapshotExtra& stored = extras[record.first_extra + j];
+            entry.set_extra_field(MyString(blob + stored.name.offset, stored.name.length),
+                                  MyString::wrap_arena(blob + stored.value.offset, stored.value.length));
         }
+
+        entry.intern_strings(intern_pool);
+        key_index.insert(entry.get_entry_key().hash(), i);
+    }
+
+    if (verbose) {
+        printf("Loaded snapshot: %s (%lu entries)\n", filename.c_str(), header.entry_count);
     }
+    return true;
+}
 
-    // Add the entry if it's valid
+bool BibDatabase::store_parsed_entry(BibEntry& entry) {
+    // Add the entry if it's valid; the parsed entry is moved into the database
     if (entry.is_valid()) {
-        add_entry(entry);
-        printf("Added entry: %s\n", entry.get_entry_key().c_str());
+        if (verbose) {
+            report("Added entry: %s\n", entry.get_entry_key().c_str());
+        }
+        add_entry(my_move(entry));
         return true;
     } else {
-        printf("Warning: Invalid entry skipped - Key: '%s', Title: '%s', Year: '%s'\n", 
+        report("Warning: Invalid entry skipped - Key: '%s', Title: '%s', Year: '%s'\n", 
                entry.get_entry_key().c_str(), 
                entry.get_title().c_str(), 
                entry.get_year().c_str());
@@ -211,56 +693,193 @@ bool BibDatabase::parse_bib_entry(int fd, MyString& current_line) {
 }
 
 
+void BibDatabase::intern_all_entries() {
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        entries[i].intern_strings(intern_pool);
+    }
+}
+
+StringArena* BibDatabase::active_arena() {
+    return arena_enabled ? &string_arena : nullptr;
+}
+
+// Key index maintenance
+void BibDatabase::rebuild_key_index() {
+    key_index.clear();
+    key_index.reserve(entries.get_size());
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        key_index.insert(entries[i].get_entry_key().hash(), i);
+    }
+}
+
+// Returns the position of the first entry with this key, or size() if none.
+// Candidates come back in insertion order, so duplicates resolve to the
+// earliest entry just like a linear scan would.
+unsigned long BibDatabase::find_position(const MyString& entry_key) const {
+    unsigned long hash = entry_key.hash();
+    unsigned long cursor = key_index.probe_start(hash);
+    unsigned long position;
+
+    while (key_index.next_candidate(hash, cursor, position)) {
+        if (entries[position].get_entry_key() == entry_key) {
+            return position;
+        }
+    }
+    return entries.get_size();
+}
+// Prints a parse message, or queues it while parsing on a worker thread
+void BibDatabase::report(const char* format, ...) {
+    __builtin_va_list args;
+    __builtin_va_start(args, format);
+
+    if (!deferred_messages) {
+        vprintf(format, args);
+        __builtin_va_end(args);
+        return;
+    }
+
+    char buffer[256];
+    __builtin_va_list retry;
+    __builtin_va_copy(retry, args);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+
+    DeferredMessage* queued = deferred_messages->emplace_back();
+    if (!queued) {
+        __builtin_va_end(retry);
+        __builtin_va_end(args);
+        return;
+    }
+    DeferredMessage& message = *queued;
+    message.position = entries.get_size();
+    if (length < (int)sizeof(buffer)) {
+        message.text = buffer;
+    } else {
+        // Long titles or headers - format again into an exactly sized block
+        char* text = (char*)malloc(length + 1);
+        if (text) {
+            vsnprintf(text, length + 1, format, retry);
+            message.text = MyString(text, length);
+            free(text);
+        }
+    }
+    __builtin_va_end(retry);
+    __builtin_va_end(args);
+}
+
 // Entry management
 void BibDatabase::add_entry(const BibEntry& entry) {
+    invalidate_secondary_indexes();
+    StringArenaScope scope(active_arena());
     entries.push_back(entry);
+    BibEntry& added = entries[entries.get_size() - 1];
+    added.intern_strings(intern_pool);
+    key_index.insert(added.get_entry_key().hash(), entries.get_size() - 1);
+    if (author_index) author_index->add_entry(added, entries.get_size() - 1, intern_pool);
+}
+
+void BibDatabase::add_entry(BibEntry&& entry) {
+    invalidate_secondary_indexes();
+    entries.push_back(my_move(entry));
+    BibEntry& added = entries[entries.get_size() - 1];
+    added.intern_strings(intern_pool);
+    key_index.insert(added.get_entry_key().hash(), entries.get_size() - 1);
+    if (author_index) author_index->add_entry(added, entries.get_size() - 1, intern_pool);
 }
 
 bool BibDatabase::remove_entry(const MyString& entry_key) {
-    // Simple removal - create new vector without the entry
-    MyVector<BibEntry> new_entries;
-    bool found = false;
+    if (find_position(entry_key) == entries.get_size()) {
+        return false;
+    }
 
+    // Move every other entry into a new vector; positions shift, so reindex
+    MyVector<BibEntry> new_entries;
+    MyVector<unsigned long> removed;
     for (unsigned long i = 0; i < entries.get_size(); i++) {
         if (entries[i].get_entry_key() != entry_key) {
-            new_entries.push_back(entries[i]);
+            new_entries.push_back(my_move(entries[i]));
         } else {
-            found = true;
+            removed.push_back(i);
         }
     }
 
-    if (found) {
-        entries = new_entries;
-    }
-
-    return found;
+    entries = my_move(new_entries);
+    invalidate_secondary_indexes();
+    if (author_index) author_index->remove_positions(&removed[0], removed.get_size());
+    rebuild_key_index();
+    return true;
 }
 
 BibEntry* BibDatabase::find_entry(const MyString& entry_key) {
-    for (unsigned long i = 0; i < entries.get_size(); i++) {
-        if (entries[i].get_entry_key() == entry_key) {
-            return &entries[i];
-        }
-    }
-    return nullptr;
+    unsigned long position = find_position(entry_key);
+    return position < entries.get_size() ? &entries[position] : nullptr;
 }
 
 const BibEntry* BibDatabase::find_entry(const MyString& entry_key) const {
-    for (unsigned long i = 0; i < entries.get_size(); i++) {
-        if (entries[i].get_entry_key() == entry_key) {
-            return &entries[i];
-        }
-    }
-    return nullptr;
+    unsigned long position = find_position(entry_key);
+    return position < entries.get_size() ? &entries[position] : nullptr;
 }
 
 // Database operations
+// Compact sort record: the precomputed keys of one entry plus its position
+struct EntrySortKey {
+    const char* title_key;
+    int year;
+    unsigned long index;
+};
+
+// <year descending, title ascending>, ties broken by position so the
+// result matches a stable sort of the entries themselves
+struct EntrySortKeyLess {
+    bool operator()(const EntrySortKey& a, const EntrySortKey& b) const {
+        if (a.year != b.year) return a.year > b.year;
+        int order = MyString::strcmp(a.title_key, b.title_key);
+        if (order != 0) return order < 0;
+        return a.index < b.index;
+    }
+};
+
 void BibDatabase::sort_entries() {
-    entries.sort();
+    unsigned long count = entries.get_size();
+    if (count < 2) return;
+
+    // Sort small key records instead of whole entries, then move each entry once
+    EntrySortKey* keys = (EntrySortKey*)malloc(sizeof(EntrySortKey) * count);
+    unsigned long* order = (unsigned long*)malloc(sizeof(unsigned long) * count);
+    if (!keys || !order) {
+        // Out of memory - sort the entries directly
+        if (keys) free(keys);
+        if (order) free(order);
+        entries.stable_sort();
+        invalidate_indexes();
+        rebuild_key_index();
+        return;
+    }
+
+    for (unsigned long i = 0; i < count; i++) {
+        keys[i].title_key = entries[i].get_title_key().c_str();
+        keys[i].year = entries[i].get_year_as_int();
+        keys[i].index = i;
+    }
+
+    MySort<EntrySortKey, EntrySortKeyLess>::introsort(keys, count);
+
+    for (unsigned long i = 0; i < count; i++) {
+        order[i] = keys[i].index;
+    }
+    free(keys);
+
+    entries.apply_permutation(order);
+    free(order);
+    invalidate_indexes();   // Positions changed
+    rebuild_key_index();
 }
 
 void BibDatabase::clear() {
+    invalidate_indexes();
     entries.clear();
+    intern_pool.clear();
+    key_index.clear();
+    string_arena.release();
 }
 
 bool BibDatabase::empty() const {
@@ -271,33 +890,266 @@ unsigned long BibDatabase::size() const {
     return entries.get_size();
 }
 
+// Secondary indexes
+static void destroy_index(SecondaryIndex*& index) {
+    if (index) {
+        index->~SecondaryIndex();
+        free(index);
+        index = nullptr;
+    }
+}
+
+void BibDatabase::invalidate_secondary_indexes() {
+    destroy_index(year_index);
+    destroy_index(type_index);
+    destroy_index(venue_index);
+}
+
+void BibDatabase::invalidate_indexes() {
+    invalidate_secondary_indexes();
+    if (author_index) {
+        author_index->~AuthorIndex();
+        free(author_index);
+        author_index = nullptr;
+    }
+}
+
+// Builds the requested index on first use. Entries without a valid year,
+// a type or a venue are simply left out of that index.
+const SecondaryIndex& BibDatabase::secondary_index(IndexKind kind) const {
+    SecondaryIndex*& slot = kind == INDEX_YEAR ? year_index : kind == INDEX_TYPE ? type_index : venue_index;
+    if (slot) return *slot;
+
+    static const SecondaryIndex empty_index;
+    void* memory = malloc(sizeof(SecondaryIndex));
+    if (!memory) return empty_index;
+    slot = new (memory) SecondaryIndex();
+    SecondaryIndex& index = *slot;
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        const BibEntry& entry = entries[i];
+        if (kind == INDEX_YEAR) {
+            int year = entry.get_year_as_int();
+            if (year > 0) index.add(year, i);
+        } else if (kind == INDEX_TYPE) {
+            if (!entry.get_entry_type().empty()) {
+                MyString type = SecondaryIndex::normalize(entry.get_entry_type());
+                index.add(index.key_id(type), i);
+            }
+        } else {
+            MyString booktitle = SecondaryIndex::normalize(entry.get_booktitle());
+            MyString journal = SecondaryIndex::normalize(entry.get_journal());
+            if (!booktitle.empty()) index.add(index.key_id(booktitle), i);
+            if (!journal.empty() && journal != booktitle) index.add(index.key_id(journal), i);
+        }
+    }
+    index.finish();
+    return index;
+}
+
+unsigned long BibDatabase::copy_positions(const unsigned long* found, unsigned long count,
+                                          MyVector<unsigned long>& positions) {
+    positions.reserve(positions.get_size() + count);
+    for (unsigned long i = 0; i < count; i++) {
+        positions.push_back(found[i]);
+    }
+    return count;
+}
+
+unsigned long BibDatabase::find_by_year(int first_year, int last_year,
+                                        MyVector<unsigned long>& positions) const {
+    const unsigned long* found;
+    unsigned long count = secondary_index(INDEX_YEAR).find_range(first_year, last_year, found);
+    return copy_positions(found, count, positions);
+}
+
+unsigned long BibDatabase::count_by_year(int first_year, int last_year) const {
+    const unsigned long* found;
+    return secondary_index(INDEX_YEAR).find_range(first_year, last_year, found);
+}
+
+unsigned long BibDatabase::find_by_type(const MyString& entry_type, MyVector<unsigned long>& positions) const {
+    const SecondaryIndex& index = secondary_index(INDEX_TYPE);
+    MyString key = SecondaryIndex::normalize(entry_type);
+    const unsigned long* found;
+    unsigned long count = index.find(index.find_key_id(key), found);
+    return copy_positions(found, count, positions);
+}
+
+unsigned long BibDatabase::find_by_venue(const MyString& venue, MyVector<unsigned long>& positions) const {
+    const SecondaryIndex& index = secondary_index(INDEX_VENUE);
+    MyString key = SecondaryIndex::normalize(venue);
+    const unsigned long* found;
+    unsigned long count = index.find(index.find_key_id(key), found);
+    return copy_positions(found, count, positions);
+}
+
+// Built from the intern pool's ids, so each distinct spelling of a name is
+// normalized once; later add_entry() and remove_entry() calls keep it current
+const AuthorIndex& BibDatabase::indexed_authors() const {
+    if (author_index) return *author_index;
+
+    static const AuthorIndex empty_index;
+    void* memory = malloc(sizeof(AuthorIndex));
+    if (!memory) return empty_index;
+    author_index = new (memory) AuthorIndex();
+    for (unsigned long i = 0; i < entries.get_size(); i++) {
+        author_index->add_entry(entries[i], i, intern_pool);
+    }
+    return *author_index;
+}
+
+unsigned long BibDatabase::find_by_author(const MyString& name, MyVector<unsigned long>& positions) const {
+    const AuthorIndex& index = indexed_authors();
+    const unsigned long* found;
+    unsigned long count = index.find(index.find_author(name), found);
+    return copy_positions(found, count, positions);
+}
+
+unsigned long BibDatabase::count_by_author(const MyString& name) const {
+    const AuthorIndex& index = indexed_authors();
+    const unsigned long* found;
+    return index.find(index.find_author(name), found);
+}
+
+unsigned long BibDatabase::top_authors(unsigned int k, MyVector<AuthorCount>& authors) const {
+    return indexed_authors().top(k, authors);
+}
+
 // Search and filter operations
 int BibDatabase::count_institute_authors(const MyString& institute_name) const {
-    int total_count = 0;
-
     printf("Looking for authors from: %s\n\n", institute_name.c_str());
 
-    for (unsigned long i = 0; i < entries.get_size(); i++) {
-        int entry_count = entries[i].count_institute_authors(institute_name);
-        if (entry_count > 0) {
-            printf("Entry '%s' has %d author(s) from %s\n", 
-                   entries[i].get_entry_key().c_str(), 
-                   entry_count, 
-                   institute_name.c_str());
-
-            // Print the authors from this institute
-            for (int j = 0; j < entries[i].get_author_count(); j++) {
-                const Author& author = entries[i].get_author(j);
-                if (author.is_from_institute(institute_name)) {
-                    printf("  Found institute author: %s\n", author.get_name().c_str());
+    InstituteSet institutes;
+    institutes.add(institute_name);
+    MyVector<InstituteMatch> matches;
+    if (institutes.build()) {
+        scan_institutes(institutes, nullptr, &matches);
+    }
+    print_institute_matches(institute_name.c_str(), matches, nullptr, 0, matches.get_size());
+    return (int)matches.get_size();
+}
+
+void BibDatabase::count_institute_authors(const InstituteSet& institutes, int* counts) const {
+    scan_institutes(institutes, counts, nullptr);
+}
+
+void BibDatabase::find_institute_authors(const InstituteSet& institutes,
+                                         MyVector<InstituteMatch>& matches) const {
+    matches.clear();
+    scan_institutes(institutes, nullptr, &matches);
+}
+
+struct BibDatabase::InstituteChunk {
+    const BibDatabase* database;
+    const InstituteSet* institutes;
+    unsigned long begin;
+    unsigned long end;
+    int* counts;                        // Null when the caller wants no counts
+    MyVector<InstituteMatch> matches;
+    bool collect_matches;
+
+    InstituteChunk()
+        : database(nullptr), institutes(nullptr), begin(0), end(0), counts(nullptr), matches(),
+          collect_matches(false) {}
+};
+
+void BibDatabase::institute_chunk_task(void* context, unsigned long index) {
+    InstituteChunk& chunk = ((InstituteChunk*)context)[index];
+    chunk.database->scan_institute_range(*chunk.institutes, chunk.begin, chunk.end, chunk.counts,
+                                         chunk.collect_matches ? &chunk.matches : nullptr);
+}
+
+// Adds the authors of entries [begin, end) to counts and appends their
+// matches; nothing here is shared with other ranges
+void BibDatabase::scan_institute_range(const InstituteSet& institutes, unsigned long begin,
+                                       unsigned long end, int* counts,
+                                       MyVector<InstituteMatch>* matches) const {
+    unsigned int institute_count = institutes.size();
+    unsigned int* found = (unsigned int*)malloc(sizeof(unsigned int) * institute_count);
+    unsigned char* seen = (unsigned char*)malloc(institute_count);
+    if (!found || !seen) {
+        if (found) free(found);
+        if (seen) free(seen);
+        return;
+    }
+    memset(seen, 0, institute_count);
+
+    for (unsigned long i = begin; i < end; i++) {
+        const BibEntry& entry = entries[i];
+        for (int j = 0; j < entry.get_author_count(); j++) {
+            unsigned int found_count = entry.get_author(j).collect_institutes(institutes, found, 0, seen);
+            for (unsigned int k = 0; k < found_count; k++) {
+                if (counts) counts[found[k]]++;
+                if (matches) {
+                    InstituteMatch match;
+                    match.entry = i;
+                    match.author = j;
+                    match.institute = found[k];
+                    matches->push_back(match);
                 }
+                seen[found[k]] = 0;
             }
-
-            total_count += entry_count;
         }
     }
 
-    return total_count;
+    free(found);
+    free(seen);
+}
+
+void BibDatabase::scan_institutes(const InstituteSet& institutes, int* counts,
+                                  MyVector<InstituteMatch>* matches) const {
+    unsigned int institute_count = institutes.size();
+    if (counts) {
+        for (unsigned int k = 0; k < institute_count; k++) counts[k] = 0;
+    }
+    if (institute_count == 0) return;
+
+    // A few ranges per thread so entries with many authors balance out
+    static const unsigned long MIN_CHUNK_ENTRIES = 4096;
+    unsigned long entry_count = entries.get_size();
+    unsigned long chunk_count = (unsigned long)thread_count * 4;
+    if (chunk_count > entry_count / MIN_CHUNK_ENTRIES) chunk_count = entry_count / MIN_CHUNK_ENTRIES;
+
+    InstituteChunk* chunks = nullptr;
+    int* chunk_counts = nullptr;
+    if (chunk_count >= 2) {
+        chunks = (InstituteChunk*)malloc(sizeof(InstituteChunk) * chunk_count);
+        chunk_counts = (int*)malloc(sizeof(int) * institute_count * chunk_count);
+    }
+    if (!chunks || !chunk_counts) {
+        if (chunks) free(chunks);
+        if (chunk_counts) free(chunk_counts);
+        scan_institute_range(institutes, 0, entry_count, counts, matches);
+        return;
+    }
+
+    for (unsigned long i = 0; i < chunk_count; i++) {
+        new (&chunks[i]) InstituteChunk();
+        chunks[i].database = this;
+        chunks[i].institutes = &institutes;
+        chunks[i].begin = entry_count / chunk_count * i;
+        chunks[i].end = i + 1 < chunk_count ? entry_count / chunk_count * (i + 1) : entry_count;
+        chunks[i].counts = counts ? chunk_counts + institute_count * i : nullptr;
+        chunks[i].collect_matches = matches != nullptr;
+    }
+    if (counts) memset(chunk_counts, 0, sizeof(int) * institute_count * chunk_count);
+
+    parallel_for(thread_count, chunk_count, institute_chunk_task, chunks);
+
+    // Reduce in range order, so the matches stay in entry order
+    for (unsigned long i = 0; i < chunk_count; i++) {
+        if (counts) {
+            for (unsigned int k = 0; k < institute_count; k++) counts[k] += chunks[i].counts[k];
+        }
+        if (matches) {
+            for (unsigned long m = 0; m < chunks[i].matches.get_size(); m++) {
+                matches->push_back(chunks[i].matches[m]);
+            }
+        }
+        chunks[i].~InstituteChunk();
+    }
+    free(chunks);
+    free(chunk_counts);
 }
 
 // Accessors
@@ -309,6 +1161,38 @@ void BibDatabase::set_name(const MyString& name) {
     database_name = name;
 }
 
+bool BibDatabase::is_verbose() const {
+    return verbose;
+}
+
+void BibDatabase::set_verbose(bool enabled) {
+    verbose = enabled;
+}
+
+int BibDatabase::get_thread_count() const {
+    return thread_count;
+}
+
+void BibDatabase::set_thread_count(int count) {
+    thread_count = count > 0 ? count : 1;
+}
+
+bool BibDatabase::is_arena_enabled() const {
+    return arena_enabled;
+}
+
+void BibDatabase::set_arena_enabled(bool enabled) {
+    arena_enabled = enabled;
+}
+
+const StringArena& BibDatabase::get_arena() const {
+    return string_arena;
+}
+
+const InternPool& BibDatabase::get_intern_pool() const {
+    return intern_pool;
+}
+
 BibEntry& BibDatabase::get_entry(unsigned long index) {
     return entries[index];
 }
@@ -370,6 +1254,79 @@ void BibDatabase::print_institute_authors(const MyString& institute_name) const
     printf("\nTotal authors from %s: %d\n", institute_name.c_str(), total);
 }
 
+// Prints matches[order[m]] for m in [begin, end) (order null: m itself),
+// one line per entry followed by its authors
+void BibDatabase::print_institute_matches(const char* institute_name,
+                                          const MyVector<InstituteMatch>& matches,
+                                          const unsigned long* order, unsigned long begin,
+                                          unsigned long end) const {
+    unsigned long m = begin;
+    while (m < end) {
+        unsigned long entry_index = matches[order ? order[m] : m].entry;
+        unsigned long run_end = m;
+        while (run_end < end && matches[order ? order[run_end] : run_end].entry == entry_index) run_end++;
+
+        const BibEntry& entry = entries[entry_index];
+        printf("Entry '%s' has %lu author(s) from %s\n",
+               entry.get_entry_key().c_str(), run_end - m, institute_name);
+        for (; m < run_end; m++) {
+            printf("  Found institute author: %s\n",
+                   entry.get_author(matches[order ? order[m] : m].author).get_name().c_str());
+        }
+    }
+}
+
+// One scan finds every match; they are then grouped by institute (keeping
+// entry order) and printed as the single-institute report would be
+void BibDatabase::print_institute_authors(const InstituteSet& institutes) const {
+    unsigned int institute_count = institutes.size();
+    MyVector<InstituteMatch> matches;
+    find_institute_authors(institutes, matches);
+
+    // Counting sort by institute
+    unsigned long* starts = (unsigned long*)malloc(sizeof(unsigned long) * (institute_count + 1));
+    unsigned long* order = (unsigned long*)malloc(sizeof(unsigned long) * (matches.get_size() + 1));
+    if (!starts || !order) {
+        if (starts) free(starts);
+        if (order) free(order);
+        return;
+    }
+    for (unsigned int k = 0; k <= institute_count; k++) starts[k] = 0;
+    for (unsigned long m = 0; m < matches.get_size(); m++) starts[matches[m].institute + 1]++;
+    for (unsigned int k = 0; k < institute_count; k++) starts[k + 1] += starts[k];
+    for (unsigned long m = 0; m < matches.get_size(); m++) order[starts[matches[m].institute]++] = m;
+    for (unsigned int k = institute_count; k > 0; k--) starts[k] = starts[k - 1];
+    starts[0] = 0;
+
+    for (unsigned int k = 0; k < institute_count; k++) {
+        const char* name = institutes.get_name(k).c_str();
+        if (k > 0) printf("\n");
+        printf("Looking for authors from: %s\n\n", name);
+        print_institute_matches(name, matches, order, starts[k], starts[k + 1]);
+        printf("\nTotal authors from %s: %lu\n", name, starts[k + 1] - starts[k]);
+    }
+
+    if (institute_count > 1) {
+        printf("\n%-40s %10s\n", "Institute", "Authors");
+        for (unsigned int k = 0; k < institute_count; k++) {
+            printf("%-40s %10lu\n", institutes.get_name(k).c_str(), starts[k + 1] - starts[k]);
+        }
+    }
+
+    free(starts);
+    free(order);
+}
+
+void BibDatabase::print_top_authors(unsigned int k) const {
+    MyVector<AuthorCount> authors;
+    top_authors(k, authors);
+    printf("Top %lu of %lu authors by entries:\n", authors.get_size(), indexed_authors().get_author_count());
+    printf("%-40s %10s\n", "Author", "Entries");
+    for (unsigned long i = 0; i < authors.get_size(); i++) {
+        printf("%-40s %10lu\n", authors[i].name.c_str(), authors[i].entry_count);
+    }
+}
+
 // Validation
 bool BibDatabase::validate() const {
     for (unsigned long i = 0; i < entries.get_size(); i++) {
@@ -4,9 +4,56 @@
 
 #include "bibentry.h"
 #include "mystring.h"
+#include "mystringview.h"
 #include "Author.h"
 #include "placement_new.h"
+#include "myutility.h"
+#include "bufferedreader.h"
+#include "bufferedwriter.h"
+#include "bibsnapshot.h"
+#include "mappedfile.h"
+#include "hashindex.h"
+#include "parallel.h"
+#include "bibtokenizer.h"
+#include "stringarena.h"
+#include "internpool.h"
+#include "institutematcher.h"
+#include "instituteset.h"
+
+
+// Default comparator - orders elements with T::operator<
+template<typename T>
+struct MyLess {
+    bool operator()(const T& a, const T& b) const {
+        return a < b;
+    }
+};
+
+// Sorting algorithms over a contiguous array of count elements.
+// Elements are moved, never copied. comp(a, b) returns true when a must come before b.
+template<typename T, typename Compare = MyLess<T> >
+class MySort {
+private:
+    static const unsigned long INSERTION_THRESHOLD = 16;
+
+    static void insertion_sort(T* data, unsigned long count, Compare& comp);
+    static void move_median_to_front(T* data, unsigned long count, Compare& comp);
+    static unsigned long partition(T* data, unsigned long count, Compare& comp);
+    static void introsort_loop(T* data, unsigned long count, int depth_limit, Compare& comp);
+    static void sift_down(T* data, unsigned long root, unsigned long count, Compare& comp);
+    static void merge_sort_range(T* data, unsigned long count, T* buffer, Compare& comp);
+
+public:
+    // Unstable O(n log n): quicksort with a heapsort fallback when recursion
+    // gets too deep, finished with insertion sort on small partitions
+    static void introsort(T* data, unsigned long count, Compare comp = Compare());
 
+    // Stable O(n log n) top-down merge sort using a buffer of count / 2 elements
+    static void merge_sort(T* data, unsigned long count, Compare comp = Compare());
+
+    // O(n log n) in place, unstable
+    static void heap_sort(T* data, unsigned long count, Compare comp = Compare());
+};
 
 // Simple vector-like container since we can't use std::vector - COMPLETELY FIXED
 template<typename T>
@@ -17,78 +64,262 @@ private:
     unsigned long capacity;
 
     void resize();
+    void reallocate(unsigned long new_capacity);
     void deallocate();
 
 public:
     MyVector();
     MyVector(const MyVector& other);
+    MyVector(MyVector&& other);
     ~MyVector();
 
     MyVector& operator=(const MyVector& other);
+    MyVector& operator=(MyVector&& other);
 
     void push_back(const T& item);
+    void push_back(T&& item);
+    void pop_back();    // Destroys the last element; the vector must not be empty
+
+    // Constructs the new element in place from the given arguments and
+    // returns it, or returns null (adding nothing) when memory runs out
+    template<typename... Args>
+    T* emplace_back(Args&&... args);
+
     void clear();
     unsigned long get_size() const;
     bool empty() const;
 
+    // Capacity - reserve() makes room for at least count elements, so bulk
+    // loads of a known size never move elements; shrink_to_fit() frees the rest
+    void reserve(unsigned long count);
+    void shrink_to_fit();
+    unsigned long get_capacity() const;
+
     T& operator[](unsigned long index);
     const T& operator[](unsigned long index) const;
 
-    // Sorting method (simple bubble sort)
+    // Sorting methods - sort() is unstable (introsort), stable_sort() keeps
+    // the relative order of equal elements (merge sort)
     void sort();
+    template<typename Compare> void sort(Compare comp);
+    void stable_sort();
+    template<typename Compare> void stable_sort(Compare comp);
+
+    // Moves the element at order[i] to position i, following each cycle once.
+    // order must be a permutation of 0..size-1; it is overwritten.
+    void apply_permutation(unsigned long* order);
+};
+
+class SecondaryIndex;   // secondaryindex.h
+class AuthorIndex;      // authorindex.h
+
+// One author found by BibDatabase::find_institute_authors
+struct InstituteMatch {
+    unsigned long entry;        // Entry index
+    int author;                 // Author index within the entry
+    unsigned int institute;     // InstituteSet id
+};
+
+// One author of BibDatabase::top_authors
+struct AuthorCount {
+    MyString name;              // Fullest spelling in the entries
+    MyString key;               // AuthorIndex::normalize of the name
+    unsigned long entry_count;
 };
 
 class BibDatabase {
 private:
+    StringArena string_arena;   // Declared first so it outlives the entries
+    bool arena_enabled;         // New entry strings come from string_arena
     MyVector<BibEntry> entries;
+    InternPool intern_pool;     // Author names, booktitles and journals of the entries
     MyString database_name;
-
-    // File I/O helper methods
-    static const int MAX_LINE_LENGTH = 8192;
-    bool read_line(int fd, char* buffer, int max_len);
-    bool is_whitespace_line(const MyString& line);
-
-    // Parsing helper methods
-    bool parse_bib_entry(int fd, MyString& current_line);
+    bool verbose;           // Print per-entry progress while loading
+    HashIndex key_index;    // Entry key hash -> position in entries
+    int thread_count;       // Worker threads used by load_from_file and institute scans
+
+    // Secondary indexes, built by the first query that needs one and
+    // dropped whenever entries are added, removed or reordered (null when
+    // absent). Years are keys themselves; types and normalized venues
+    // (booktitles and journals) are keyed by their id in the index.
+    mutable SecondaryIndex* year_index;
+    mutable SecondaryIndex* type_index;
+    mutable SecondaryIndex* venue_index;
+
+    // Entries of each author, built by the first author query. Unlike the
+    // secondary indexes it survives add_entry() and remove_entry(), which
+    // update its posting lists in place; sorting or reloading drops it.
+    mutable AuthorIndex* author_index;
+
+    // Parse messages of a worker database, replayed in file order after a
+    // parallel load; position is the entry count when the message was issued
+    struct DeferredMessage {
+        MyString text;
+        unsigned long position;
+    };
+    MyVector<DeferredMessage>* deferred_messages;   // Null: print immediately
+
+    // One slice of the input for a parallel load (defined in bibdatabase.cpp)
+    struct ParseChunk;
+
+    // Arena installed while this database builds strings (null when disabled)
+    StringArena* active_arena();
+
+    // Interns every entry into intern_pool (after copying entries in)
+    void intern_all_entries();
+
+    // Key index maintenance
+    void rebuild_key_index();
+    unsigned long find_position(const MyString& entry_key) const;
+
+    // Secondary index maintenance
+    enum IndexKind { INDEX_YEAR, INDEX_TYPE, INDEX_VENUE };
+    const SecondaryIndex& secondary_index(IndexKind kind) const;
+    const AuthorIndex& indexed_authors() const;
+    void invalidate_secondary_indexes();    // Leaves author_index alone
+    static unsigned long copy_positions(const unsigned long* found, unsigned long count,
+                                        MyVector<unsigned long>& positions);
+
+    // Parsing helper methods - both feed a BibTokenizer
+    struct EntryBuilder;    // BibTokenHandler that fills entries (defined in bibdatabase.cpp)
+    int parse_buffered(BufferedReader& reader);
+    int parse_mapped(const char* data, unsigned long length);
+    void reserve_for_input(const char* data, unsigned long length);
+    bool store_parsed_entry(BibEntry& entry);
+    void report(const char* format, ...);
+
+    // Parallel loading
+    int parse_parallel(const char* data, unsigned long length);
+    static void parse_chunk_task(void* context, unsigned long index);
+
+    // Snapshots: the records pass assigns blob offsets, the blob pass
+    // writes the strings in the same order (defined in bibdatabase.cpp)
+    struct SnapshotStrings;
+    bool write_snapshot_sections(BufferedWriter& writer, SnapshotStrings& strings, bool records) const;
+
+    // Institute scans: entry ranges are matched on up to thread_count
+    // threads, each into its own counts and match list, then reduced in
+    // entry order. counts or matches may be null.
+    struct InstituteChunk;  // Defined in bibdatabase.cpp
+    void scan_institute_range(const InstituteSet& institutes, unsigned long begin, unsigned long end,
+                              int* counts, MyVector<InstituteMatch>* matches) const;
+    void scan_institutes(const InstituteSet& institutes, int* counts,
+                         MyVector<InstituteMatch>* matches) const;
+    static void institute_chunk_task(void* context, unsigned long index);
+    void print_institute_matches(const char* institute_name, const MyVector<InstituteMatch>& matches,
+                                 const unsigned long* order, unsigned long begin, unsigned long end) const;
 
 public:
+    // How load_from_file reads its input
+    enum LoadMode {
+        LOAD_BUFFERED,  // Block by block through a BufferedReader
+        LOAD_MAPPED     // Zero-copy parsing of a read-only memory mapping,
+                        // split across get_thread_count() threads
+    };
+
     // Constructors
     BibDatabase();
     BibDatabase(const MyString& name);
     BibDatabase(const BibDatabase& other);
+    BibDatabase(BibDatabase&& other);
 
     // Destructor
     ~BibDatabase();
 
     // Assignment operator
     BibDatabase& operator=(const BibDatabase& other);
+    BibDatabase& operator=(BibDatabase&& other);
 
     // Addition operator for merging databases
     BibDatabase operator+(const BibDatabase& other) const;
     BibDatabase& operator+=(const BibDatabase& other);
 
     // File operations
-    bool load_from_file(const MyString& filename);
+    bool load_from_file(const MyString& filename, LoadMode mode = LOAD_MAPPED);
     bool save_to_file(const MyString& filename) const;
 
-    // Entry management
+    // Binary snapshot of the whole database (layout in bibsnapshot.h),
+    // loaded by mapping the file and building entries straight from its
+    // records. load_snapshot fails, leaving the database untouched, if the
+    // snapshot is damaged or from another version, or when source_filename
+    // is given and that file no longer matches the stamp saved with it.
+    // Running out of memory part-way also fails, leaving it empty.
+    // Loaded strings stay in the mapping, owned by the arena as in arena
+    // mode, so copy entries that must outlive the database.
+    bool save_snapshot(const MyString& filename, const SourceStamp& source) const;
+    bool load_snapshot(const MyString& filename, const MyString& source_filename);
+
+    // Entry management - find_entry is a hash lookup on the entry key.
+    // Changing an entry's key through get_entry() or find_entry() does not
+    // update the index; remove and re-add the entry instead.
     void add_entry(const BibEntry& entry);
+    void add_entry(BibEntry&& entry);
     bool remove_entry(const MyString& entry_key);
     BibEntry* find_entry(const MyString& entry_key);
     const BibEntry* find_entry(const MyString& entry_key) const;
 
     // Database operations
     void sort_entries(); // Sort by <year descending, title ascending>
+    template<typename Compare> void sort_entries(Compare comp); // Stable, custom order
     void clear();
     bool empty() const;
     unsigned long size() const;
 
-    // Search and filter operations
+    // Search and filter operations. The matching authors are printed after
+    // the scan, in entry order, whatever the thread count.
     int count_institute_authors(const MyString& institute_name) const;
 
+    // Several institutes in one pass over the authors; the set must be
+    // built. counts holds one element per institute. Matches come in entry
+    // and author order.
+    void count_institute_authors(const InstituteSet& institutes, int* counts) const;
+    void find_institute_authors(const InstituteSet& institutes, MyVector<InstituteMatch>& matches) const;
+
+    // Analytic queries answered from secondary indexes instead of a scan.
+    // Each index is built on its first query and kept until entries are
+    // added, removed, sorted or reloaded. Matching positions are appended
+    // to positions and their number returned; a year range lists one year
+    // after another, each in entry order. Types and venues are compared
+    // after SecondaryIndex::normalize, and a venue matches either the
+    // booktitle or the journal. As with the key index, edits made through
+    // get_entry() or find_entry() are not seen until invalidate_indexes().
+    // Building an index is not thread-safe; make the first query of each
+    // kind before sharing the database between threads.
+    unsigned long find_by_year(int first_year, int last_year, MyVector<unsigned long>& positions) const;
+    unsigned long find_by_type(const MyString& entry_type, MyVector<unsigned long>& positions) const;
+    unsigned long find_by_venue(const MyString& venue, MyVector<unsigned long>& positions) const;
+    unsigned long count_by_year(int first_year, int last_year) const;
+    void invalidate_indexes();
+
+    // Per-author queries from the author index. Names are compared after
+    // AuthorIndex::normalize, so "Arani Bhattacharya" also finds entries
+    // by "Bhattacharya, A."; each entry is listed once. top_authors
+    // appends the k authors with the most entries, most first. As above,
+    // make the first query before sharing the database between threads.
+    unsigned long find_by_author(const MyString& name, MyVector<unsigned long>& positions) const;
+    unsigned long count_by_author(const MyString& name) const;
+    unsigned long top_authors(unsigned int k, MyVector<AuthorCount>& authors) const;
+
     // Accessors
     const MyString& get_name() const;
     void set_name(const MyString& name);
+    bool is_verbose() const;
+    void set_verbose(bool enabled);
+    int get_thread_count() const;
+    void set_thread_count(int count); // > 1 parses mapped files and scans institutes in parallel
+
+    // Arena mode: strings of loaded and copied-in entries are bump-allocated
+    // from blocks owned by the database and freed all at once by clear()
+    // or the destructor. Strings moved out of the database keep pointing
+    // into the arena, so copy entries that must outlive it.
+    bool is_arena_enabled() const;
+    void set_arena_enabled(bool enabled);
+    const StringArena& get_arena() const;
+
+    // Distinct author names and venues. Entries added to the database are
+    // interned here, so their names and venues compare by id. The pool
+    // keeps strings of removed entries until clear().
+    const InternPool& get_intern_pool() const;
 
     BibEntry& get_entry(unsigned long index);
     const BibEntry& get_entry(unsigned long index) const;
@@ -98,6 +329,8 @@ public:
     void print_summary() const;
     void print_entries() const;
     void print_institute_authors(const MyString& institute_name) const;
+    void print_institute_authors(const InstituteSet& institutes) const;  // Same layout per institute
+    void print_top_authors(unsigned int k) const;
 
     // Validation
     bool validate() const;
@@ -122,6 +355,13 @@ MyVector<T>::MyVector(const MyVector& other) : data(nullptr), size(0), capacity(
     }
 }
 
+template<typename T>
+MyVector<T>::MyVector(MyVector&& other) : data(other.data), size(other.size), capacity(other.capacity) {
+    other.data = nullptr;
+    other.size = 0;
+    other.capacity = 0;
+}
+
 template<typename T>
 MyVector<T>::~MyVector() {
     deallocate();
@@ -146,6 +386,20 @@ MyVector<T>& MyVector<T>::operator=(const MyVector& other) {
     return *this;
 }
 
+template<typename T>
+MyVector<T>& MyVector<T>::operator=(MyVector&& other) {
+    if (this != &other) {
+        deallocate();
+        data = other.data;
+        size = other.size;
+        capacity = other.capacity;
+        other.data = nullptr;
+        other.size = 0;
+        other.capacity = 0;
+    }
+    return *this;
+}
+
 template<typename T>
 void MyVector<T>::push_back(const T& item) {
     if (size >= capacity) {
@@ -158,6 +412,35 @@ void MyVector<T>::push_back(const T& item) {
     }
 }
 
+template<typename T>
+void MyVector<T>::push_back(T&& item) {
+    if (size >= capacity) {
+        resize();
+    }
+    if (data && size < capacity) {
+        new (&data[size]) T(my_move(item)); // Move constructor
+        size++;
+    }
+}
+
+template<typename T>
+void MyVector<T>::pop_back() {
+    data[--size].~T();
+}
+
+template<typename T>
+template<typename... Args>
+T* MyVector<T>::emplace_back(Args&&... args) {
+    if (size >= capacity) {
+        resize();
+    }
+    if (!data || size >= capacity) {
+        return nullptr;
+    }
+    new (&data[size]) T(my_forward<Args>(args)...);
+    return &data[size++];
+}
+
 template<typename T>
 void MyVector<T>::clear() {
     deallocate();
@@ -179,13 +462,17 @@ void MyVector<T>::deallocate() {
 
 template<typename T>
 void MyVector<T>::resize() {
-    unsigned long new_capacity = capacity == 0 ? 1 : capacity * 2;
+    reallocate(capacity == 0 ? 1 : capacity * 2);
+}
+
+template<typename T>
+void MyVector<T>::reallocate(unsigned long new_capacity) {
     T* new_data = (T*)malloc(sizeof(T) * new_capacity);
 
     if (new_data) {
         // Move-construct elements to new location
         for (unsigned long i = 0; i < size; i++) {
-            new (&new_data[i]) T(data[i]); // Copy construct
+            new (&new_data[i]) T(my_move(data[i])); // Move construct
             data[i].~T(); // Destroy old object
         }
 
@@ -205,6 +492,25 @@ bool MyVector<T>::empty() const {
     return size == 0;
 }
 
+template<typename T>
+void MyVector<T>::reserve(unsigned long count) {
+    if (count > capacity) reallocate(count);
+}
+
+template<typename T>
+void MyVector<T>::shrink_to_fit() {
+    if (size == 0) {
+        deallocate();
+    } else if (size < capacity) {
+        reallocate(size);
+    }
+}
+
+template<typename T>
+unsigned long MyVector<T>::get_capacity() const {
+    return capacity;
+}
+
 template<typename T>
 T& MyVector<T>::operator[](unsigned long index) {
     return data[index];
@@ -217,17 +523,221 @@ const T& MyVector<T>::operator[](unsigned long index) const {
 
 template<typename T>
 void MyVector<T>::sort() {
-    // Simple bubble sort (for educational purposes)
-    for (unsigned long i = 0; i < size && size > 0; i++) {
-        for (unsigned long j = 0; j < size - i - 1; j++) {
-            if (data[j + 1] < data[j]) {
-                // Swap elements using temporary
-                T temp = data[j];
-                data[j] = data[j + 1];
-                data[j + 1] = temp;
+    MySort<T>::introsort(data, size);
+}
+
+template<typename T>
+template<typename Compare>
+void MyVector<T>::sort(Compare comp) {
+    MySort<T, Compare>::introsort(data, size, comp);
+}
+
+template<typename T>
+void MyVector<T>::stable_sort() {
+    MySort<T>::merge_sort(data, size);
+}
+
+template<typename T>
+template<typename Compare>
+void MyVector<T>::stable_sort(Compare comp) {
+    MySort<T, Compare>::merge_sort(data, size, comp);
+}
+
+template<typename T>
+void MyVector<T>::apply_permutation(unsigned long* order) {
+    for (unsigned long i = 0; i < size; i++) {
+        if (order[i] == i) continue;
+
+        T value(my_move(data[i]));
+        unsigned long j = i;
+        while (true) {
+            unsigned long source = order[j];
+            order[j] = j; // Mark position j as placed
+            if (source == i) {
+                data[j] = my_move(value);
+                break;
             }
+            data[j] = my_move(data[source]);
+            j = source;
+        }
+    }
+}
+
+template<typename Compare>
+void BibDatabase::sort_entries(Compare comp) {
+    entries.stable_sort(comp);
+    invalidate_indexes();   // Positions changed
+    rebuild_key_index();
+}
+
+// Sorting algorithm implementation
+template<typename T, typename Compare>
+void MySort<T, Compare>::insertion_sort(T* data, unsigned long count, Compare& comp) {
+    for (unsigned long i = 1; i < count; i++) {
+        if (comp(data[i], data[i - 1])) {
+            T value(my_move(data[i]));
+            unsigned long j = i;
+            do {
+                data[j] = my_move(data[j - 1]);
+                j--;
+            } while (j > 0 && comp(value, data[j - 1]));
+            data[j] = my_move(value);
+        }
+    }
+}
+
+template<typename T, typename Compare>
+void MySort<T, Compare>::move_median_to_front(T* data, unsigned long count, Compare& comp) {
+    // Median of data[1], data[count / 2] and data[count - 1] becomes the pivot in data[0];
+    // the other two act as sentinels for the unguarded partition scans
+    T* a = &data[1];
+    T* b = &data[count / 2];
+    T* c = &data[count - 1];
+    T* median;
+
+    if (comp(*a, *b)) {
+        if (comp(*b, *c)) median = b;
+        else if (comp(*a, *c)) median = c;
+        else median = a;
+    } else if (comp(*a, *c)) {
+        median = a;
+    } else if (comp(*b, *c)) {
+        median = c;
+    } else {
+        median = b;
+    }
+    my_swap(data[0], *median);
+}
+
+template<typename T, typename Compare>
+unsigned long MySort<T, Compare>::partition(T* data, unsigned long count, Compare& comp) {
+    // Hoare partition around data[0]; returns the first index of the upper part
+    move_median_to_front(data, count, comp);
+    const T& pivot = data[0];
+
+    unsigned long left = 1;
+    unsigned long right = count;
+    while (true) {
+        while (comp(data[left], pivot)) left++;
+        right--;
+        while (comp(pivot, data[right])) right--;
+        if (left >= right) return left;
+        my_swap(data[left], data[right]);
+        left++;
+    }
+}
+
+template<typename T, typename Compare>
+void MySort<T, Compare>::introsort_loop(T* data, unsigned long count, int depth_limit, Compare& comp) {
+    while (count > INSERTION_THRESHOLD) {
+        if (depth_limit == 0) {
+            heap_sort(data, count, comp);
+            return;
         }
+        depth_limit--;
+
+        // Recurse into the smaller part, iterate on the larger one
+        unsigned long cut = partition(data, count, comp);
+        if (cut < count - cut) {
+            introsort_loop(data, cut, depth_limit, comp);
+            data += cut;
+            count -= cut;
+        } else {
+            introsort_loop(data + cut, count - cut, depth_limit, comp);
+            count = cut;
+        }
+    }
+    insertion_sort(data, count, comp);
+}
+
+template<typename T, typename Compare>
+void MySort<T, Compare>::introsort(T* data, unsigned long count, Compare comp) {
+    if (!data || count < 2) return;
+
+    int depth_limit = 0;
+    for (unsigned long n = count; n > 1; n >>= 1) {
+        depth_limit += 2;
+    }
+    introsort_loop(data, count, depth_limit, comp);
+}
+
+template<typename T, typename Compare>
+void MySort<T, Compare>::sift_down(T* data, unsigned long root, unsigned long count, Compare& comp) {
+    T value(my_move(data[root]));
+    unsigned long child;
+    while ((child = 2 * root + 1) < count) {
+        if (child + 1 < count && comp(data[child], data[child + 1])) {
+            child++;
+        }
+        if (!comp(value, data[child])) break;
+        data[root] = my_move(data[child]);
+        root = child;
+    }
+    data[root] = my_move(value);
+}
+
+template<typename T, typename Compare>
+void MySort<T, Compare>::heap_sort(T* data, unsigned long count, Compare comp) {
+    if (!data || count < 2) return;
+
+    for (unsigned long i = count / 2; i-- > 0;) {
+        sift_down(data, i, count, comp);
+    }
+    for (unsigned long end = count - 1; end > 0; end--) {
+        my_swap(data[0], data[end]);
+        sift_down(data, 0, end, comp);
+    }
+}
+
+template<typename T, typename Compare>
+void MySort<T, Compare>::merge_sort_range(T* data, unsigned long count, T* buffer, Compare& comp) {
+    if (count <= INSERTION_THRESHOLD) {
+        insertion_sort(data, count, comp);
+        return;
+    }
+
+    unsigned long half = count / 2;
+    merge_sort_range(data, half, buffer, comp);
+    merge_sort_range(data + half, count - half, buffer, comp);
+
+    // Already in order - nothing to merge
+    if (!comp(data[half], data[half - 1])) return;
+
+    // Move the left half out, then merge both halves back into data.
+    // Ties take the left element first, which keeps the sort stable.
+    for (unsigned long i = 0; i < half; i++) {
+        new (&buffer[i]) T(my_move(data[i]));
+    }
+
+    unsigned long i = 0, j = half, k = 0;
+    while (i < half && j < count) {
+        if (comp(data[j], buffer[i])) {
+            data[k++] = my_move(data[j++]);
+        } else {
+            data[k++] = my_move(buffer[i++]);
+        }
+    }
+    while (i < half) {
+        data[k++] = my_move(buffer[i++]);
+    }
+
+    for (unsigned long b = 0; b < half; b++) {
+        buffer[b].~T();
+    }
+}
+
+template<typename T, typename Compare>
+void MySort<T, Compare>::merge_sort(T* data, unsigned long count, Compare comp) {
+    if (!data || count < 2) return;
+
+    T* buffer = (T*)malloc(sizeof(T) * (count / 2));
+    if (!buffer) {
+        // Out of memory - fall back to the in-place stable algorithm
+        insertion_sort(data, count, comp);
+        return;
     }
+    merge_sort_range(data, count, buffer, comp);
+    free(buffer);
 }
 
 #endif // BIBDATABASE_H
\ No newline at end of file
@@ -1,29 +1,58 @@
 // bibentry.cpp - Bibliography entry class implementation (FIXED VERSION)
 #include "bibentry.h"
 #include "Author.h"
+#include "institutematcher.h"
+#include "bufferedwriter.h"
 #include "placement_new.h"
 
 
 // Constructors
-BibEntry::BibEntry() : author_count(0) {
-    authors = nullptr;
+BibEntry::BibEntry()
+    : authors(nullptr), author_count(0), author_capacity(0), extra_fields(nullptr),
+      extra_field_count(0), extra_field_capacity(0), year_value(0) {
     initialize();
 }
 
-BibEntry::BibEntry(const MyString& key) : entry_key(key), author_count(0) {
-    authors = nullptr;
+BibEntry::BibEntry(const MyString& key)
+    : authors(nullptr), author_count(0), author_capacity(0), extra_fields(nullptr),
+      extra_field_count(0), extra_field_capacity(0), year_value(0) {
     initialize();
+    entry_key = key; // Set after initialize(), which clears every field
 }
 
-BibEntry::BibEntry(const BibEntry& other) : author_count(0) {
-    authors = nullptr;
+BibEntry::BibEntry(const BibEntry& other)
+    : authors(nullptr), author_count(0), author_capacity(0), extra_fields(nullptr),
+      extra_field_count(0), extra_field_capacity(0), year_value(0) {
     initialize();
     *this = other;
 }
 
+// Takes over other's strings and author array; other is left without authors
+BibEntry::BibEntry(BibEntry&& other)
+    : entry_type(my_move(other.entry_type)), entry_key(my_move(other.entry_key)),
+      title(my_move(other.title)), year(my_move(other.year)),
+      booktitle(my_move(other.booktitle)), journal(my_move(other.journal)),
+      doi(my_move(other.doi)), abstract(my_move(other.abstract)),
+      pdf_url(my_move(other.pdf_url)), code_url(my_move(other.code_url)),
+      ppt_url(my_move(other.ppt_url)), authors(other.authors), author_count(other.author_count),
+      author_capacity(other.author_capacity),
+      abbr(my_move(other.abbr)), pages(my_move(other.pages)), volume(my_move(other.volume)),
+      number(my_move(other.number)), publisher(my_move(other.publisher)),
+      address(my_move(other.address)), extra_fields(other.extra_fields),
+      extra_field_count(other.extra_field_count), extra_field_capacity(other.extra_field_capacity),
+      year_value(other.year_value), title_key(my_move(other.title_key)) {
+    other.authors = nullptr;
+    other.author_count = 0;
+    other.author_capacity = 0;
+    other.extra_fields = nullptr;
+    other.extra_field_count = 0;
+    other.extra_field_capacity = 0;
+}
+
 // Destructor
 BibEntry::~BibEntry() {
     clear_authors();
+    clear_extra_fields();
 }
 
 // Private helper methods
@@ -45,20 +74,139 @@ void BibEntry::initialize() {
     number.clear();
     publisher.clear();
     address.clear();
-    author_count = 0;
+    year_value = 0;
+    title_key.clear();
+    clear_authors();
+    clear_extra_fields();
+}
 
-    // Allocate authors array using malloc for consistency
-    if (!authors) {
-        authors = (Author*)malloc(sizeof(Author) * MAX_AUTHORS);
-        if (authors) {
-            // Initialize each Author object using placement new
-            for (int i = 0; i < MAX_AUTHORS; i++) {
-                new (&authors[i]) Author();
-            }
+void BibEntry::update_year_key() {
+    year_value = 0;
+    for (unsigned long i = 0; i < year.length(); i++) {
+        char c = year[i];
+        if (c < '0' || c > '9') {
+            year_value = 0; // Invalid year format
+            return;
         }
+        year_value = year_value * 10 + (c - '0');
     }
 }
 
+void BibEntry::update_title_key() {
+    title_key = make_title_key(title);
+}
+
+// Case-folds a title and drops LaTeX grouping braces, so that
+// "{TileClipper}: ..." and "tileclipper: ..." sort together
+MyString BibEntry::make_title_key(const MyStringView& entry_title) {
+    MyString key;
+    unsigned long start = 0;
+    for (unsigned long i = 0; i <= entry_title.length(); i++) {
+        if (i == entry_title.length() || entry_title[i] == '{' || entry_title[i] == '}') {
+            key.append(entry_title.data() + start, i - start);
+            start = i + 1;
+        }
+    }
+    key.to_lower();
+    return key;
+}
+
+// Grows the authors array to hold at least capacity authors.
+// Only the first author_count slots are ever constructed.
+bool BibEntry::reserve_authors(int capacity) {
+    if (capacity <= author_capacity) return true;
+
+    Author* new_authors = (Author*)malloc(sizeof(Author) * capacity);
+    if (!new_authors) return false;
+
+    for (int i = 0; i < author_count; i++) {
+        new (&new_authors[i]) Author(my_move(authors[i]));
+        authors[i].~Author();
+    }
+    if (authors) free(authors);
+
+    authors = new_authors;
+    author_capacity = capacity;
+    return true;
+}
+
+bool BibEntry::reserve_extra_fields(int capacity) {
+    if (capacity <= extra_field_capacity) return true;
+
+    ExtraField* new_fields = (ExtraField*)malloc(sizeof(ExtraField) * capacity);
+    if (!new_fields) return false;
+
+    for (int i = 0; i < extra_field_count; i++) {
+        new (&new_fields[i]) ExtraField(my_move(extra_fields[i]));
+        extra_fields[i].~ExtraField();
+    }
+    if (extra_fields) free(extra_fields);
+
+    extra_fields = new_fields;
+    extra_field_capacity = capacity;
+    return true;
+}
+
+void BibEntry::clear_extra_fields() {
+    if (extra_fields) {
+        for (int i = 0; i < extra_field_count; i++) {
+            extra_fields[i].~ExtraField();
+        }
+        free(extra_fields);
+        extra_fields = nullptr;
+    }
+    extra_field_count = 0;
+    extra_field_capacity = 0;
+}
+
+// Maps a lowercase field name to its member: a switch on the length, then
+// on the first character, leaves at most one candidate to compare
+BibEntry::FieldId BibEntry::lookup_field(const char* name, unsigned long length) {
+    switch (length) {
+    case 3:
+        if (memcmp(name, "doi", 3) == 0) return FIELD_DOI;
+        if (memcmp(name, "pdf", 3) == 0) return FIELD_PDF;
+        if (memcmp(name, "ppt", 3) == 0) return FIELD_PPT;
+        break;
+    case 4:
+        switch (name[0]) {
+        case 'y': if (memcmp(name, "year", 4) == 0) return FIELD_YEAR; break;
+        case 'c': if (memcmp(name, "code", 4) == 0) return FIELD_CODE; break;
+        case 'a': if (memcmp(name, "abbr", 4) == 0) return FIELD_ABBR; break;
+        }
+        break;
+    case 5:
+        switch (name[0]) {
+        case 't': if (memcmp(name, "title", 5) == 0) return FIELD_TITLE; break;
+        case 'p': if (memcmp(name, "pages", 5) == 0) return FIELD_PAGES; break;
+        }
+        break;
+    case 6:
+        switch (name[0]) {
+        case 'a': if (memcmp(name, "author", 6) == 0) return FIELD_AUTHOR; break;
+        case 'v': if (memcmp(name, "volume", 6) == 0) return FIELD_VOLUME; break;
+        case 'n': if (memcmp(name, "number", 6) == 0) return FIELD_NUMBER; break;
+        }
+        break;
+    case 7:
+        switch (name[0]) {
+        case 'j': if (memcmp(name, "journal", 7) == 0) return FIELD_JOURNAL; break;
+        case 'a': if (memcmp(name, "address", 7) == 0) return FIELD_ADDRESS; break;
+        }
+        break;
+    case 8:
+        if (memcmp(name, "abstract", 8) == 0) return FIELD_ABSTRACT;
+        break;
+    case 9:
+        switch (name[0]) {
+        case 'b': if (memcmp(name, "booktitle", 9) == 0) return FIELD_BOOKTITLE; break;
+        case 'p': if (memcmp(name, "publisher", 9) == 0) return FIELD_PUBLISHER; break;
+        }
+        break;
+    }
+    return FIELD_UNKNOWN;
+}
+
 // Assignment operator - FIXED
 BibEntry& BibEntry::operator=(const BibEntry& other) {
     if (this != &other) {
@@ -80,43 +228,80 @@ BibEntry& BibEntry::operator=(const BibEntry& other) {
         number = other.number;
         publisher = other.publisher;
         address = other.address;
-
-        // Clear existing authors first
-        author_count = 0;
-
-        // Ensure we have authors array allocated
-        if (!authors) {
-            authors = (Author*)malloc(sizeof(Author) * MAX_AUTHORS);
-            if (authors) {
-                for (int i = 0; i < MAX_AUTHORS; i++) {
-                    new (&authors[i]) Author();
-                }
+        year_value = other.year_value;
+        title_key = other.title_key;
+
+        // Replace authors with an exactly sized copy
+        clear_authors();
+        if (other.author_count > 0 && reserve_authors(other.author_count)) {
+            for (int i = 0; i < other.author_count; i++) {
+                new (&authors[i]) Author(other.authors[i]);
             }
+            author_count = other.author_count;
         }
 
-        // Copy authors
-        if (authors && other.authors) {
-            author_count = other.author_count;
-            for (int i = 0; i < author_count && i < MAX_AUTHORS; i++) {
-                authors[i] = other.authors[i];
+        clear_extra_fields();
+        if (other.extra_field_count > 0 && reserve_extra_fields(other.extra_field_count)) {
+            for (int i = 0; i < other.extra_field_count; i++) {
+                new (&extra_fields[i]) ExtraField(other.extra_fields[i]);
             }
+            extra_field_count = other.extra_field_count;
         }
     }
     return *this;
 }
 
+BibEntry& BibEntry::operator=(BibEntry&& other) {
+    if (this != &other) {
+        entry_type = my_move(other.entry_type);
+        entry_key = my_move(other.entry_key);
+        title = my_move(other.title);
+        year = my_move(other.year);
+        booktitle = my_move(other.booktitle);
+        journal = my_move(other.journal);
+        doi = my_move(other.doi);
+        abstract = my_move(other.abstract);
+        pdf_url = my_move(other.pdf_url);
+        code_url = my_move(other.code_url);
+        ppt_url = my_move(other.ppt_url);
+        abbr = my_move(other.abbr);
+        pages = my_move(other.pages);
+        volume = my_move(other.volume);
+        number = my_move(other.number);
+        publisher = my_move(other.publisher);
+        address = my_move(other.address);
+        year_value = other.year_value;
+        title_key = my_move(other.title_key);
+
+        // Release our author array and take over the other one
+        clear_authors();
+        authors = other.authors;
+        author_count = other.author_count;
+        author_capacity = other.author_capacity;
+        other.authors = nullptr;
+        other.author_count = 0;
+        other.author_capacity = 0;
+
+        clear_extra_fields();
+        extra_fields = other.extra_fields;
+        extra_field_count = other.extra_field_count;
+        extra_field_capacity = other.extra_field_capacity;
+        other.extra_fields = nullptr;
+        other.extra_field_count = 0;
+        other.extra_field_capacity = 0;
+    }
+    return *this;
+}
+
 // Comparison operators for sorting by <year descending, title ascending>
 bool BibEntry::operator<(const BibEntry& other) const {
-    int this_year = get_year_as_int();
-    int other_year = other.get_year_as_int();
-
     // First sort by year in descending order (newer years first)
-    if (this_year != other_year) {
-        return this_year > other_year; // Note: > for descending order
+    if (year_value != other.year_value) {
+        return year_value > other.year_value; // Note: > for descending order
     }
 
-    // If years are equal, sort by title alphabetically (ascending)
-    return title < other.title;
+    // If years are equal, sort by normalized title alphabetically (ascending)
+    return title_key < other.title_key;
 }
 
 bool BibEntry::operator>(const BibEntry& other) const {
@@ -136,13 +321,21 @@ const MyString& BibEntry::get_entry_type() const { return entry_type; }
 const MyString& BibEntry::get_entry_key() const { return entry_key; }
 const MyString& BibEntry::get_title() const { return title; }
 const MyString& BibEntry::get_year() const { return year; }
-const MyString& BibEntry::get_booktitle() const { return booktitle; }
-const MyString& BibEntry::get_journal() const { return journal; }
+const MyString& BibEntry::get_booktitle() const { return booktitle.str(); }
+const MyString& BibEntry::get_journal() const { return journal.str(); }
 const MyString& BibEntry::get_doi() const { return doi; }
 const MyString& BibEntry::get_abstract() const { return abstract; }
 const MyString& BibEntry::get_pdf_url() const { return pdf_url; }
 const MyString& BibEntry::get_code_url() const { return code_url; }
 const MyString& BibEntry::get_ppt_url() const { return ppt_url; }
+const MyString& BibEntry::get_abbr() const { return abbr; }
+const MyString& BibEntry::get_pages() const { return pages; }
+const MyString& BibEntry::get_volume() const { return volume; }
+const MyString& BibEntry::get_number() const { return number; }
+const MyString& BibEntry::get_publisher() const { return publisher; }
+const MyString& BibEntry::get_address() const { return address; }
+const InternedString& BibEntry::get_interned_booktitle() const { return booktitle; }
+const InternedString& BibEntry::get_interned_journal() const { return journal; }
 int BibEntry::get_author_count() const { return author_count; }
 
 const Author& BibEntry::get_author(int index) const {
@@ -156,14 +349,18 @@ const Author& BibEntry::get_author(int index) const {
 // Mutators
 void BibEntry::set_entry_type(const MyString& type) { entry_type = type; }
 void BibEntry::set_entry_key(const MyString& key) { entry_key = key; }
-void BibEntry::set_title(const MyString& entry_title) { title = entry_title; }
+void BibEntry::set_title(const MyString& entry_title) {
+    title = entry_title;
+    update_title_key();
+}
 void BibEntry::set_year(const MyString& entry_year) { 
     if (validate_year(entry_year)) {
         year = entry_year; 
+        update_year_key();
     }
 }
-void BibEntry::set_booktitle(const MyString& entry_booktitle) { booktitle = entry_booktitle; }
-void BibEntry::set_journal(const MyString& entry_journal) { journal = entry_journal; }
+void BibEntry::set_booktitle(const MyString& entry_booktitle) { booktitle = InternedString(entry_booktitle); }
+void BibEntry::set_journal(const MyString& entry_journal) { journal = InternedString(entry_journal); }
 void BibEntry::set_doi(const MyString& entry_doi) { 
     if (validate_doi(entry_doi)) {
         doi = entry_doi; 
@@ -188,16 +385,22 @@ void BibEntry::set_ppt_url(const MyString& url) {
 
 // Author management - FIXED
 void BibEntry::add_author(const Author& author) {
-    if (author_count < MAX_AUTHORS && authors) {
-        authors[author_count] = author;
-        author_count++;
+    add_author(Author(author));
+}
+
+void BibEntry::add_author(Author&& author) {
+    if (author_count == author_capacity &&
+        !reserve_authors(author_capacity == 0 ? 4 : author_capacity * 2)) {
+        return;
     }
+    new (&authors[author_count]) Author(my_move(author));
+    author_count++;
 }
 
 void BibEntry::clear_authors() {
     if (authors) {
-        // Call destructors for each Author object
-        for (int i = 0; i < MAX_AUTHORS; i++) {
+        // Call destructors for the constructed Author objects
+        for (int i = 0; i < author_count; i++) {
             authors[i].~Author();
         }
         // Free the memory using free() since we allocated with malloc()
@@ -205,13 +408,19 @@ void BibEntry::clear_authors() {
         authors = nullptr;
     }
     author_count = 0;
+    author_capacity = 0;
 }
 
 int BibEntry::count_institute_authors(const MyString& institute_name) const {
+    InstituteMatcher institute(institute_name);
+    return count_institute_authors(institute);
+}
+
+int BibEntry::count_institute_authors(const InstituteMatcher& institute) const {
     int count = 0;
     if (authors) {
         for (int i = 0; i < author_count; i++) {
-            if (authors[i].is_from_institute(institute_name)) {
+            if (authors[i].is_from_institute(institute)) {
                 count++;
             }
         }
@@ -221,150 +430,228 @@ int BibEntry::count_institute_authors(const MyString& institute_name) const {
 
 // Parsing methods
 bool BibEntry::parse_entry_header(const MyString& header_line) {
-    MyString line = header_line;
-    line.trim();
+    return parse_entry_header(MyStringView(header_line));
+}
+
+bool BibEntry::parse_entry_header(const MyStringView& header_line) {
+    MyStringView line = header_line.trimmed();
 
     if (line.empty() || line[0] != '@') {
         return false;
     }
 
     // Find the opening brace
-    unsigned long brace_pos = line.find("{");
+    unsigned long brace_pos = line.find('{');
     if (brace_pos == line.length()) {
         return false;
     }
 
     // Extract entry type
-    entry_type = line.substr(1, brace_pos - 1);
-    entry_type.trim();
+    entry_type = line.substr(1, brace_pos - 1).trimmed().to_string();
     entry_type.to_lower();
 
-    // Extract entry key
+    // Extract entry key - up to the comma, or the closing brace if there is none
     unsigned long key_start = brace_pos + 1;
-    unsigned long comma_pos = line.find(",", key_start);
-    if (comma_pos == line.length()) {
-        // No comma found, key extends to end or closing brace
-        unsigned long close_brace = line.find("}", key_start);
-        if (close_brace != line.length()) {
-            entry_key = line.substr(key_start, close_brace - key_start);
-        } else {
-            entry_key = line.substr(key_start);
-        }
-    } else {
-        entry_key = line.substr(key_start, comma_pos - key_start);
+    unsigned long key_end = line.find(',', key_start);
+    if (key_end == line.length()) {
+        key_end = line.find('}', key_start);
     }
-
-    entry_key.trim();
+    entry_key = line.substr(key_start, key_end - key_start).trimmed().to_string();
 
     return !entry_type.empty() && !entry_key.empty();
 }
 
 bool BibEntry::parse_field_line(const MyString& field_line) {
+    return parse_field_line(MyStringView(field_line));
+}
+
+bool BibEntry::parse_field_line(const MyStringView& field_line) {
     MyString field_name, field_value;
     if (!parse_field_value(field_line, field_name, field_value)) {
         return false;
     }
 
-    set_field(field_name, field_value);
+    set_field(field_name, my_move(field_value));
     return true;
 }
 
 bool BibEntry::parse_field_value(const MyString& line, MyString& field_name, MyString& field_value) {
-    MyString trimmed_line = line;
-    trimmed_line.trim();
+    return parse_field_value(MyStringView(line), field_name, field_value);
+}
+
+bool BibEntry::parse_field_value(const MyStringView& line, MyString& field_name, MyString& field_value) {
+    MyStringView trimmed_line = line.trimmed();
 
     if (trimmed_line.empty()) {
         return false;
     }
 
     // Find the equals sign
-    unsigned long equals_pos = trimmed_line.find("=");
+    unsigned long equals_pos = trimmed_line.find('=');
     if (equals_pos == trimmed_line.length()) {
         return false;
     }
 
     // Extract field name
-    field_name = trimmed_line.substr(0, equals_pos);
-    field_name.trim();
-    field_name.to_lower();
+    MyStringView name = trimmed_line.substr(0, equals_pos).trimmed();
 
     // Extract field value
-    field_value = trimmed_line.substr(equals_pos + 1);
-    field_value.trim();
+    MyStringView value = trimmed_line.substr(equals_pos + 1).trimmed();
 
     // Remove trailing comma if present
-    if (!field_value.empty() && field_value[field_value.length() - 1] == ',') {
-        field_value = field_value.substr(0, field_value.length() - 1);
-        field_value.trim();
+    if (value.ends_with(",")) {
+        value.remove_suffix(1);
+        value.trim();
     }
 
     // Remove braces if present
-    if (!field_value.empty() && field_value[0] == '{') {
-        field_value = field_value.substr(1);
-        if (!field_value.empty() && field_value[field_value.length() - 1] == '}') {
-            field_value = field_value.substr(0, field_value.length() - 1);
+    if (value.starts_with("{")) {
+        value.remove_prefix(1);
+        if (value.ends_with("}")) {
+            value.remove_suffix(1);
         }
     }
+    value.trim();
+
+    // Only the final name and value are materialized
+    field_name = name.to_string();
+    field_name.to_lower();
+    field_value = value.to_string();
 
-    field_value.trim();
     return !field_name.empty();
 }
 
-void BibEntry::set_field(const MyString& field_name, const MyString& field_value) {
-    if (field_name == "title") {
-        title = field_value;
-    } else if (field_name == "author") {
-        // Parse authors
-        Author temp_authors[MAX_AUTHORS];
-        int temp_count;
-        if (Author::parse_author_field(field_value, temp_authors, MAX_AUTHORS, temp_count)) {
-            // Reset author count but don't reallocate array
-            author_count = 0;
-            
-            // Ensure we have authors array allocated
-            if (!authors) {
-                authors = (Author*)malloc(sizeof(Author) * MAX_AUTHORS);
-                if (authors) {
-                    for (int i = 0; i < MAX_AUTHORS; i++) {
-                        new (&authors[i]) Author();
-                    }
+void BibEntry::set_field(const MyString& field_name, MyString&& field_value, InternPool* pool) {
+    switch (lookup_field(field_name.c_str(), field_name.length())) {
+    case FIELD_TITLE:
+        title = my_move(field_value);
+        update_title_key();
+        break;
+    case FIELD_AUTHOR: {
+        // Parse authors straight into an array sized to the author count
+        MyStringView remaining = Author::author_list(field_value);
+        int count = Author::count_authors(remaining);
+        if (count > 0) {
+            clear_authors();
+            reserve_authors(count);
+
+            MyStringView author_name;
+            while (Author::next_author_name(remaining, author_name)) {
+                if (pool) {
+                    add_author(Author(pool->intern(author_name)));
+                } else {
+                    add_author(Author(author_name.to_string()));
                 }
             }
-            
-            // Add parsed authors
-            for (int i = 0; i < temp_count && i < MAX_AUTHORS; i++) {
-                add_author(temp_authors[i]);
-            }
         }
-    } else if (field_name == "year") {
+        break;
+    }
+    case FIELD_YEAR:
         set_year(field_value);
-    } else if (field_name == "booktitle") {
-        booktitle = field_value;
-    } else if (field_name == "journal") {
-        journal = field_value;
-    } else if (field_name == "doi") {
-        set_doi(field_value);
-    } else if (field_name == "abstract") {
-        abstract = field_value;
-    } else if (field_name == "pdf") {
-        set_pdf_url(field_value);
-    } else if (field_name == "code") {
-        set_code_url(field_value);
-    } else if (field_name == "ppt") {
-        set_ppt_url(field_value);
-    } else if (field_name == "abbr") {
-        abbr = field_value;
-    } else if (field_name == "pages") {
-        pages = field_value;
-    } else if (field_name == "volume") {
-        volume = field_value;
-    } else if (field_name == "number") {
-        number = field_value;
-    } else if (field_name == "publisher") {
-        publisher = field_value;
-    } else if (field_name == "address") {
-        address = field_value;
+        break;
+    case FIELD_BOOKTITLE:
+        booktitle = pool ? pool->intern(MyStringView(field_value)) : InternedString(field_value);
+        break;
+    case FIELD_JOURNAL:
+        journal = pool ? pool->intern(MyStringView(field_value)) : InternedString(field_value);
+        break;
+    case FIELD_DOI:
+        if (validate_doi(field_value)) {
+            doi = my_move(field_value);
+        }
+        break;
+    case FIELD_ABSTRACT:
+        abstract = my_move(field_value);
+        break;
+    case FIELD_PDF:
+        if (validate_url(field_value)) {
+            pdf_url = my_move(field_value);
+        }
+        break;
+    case FIELD_CODE:
+        if (validate_url(field_value)) {
+            code_url = my_move(field_value);
+        }
+        break;
+    case FIELD_PPT:
+        if (validate_url(field_value)) {
+            ppt_url = my_move(field_value);
+        }
+        break;
+    case FIELD_ABBR:
+        abbr = my_move(field_value);
+        break;
+    case FIELD_PAGES:
+        pages = my_move(field_value);
+        break;
+    case FIELD_VOLUME:
+        volume = my_move(field_value);
+        break;
+    case FIELD_NUMBER:
+        number = my_move(field_value);
+        break;
+    case FIELD_PUBLISHER:
+        publisher = my_move(field_value);
+        break;
+    case FIELD_ADDRESS:
+        address = my_move(field_value);
+        break;
+    case FIELD_UNKNOWN:
+        set_extra_field(field_name, my_move(field_value));
+        break;
+    }
+}
+
+void BibEntry::intern_strings(InternPool& pool) {
+    pool.intern(booktitle);
+    pool.intern(journal);
+    for (int i = 0; i < author_count; i++) {
+        authors[i].intern(pool);
+    }
+}
+
+bool BibEntry::same_venue(const BibEntry& other) const {
+    return booktitle == other.booktitle && journal == other.journal;
+}
+
+// Extra fields
+void BibEntry::set_extra_field(const MyString& field_name, MyString&& field_value) {
+    for (int i = 0; i < extra_field_count; i++) {
+        if (extra_fields[i].name == field_name) {
+            extra_fields[i].value = my_move(field_value);
+            return;
+        }
+    }
+
+    if (extra_field_count == extra_field_capacity &&
+        !reserve_extra_fields(extra_field_capacity == 0 ? 2 : extra_field_capacity * 2)) {
+        return;
+    }
+    new (&extra_fields[extra_field_count]) ExtraField();
+    extra_fields[extra_field_count].name = field_name;
+    extra_fields[extra_field_count].value = my_move(field_value);
+    extra_field_count++;
+}
+
+int BibEntry::get_extra_field_count() const {
+    return extra_field_count;
+}
+
+const BibEntry::ExtraField& BibEntry::get_extra_field(int index) const {
+    static ExtraField empty_field; // Returned for an invalid index
+    if (index >= 0 && index < extra_field_count) {
+        return extra_fields[index];
+    }
+    return empty_field;
+}
+
+const MyString* BibEntry::find_extra_field(const MyStringView& field_name) const {
+    for (int i = 0; i < extra_field_count; i++) {
+        if (MyStringView(extra_fields[i].name) == field_name) {
+            return &extra_fields[i].value;
+        }
     }
+    return nullptr;
 }
 
 // Validation methods
@@ -433,13 +720,13 @@ MyString BibEntry::to_string() const {
 
     if (!booktitle.empty()) {
         result += "  booktitle = {";
-        result += booktitle;
+        result += booktitle.str();
         result += "},\n";
     }
 
     if (!journal.empty()) {
         result += "  journal = {";
-        result += journal;
+        result += journal.str();
         result += "},\n";
     }
 
@@ -467,6 +754,14 @@ MyString BibEntry::to_string() const {
         result += "},\n";
     }
 
+    for (int i = 0; i < extra_field_count; i++) {
+        result += "  ";
+        result += extra_fields[i].name;
+        result += " = {";
+        result += extra_fields[i].value;
+        result += "},\n";
+    }
+
     if (!abstract.empty()) {
         result += "  abstract = {";
         // Truncate abstract for display
@@ -483,11 +778,78 @@ MyString BibEntry::to_string() const {
     return result;
 }
 
+// One "  name = {value},\n" line; prefix is everything up to the brace
+static void write_field(BufferedWriter& out, const char* prefix, const char* value,
+                        unsigned long length) {
+    out.write(prefix, MyString::strlen(prefix));
+    out.write(value, length);
+    out.write("},\n", 3);
+}
+
+static void write_field(BufferedWriter& out, const char* prefix, const MyString& value) {
+    if (!value.empty()) write_field(out, prefix, value.c_str(), value.length());
+}
+
+bool BibEntry::write_to(BufferedWriter& out) const {
+    out.put('@');
+    out.write(entry_type);
+    out.put('{');
+    out.write(entry_key);
+    out.write(",\n", 2);
+
+    write_field(out, "  title = {", title);
+
+    if (author_count > 0) {
+        out.write("  author = {", 12);
+        out.write(authors[0].get_name());
+        for (int i = 1; i < author_count; i++) {
+            out.write(" and ", 5);
+            out.write(authors[i].get_name());
+        }
+        out.write("},\n", 3);
+    }
+
+    write_field(out, "  year = {", year);
+    write_field(out, "  booktitle = {", booktitle.str());
+    write_field(out, "  journal = {", journal.str());
+    write_field(out, "  doi = {", doi);
+    write_field(out, "  pdf = {", pdf_url);
+    write_field(out, "  code = {", code_url);
+    write_field(out, "  ppt = {", ppt_url);
+
+    for (int i = 0; i < extra_field_count; i++) {
+        out.write("  ", 2);
+        out.write(extra_fields[i].name);
+        out.write(" = {", 4);
+        out.write(extra_fields[i].value);
+        out.write("},\n", 3);
+    }
+
+    if (!abstract.empty()) {
+        // Truncated like to_string()
+        if (abstract.length() > 100) {
+            out.write("  abstract = {", 14);
+            out.write(abstract.c_str(), 100);
+            out.write("...},\n", 6);
+        } else {
+            write_field(out, "  abstract = {", abstract);
+        }
+    }
+
+    return out.write("}\n", 2);
+}
+
 MyString BibEntry::get_formatted_authors() const {
     if (author_count == 0 || !authors) return MyString();
 
-    MyString result = authors[0].get_name();
+    unsigned long total = 0;
+    for (int i = 0; i < author_count; i++) {
+        total += authors[i].get_name().length() + 5;
+    }
 
+    MyString result;
+    result.reserve(total);
+    result += authors[0].get_name();
     for (int i = 1; i < author_count; i++) {
         result += " and ";
         result += authors[i].get_name();
@@ -506,17 +868,9 @@ void BibEntry::clear() {
 }
 
 int BibEntry::get_year_as_int() const {
-    if (year.empty()) return 0;
-
-    int result = 0;
-    for (unsigned long i = 0; i < year.length(); i++) {
-        char c = year[i];
-        if (c >= '0' && c <= '9') {
-            result = result * 10 + (c - '0');
-        } else {
-            return 0; // Invalid year format
-        }
-    }
+    return year_value;
+}
 
-    return result;
-}
\ No newline at end of file
+const MyString& BibEntry::get_title_key() const {
+    return title_key;
+}
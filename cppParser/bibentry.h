@@ -3,18 +3,38 @@
 #define BIBENTRY_H
 
 #include "mystring.h"
+#include "mystringview.h"
+#include "myutility.h"
+#include "internpool.h"
 
 // Forward declaration to avoid circular includes
 class Author;
+class InstituteMatcher;
+class BufferedWriter;
 
 class BibEntry {
+public:
+    // A field without a dedicated member (url, keywords, month, note...)
+    struct ExtraField {
+        MyString name;      // Lowercase
+        MyString value;
+    };
+
 private:
+    // Fields with a dedicated member, found by lookup_field()
+    enum FieldId {
+        FIELD_UNKNOWN,
+        FIELD_TITLE, FIELD_AUTHOR, FIELD_YEAR, FIELD_BOOKTITLE, FIELD_JOURNAL,
+        FIELD_DOI, FIELD_ABSTRACT, FIELD_PDF, FIELD_CODE, FIELD_PPT,
+        FIELD_ABBR, FIELD_PAGES, FIELD_VOLUME, FIELD_NUMBER, FIELD_PUBLISHER, FIELD_ADDRESS
+    };
+
     MyString entry_type;    // @inproceedings, @article, etc.
     MyString entry_key;     // Citation key
     MyString title;
     MyString year;
-    MyString booktitle;
-    MyString journal;
+    InternedString booktitle;   // Venues repeat across entries; shared once interned
+    InternedString journal;
     MyString doi;
     MyString abstract;
 
@@ -23,10 +43,10 @@ private:
     MyString code_url;
     MyString ppt_url;
 
-    // Authors array
-    static const int MAX_AUTHORS = 100;
-    Author* authors;  // Will be allocated dynamically
+    // Authors array, sized to the number of authors (null when there are none)
+    Author* authors;
     int author_count;
+    int author_capacity;
 
     // Additional fields
     MyString abbr;
@@ -36,22 +56,39 @@ private:
     MyString publisher;
     MyString address;
 
+    // Every other field, in input order (null when there are none)
+    ExtraField* extra_fields;
+    int extra_field_count;
+    int extra_field_capacity;
+
+    // Precomputed sort keys, kept in sync with year and title
+    int year_value;         // 0 when the year is missing
+    MyString title_key;     // Title case-folded with LaTeX braces removed
+
     // Private helper methods
     void initialize();
+    void update_year_key();
+    void update_title_key();
+    bool reserve_authors(int capacity);
+    bool reserve_extra_fields(int capacity);
+    void clear_extra_fields();
+    static FieldId lookup_field(const char* name, unsigned long length);
     bool parse_field_value(const MyString& line, MyString& field_name, MyString& field_value);
-    void set_field(const MyString& field_name, const MyString& field_value);
+    bool parse_field_value(const MyStringView& line, MyString& field_name, MyString& field_value);
 
 public:
     // Constructors
     BibEntry();
     BibEntry(const MyString& key);
     BibEntry(const BibEntry& other);
+    BibEntry(BibEntry&& other);
 
     // Destructor
     ~BibEntry();
 
     // Assignment operator
     BibEntry& operator=(const BibEntry& other);
+    BibEntry& operator=(BibEntry&& other);
 
     // Comparison operators for sorting by <year, alphabetical>
     bool operator<(const BibEntry& other) const;
@@ -71,6 +108,14 @@ public:
     const MyString& get_pdf_url() const;
     const MyString& get_code_url() const;
     const MyString& get_ppt_url() const;
+    const MyString& get_abbr() const;
+    const MyString& get_pages() const;
+    const MyString& get_volume() const;
+    const MyString& get_number() const;
+    const MyString& get_publisher() const;
+    const MyString& get_address() const;
+    const InternedString& get_interned_booktitle() const;
+    const InternedString& get_interned_journal() const;
     int get_author_count() const;
     const Author& get_author(int index) const;
 
@@ -89,23 +134,54 @@ public:
 
     // Author management
     void add_author(const Author& author);
+    void add_author(Author&& author);
     void clear_authors();
     int count_institute_authors(const MyString& institute_name) const;
+    int count_institute_authors(const InstituteMatcher& institute) const;
 
     // Parsing methods
     bool parse_entry_header(const MyString& header_line);
     bool parse_field_line(const MyString& field_line);
+
+    // View overloads - parse in place; only the values that end up stored are copied
+    bool parse_entry_header(const MyStringView& header_line);
+    bool parse_field_line(const MyStringView& field_line);
+
+    // Stores an already parsed field value; field_name must be lowercase.
+    // Names without a member are kept as extra fields. With a pool, author
+    // names and venues are interned straight from the parsed text.
+    void set_field(const MyString& field_name, MyString&& field_value, InternPool* pool = nullptr);
+
+    // Replaces author names and venues with the pool's shared copies
+    void intern_strings(InternPool& pool);
+
+    // Same booktitle and journal (integer compares for entries interned
+    // in the same pool)
+    bool same_venue(const BibEntry& other) const;
+
+    // Extra fields (a later value for the same name replaces the earlier one)
+    void set_extra_field(const MyString& field_name, MyString&& field_value);
+    int get_extra_field_count() const;
+    const ExtraField& get_extra_field(int index) const;
+    const MyString* find_extra_field(const MyStringView& field_name) const; // Null if absent
+
     bool is_valid() const;
 
     // Utility methods
     MyString to_string() const;
+    // Writes the to_string() text straight into out, without building it
+    bool write_to(BufferedWriter& out) const;
     MyString get_formatted_authors() const;
     bool empty() const;
     void clear();
 
-    // Year conversion utility
+    // Year conversion utility (cached)
     int get_year_as_int() const;
 
+    // Sort keys used by operator< and BibDatabase::sort_entries()
+    const MyString& get_title_key() const;
+    static MyString make_title_key(const MyStringView& entry_title);
+
     // Validation
     bool validate_year(const MyString& year_str) const;
     bool validate_doi(const MyString& doi_str) const;
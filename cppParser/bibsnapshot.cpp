@@ -0,0 +1,67 @@
+// bibsnapshot.cpp - Source file stamps for BibDatabase snapshots
+#include "bibsnapshot.h"
+#include "mappedfile.h"
+#include "mystring.h"
+
+// Layout-compatible with the kernel's struct statx, which is the same on
+// every architecture
+struct StampStatx {
+    unsigned int mask, blksize;
+    unsigned long attributes;
+    unsigned int nlink, uid, gid;
+    unsigned short mode, spare0;
+    unsigned long ino, size, blocks, attributes_mask;
+    struct Timestamp {
+        long seconds;
+        unsigned int nanoseconds;
+        int reserved;
+    } atime, btime, ctime, mtime;
+    unsigned long spare[16];
+};
+
+extern "C" {
+    int statx(int dirfd, const char* path, int flags, unsigned int mask, StampStatx* result);
+}
+
+#ifndef AT_FDCWD
+#define AT_FDCWD -100
+#endif
+#ifndef STATX_MTIME
+#define STATX_MTIME 0x40U
+#endif
+#ifndef STATX_SIZE
+#define STATX_SIZE 0x200U
+#endif
+
+SourceStamp::SourceStamp() : size(0), mtime_seconds(0), mtime_nanoseconds(0), hash(0) {}
+
+bool SourceStamp::read(const char* filename) {
+    if (!filename) return false;
+
+    StampStatx result;
+    if (statx(AT_FDCWD, filename, 0, STATX_SIZE | STATX_MTIME, &result) != 0) return false;
+    if ((result.mask & (STATX_SIZE | STATX_MTIME)) != (STATX_SIZE | STATX_MTIME)) return false;
+
+    size = result.size;
+    mtime_seconds = result.mtime.seconds;
+    mtime_nanoseconds = result.mtime.nanoseconds;
+    return true;
+}
+
+bool SourceStamp::capture(const char* filename) {
+    if (!read(filename)) return false;
+
+    MappedFile file;
+    if (!file.open(filename) || file.size() != size) return false;
+    hash = MyString::hash_bytes(file.get_data(), file.size());
+    return true;
+}
+
+bool SourceStamp::matches(const char* filename) const {
+    SourceStamp current;
+    if (!current.read(filename) || current.size != size) return false;
+    if (current.mtime_seconds == mtime_seconds && current.mtime_nanoseconds == mtime_nanoseconds) {
+        return true;
+    }
+    return current.capture(filename) && current.size == size && current.hash == hash;
+}
@@ -0,0 +1,92 @@
+// bibsnapshot.h - On-disk layout of BibDatabase snapshots
+#ifndef BIBSNAPSHOT_H
+#define BIBSNAPSHOT_H
+
+// A snapshot is a BibDatabase written in binary so it can be mapped and
+// turned back into entries without parsing any BibTeX:
+//
+//   SnapshotHeader
+//   SnapshotEntry[entry_count]     fixed-width, in database order
+//   SnapshotAuthor[author_count]   entry i owns [first_author, first_author + author_count)
+//   SnapshotExtra[extra_count]     likewise for extra fields
+//   string blob                    every string followed by '\0', back to back
+//
+// All sections are 8-byte aligned and stored in native byte order; the
+// byte_order marker and header_size reject snapshots from another
+// architecture or an older layout. Interned author names and venues are
+// stored once and shared by every record that uses them. The terminators
+// let loaded strings point straight into a mapping of the blob.
+
+static const unsigned int SNAPSHOT_VERSION = 1;
+static const unsigned long SNAPSHOT_BYTE_ORDER = 0x0102030405060708UL;
+
+// Identity of the source .bib file a snapshot was built from
+struct SourceStamp {
+    unsigned long size;
+    long mtime_seconds;
+    long mtime_nanoseconds;
+    unsigned long hash;         // FNV-1a of the contents
+
+    SourceStamp();
+
+    // Size and modification time only; false if the file cannot be examined
+    bool read(const char* filename);
+
+    // Everything including the content hash
+    bool capture(const char* filename);
+
+    // Same size and mtime, or (for a touched but unchanged file) the same
+    // size and contents
+    bool matches(const char* filename) const;
+};
+
+struct SnapshotHeader {
+    char magic[8];              // "BIBSNAP" and a terminator
+    unsigned int version;
+    unsigned int header_size;   // sizeof(SnapshotHeader)
+    unsigned long byte_order;   // SNAPSHOT_BYTE_ORDER
+    unsigned long file_size;
+    SourceStamp source;
+    unsigned long entry_count;
+    unsigned long author_count;
+    unsigned long extra_count;
+    unsigned long entries_offset;
+    unsigned long authors_offset;
+    unsigned long extras_offset;
+    unsigned long blob_offset;
+    unsigned long blob_size;
+};
+
+// Byte range in the string blob; empty strings are {0, 0}
+struct SnapshotString {
+    unsigned long offset;
+    unsigned long length;
+};
+
+// Entry strings in record order
+enum SnapshotField {
+    SNAPSHOT_TYPE, SNAPSHOT_KEY, SNAPSHOT_TITLE, SNAPSHOT_YEAR, SNAPSHOT_BOOKTITLE,
+    SNAPSHOT_JOURNAL, SNAPSHOT_DOI, SNAPSHOT_ABSTRACT, SNAPSHOT_PDF, SNAPSHOT_CODE,
+    SNAPSHOT_PPT, SNAPSHOT_ABBR, SNAPSHOT_PAGES, SNAPSHOT_VOLUME, SNAPSHOT_NUMBER,
+    SNAPSHOT_PUBLISHER, SNAPSHOT_ADDRESS, SNAPSHOT_FIELD_COUNT
+};
+
+struct SnapshotEntry {
+    SnapshotString fields[SNAPSHOT_FIELD_COUNT];
+    unsigned long first_author;
+    unsigned long first_extra;
+    unsigned int author_count;
+    unsigned int extra_count;
+};
+
+struct SnapshotAuthor {
+    SnapshotString name;
+    SnapshotString affiliation;
+};
+
+struct SnapshotExtra {
+    SnapshotString name;
+    SnapshotString value;
+};
+
+#endif // BIBSNAPSHOT_H
@@ -0,0 +1,471 @@
+// bibtokenizer.cpp - Implementation of the state-machine BibTeX tokenizer
+#include "bibtokenizer.h"
+#include "placement_new.h"
+#include "myutility.h"
+
+extern "C" {
+    void* memchr(const void* s, int c, unsigned long n);
+}
+
+// Constructor
+BibTokenizer::BibTokenizer(BibTokenHandler* token_handler)
+    : handler(token_handler), state(STATE_TOP), kind(ENTRY_REGULAR), close_char('}'),
+      depth(0), in_quotes(false), in_line_break(false), macro_names(nullptr),
+      macro_values(nullptr), macro_count(0), macro_capacity(0), bytes_fed(0) {}
+
+// Destructor
+BibTokenizer::~BibTokenizer() {
+    for (int i = 0; i < macro_count; i++) {
+        macro_names[i].~MyString();
+        macro_values[i].~MyString();
+    }
+    if (macro_names) free(macro_names);
+    if (macro_values) free(macro_values);
+}
+
+// Private helper methods
+bool BibTokenizer::is_name_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '-' || c == ':' || c == '.' || c == '+' || c == '/';
+}
+
+// Consumes the inside of a {braced} or "quoted" value piece starting at i.
+// Returns the index after the closing delimiter, or length if the piece
+// continues in the next block.
+unsigned long BibTokenizer::scan_delimited(const char* data, unsigned long i, unsigned long length) {
+    bool quoted = state == STATE_QUOTED_VALUE;
+
+    while (i < length) {
+        if (in_line_break) {
+            while (i < length && MyString::isspace(data[i])) i++;
+            if (i == length) return i;
+            in_line_break = false;
+            field_value.append(" ", 1);
+        }
+
+        // Copy the run of ordinary characters in one step; the structural
+        // index skips straight to the next byte that could end it
+        unsigned long run = index.next(i);
+        while (run < length) {
+            char c = data[run];
+            if (c == '{' || c == '}' || c == '\n' || c == '\r' || (quoted && c == '"')) break;
+            run = index.next(run + 1);
+        }
+        field_value.append(data + i, run - i);
+        i = run;
+        if (i == length) return i;
+
+        char c = data[i++];
+        if (c == '\n' || c == '\r') {
+            // Drop the indentation around the line break; one space replaces it
+            field_value.trim();
+            in_line_break = true;
+        } else if (c == '{') {
+            depth++;
+            field_value.append("{", 1);
+        } else if (c == '}') {
+            if (!quoted && depth == 1) {
+                depth = 0;
+                state = STATE_AFTER_VALUE;
+                return i;
+            }
+            if (depth > 0) depth--;
+            field_value.append("}", 1);
+        } else if (depth == 0) {
+            // Closing quote
+            state = STATE_AFTER_VALUE;
+            return i;
+        } else {
+            field_value.append("\"", 1);
+        }
+    }
+    return i;
+}
+
+void BibTokenizer::open_body(char open_char) {
+    close_char = open_char == '{' ? '}' : ')';
+    entry_type.to_lower();
+    depth = 0;
+
+    if (entry_type == "comment" || entry_type == "preamble") {
+        kind = ENTRY_SKIPPED;
+        state = STATE_SKIP_BODY;
+    } else if (entry_type == "string") {
+        kind = ENTRY_STRING;
+        state = STATE_BEFORE_FIELD;
+    } else {
+        kind = ENTRY_REGULAR;
+        entry_key.clear();
+        state = STATE_KEY;
+    }
+}
+
+void BibTokenizer::begin_entry() {
+    state = STATE_BEFORE_FIELD;
+    if (handler) handler->on_entry_begin(entry_type, entry_key);
+}
+
+void BibTokenizer::finish_field() {
+    if (kind == ENTRY_STRING) {
+        // Macro text is spliced into other values, so its spacing is kept
+        define_macro(field_name, field_value);
+    } else if (handler) {
+        field_value.trim();
+        handler->on_field(field_name, field_value);
+    }
+    state = STATE_BEFORE_FIELD;
+}
+
+void BibTokenizer::end_entry() {
+    if (kind == ENTRY_REGULAR && handler) handler->on_entry_end();
+    state = STATE_TOP;
+}
+
+void BibTokenizer::header_error() {
+    if (handler) {
+        MyString message = "Failed to parse entry header: @";
+        message += entry_type;
+        message += close_char == '}' ? "{" : "(";
+        message += entry_key;
+        handler->on_error(message);
+    }
+}
+
+void BibTokenizer::field_error(const char* problem) {
+    if (handler) {
+        MyString message = problem;
+        message += " in entry '";
+        message += kind == ENTRY_STRING ? MyString("@string") : entry_key;
+        message += "'";
+        handler->on_error(message);
+    }
+    depth = 0;
+    in_quotes = false;
+    state = STATE_SKIP_FIELD;
+}
+
+void BibTokenizer::define_macro(const MyString& name, const MyString& value) {
+    // A later definition replaces an earlier one
+    for (int i = 0; i < macro_count; i++) {
+        if (macro_names[i] == name) {
+            macro_values[i] = value;
+            return;
+        }
+    }
+
+    if (macro_count == macro_capacity) {
+        int new_capacity = macro_capacity == 0 ? 8 : macro_capacity * 2;
+        MyString* new_names = (MyString*)malloc(sizeof(MyString) * new_capacity);
+        MyString* new_values = (MyString*)malloc(sizeof(MyString) * new_capacity);
+        if (!new_names || !new_values) {
+            if (new_names) free(new_names);
+            if (new_values) free(new_values);
+            return;
+        }
+        for (int i = 0; i < macro_count; i++) {
+            new (&new_names[i]) MyString(my_move(macro_names[i]));
+            new (&new_values[i]) MyString(my_move(macro_values[i]));
+            macro_names[i].~MyString();
+            macro_values[i].~MyString();
+        }
+        if (macro_names) free(macro_names);
+        if (macro_values) free(macro_values);
+        macro_names = new_names;
+        macro_values = new_values;
+        macro_capacity = new_capacity;
+    }
+
+    new (&macro_names[macro_count]) MyString(name);
+    new (&macro_values[macro_count]) MyString(value);
+    macro_count++;
+}
+
+const MyString* BibTokenizer::find_macro(const MyString& name) const {
+    for (int i = 0; i < macro_count; i++) {
+        if (macro_names[i] == name) return &macro_values[i];
+    }
+    return nullptr;
+}
+
+// Appends a finished bare value piece. Macro names are case-insensitive;
+// numbers and undefined names are kept as written.
+void BibTokenizer::expand_bare_word() {
+    const MyString* expansion = nullptr;
+    if (macro_count > 0) {
+        MyString name = bare_word;
+        name.to_lower();
+        expansion = find_macro(name);
+    }
+    field_value += expansion ? *expansion : bare_word;
+    state = STATE_AFTER_VALUE;
+}
+
+// Input
+void BibTokenizer::feed(const char* data, unsigned long length) {
+    if (!data) return;
+    bytes_fed += length;
+    index.reset(data, length);
+
+    unsigned long i = 0;
+    while (i < length) {
+        char c = data[i];
+
+        switch (state) {
+        case STATE_TOP: {
+            const char* at = (const char*)memchr(data + i, '@', length - i);
+            if (!at) {
+                i = length;
+                break;
+            }
+            i = (unsigned long)(at - data) + 1;
+            entry_type.clear();
+            state = STATE_ENTRY_TYPE;
+            break;
+        }
+
+        case STATE_ENTRY_TYPE: {
+            if (entry_type.empty() && MyString::isspace(c)) {
+                i++;
+                break;
+            }
+            unsigned long run = i;
+            while (run < length && is_name_char(data[run])) run++;
+            entry_type.append(data + i, run - i);
+            i = run;
+            if (i < length) state = STATE_BEFORE_BODY;
+            break;
+        }
+
+        case STATE_BEFORE_BODY:
+            if (MyString::isspace(c)) {
+                i++;
+            } else if ((c == '{' || c == '(') && !entry_type.empty()) {
+                i++;
+                open_body(c);
+            } else {
+                // Not an entry (an e-mail address in a comment, say); rescan c as text
+                state = STATE_TOP;
+            }
+            break;
+
+        case STATE_SKIP_BODY: {
+            while ((i = index.next(i)) < length) {
+                char b = data[i++];
+                if (b == '{') {
+                    depth++;
+                } else if (b == '}' && depth > 0) {
+                    depth--;
+                } else if (b == close_char && depth == 0) {
+                    state = STATE_TOP;
+                    break;
+                }
+            }
+            break;
+        }
+
+        case STATE_KEY: {
+            if (entry_key.empty() && MyString::isspace(c)) {
+                i++;
+                break;
+            }
+            unsigned long run = i;
+            while (run < length) {
+                char k = data[run];
+                if (MyString::isspace(k) || k == ',' || k == '=' || k == close_char) break;
+                run++;
+            }
+            entry_key.append(data + i, run - i);
+            i = run;
+            if (i < length) state = STATE_AFTER_KEY;
+            break;
+        }
+
+        case STATE_AFTER_KEY:
+            if (MyString::isspace(c)) {
+                i++;
+            } else if (entry_key.empty() || c == '=') {
+                // "@misc{" followed by fields or nothing at all
+                header_error();
+                if (c == close_char) {
+                    i++;
+                    state = STATE_TOP;
+                } else {
+                    state = STATE_SKIP_BODY;
+                }
+            } else if (c == ',') {
+                i++;
+                begin_entry();
+            } else if (c == close_char) {
+                i++;
+                begin_entry();
+                end_entry();
+            } else {
+                // Missing comma after the key - start on the first field anyway
+                begin_entry();
+            }
+            break;
+
+        case STATE_BEFORE_FIELD:
+            if (MyString::isspace(c) || c == ',') {
+                i++;
+            } else if (c == close_char) {
+                i++;
+                end_entry();
+            } else if (is_name_char(c)) {
+                field_name.clear();
+                state = STATE_FIELD_NAME;
+            } else {
+                field_error("Unexpected character before field name");
+            }
+            break;
+
+        case STATE_FIELD_NAME: {
+            unsigned long run = i;
+            while (run < length && is_name_char(data[run])) run++;
+            field_name.append(data + i, run - i);
+            i = run;
+            if (i < length) state = STATE_BEFORE_EQUALS;
+            break;
+        }
+
+        case STATE_BEFORE_EQUALS:
+            if (MyString::isspace(c)) {
+                i++;
+            } else if (c == '=') {
+                i++;
+                field_name.to_lower();
+                field_value = ""; // Keeps the buffer if the handler copied the last value
+                state = STATE_BEFORE_VALUE;
+            } else {
+                field_error("Missing '=' after field name");
+            }
+            break;
+
+        case STATE_BEFORE_VALUE:
+            in_line_break = false;
+            if (MyString::isspace(c)) {
+                i++;
+            } else if (c == '{') {
+                i++;
+                depth = 1;
+                state = STATE_BRACED_VALUE;
+            } else if (c == '"') {
+                i++;
+                depth = 0;
+                state = STATE_QUOTED_VALUE;
+            } else if (is_name_char(c)) {
+                bare_word.clear();
+                state = STATE_BARE_VALUE;
+            } else {
+                field_error("Missing field value");
+            }
+            break;
+
+        case STATE_BRACED_VALUE:
+        case STATE_QUOTED_VALUE:
+            i = scan_delimited(data, i, length);
+            break;
+
+        case STATE_BARE_VALUE: {
+            unsigned long run = i;
+            while (run < length && is_name_char(data[run])) run++;
+            bare_word.append(data + i, run - i);
+            i = run;
+            if (i < length) expand_bare_word();
+            break;
+        }
+
+        case STATE_AFTER_VALUE:
+            if (MyString::isspace(c)) {
+                i++;
+            } else if (c == '#') {
+                i++;
+                state = STATE_BEFORE_VALUE;
+            } else if (c == ',') {
+                i++;
+                finish_field();
+            } else if (c == close_char) {
+                i++;
+                finish_field();
+                end_entry();
+            } else {
+                field_error("Unexpected text after field value");
+            }
+            break;
+
+        case STATE_SKIP_FIELD: {
+            while ((i = index.next(i)) < length) {
+                char b = data[i++];
+                if (b == '"' && depth == 0) {
+                    in_quotes = !in_quotes;
+                } else if (b == '{') {
+                    depth++;
+                } else if (b == '}' && depth > 0) {
+                    depth--;
+                } else if (depth == 0 && !in_quotes) {
+                    if (b == ',') {
+                        state = STATE_BEFORE_FIELD;
+                        break;
+                    } else if (b == close_char) {
+                        end_entry();
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+        }
+    }
+}
+
+bool BibTokenizer::finish() {
+    bool clean = true;
+
+    switch (state) {
+    case STATE_TOP:
+    case STATE_ENTRY_TYPE:
+    case STATE_BEFORE_BODY:
+        // Nothing started, or a stray '@' in trailing text
+        break;
+
+    case STATE_SKIP_BODY:
+        clean = false;
+        break;
+
+    case STATE_KEY:
+    case STATE_AFTER_KEY:
+        header_error();
+        clean = false;
+        break;
+
+    default:
+        // Keep the fields that were complete and store what we have
+        clean = false;
+        if (kind == ENTRY_REGULAR && handler) {
+            MyString message = "Unterminated entry '";
+            message += entry_key;
+            message += "' at end of input";
+            handler->on_error(message);
+        }
+        if (state == STATE_BARE_VALUE) expand_bare_word();
+        if (state == STATE_AFTER_VALUE) finish_field();
+        end_entry();
+        break;
+    }
+
+    state = STATE_TOP;
+    return clean;
+}
+
+// State and statistics
+bool BibTokenizer::at_top_level() const {
+    return state == STATE_TOP;
+}
+
+bool BibTokenizer::has_macros() const {
+    return macro_count > 0;
+}
+
+unsigned long BibTokenizer::get_bytes_fed() const {
+    return bytes_fed;
+}
@@ -0,0 +1,116 @@
+// bibtokenizer.h - Single-pass state-machine BibTeX tokenizer
+#ifndef BIBTOKENIZER_H
+#define BIBTOKENIZER_H
+
+#include "mystring.h"
+#include "structscan.h"
+
+// Receives the entries and fields recognized by a BibTokenizer
+class BibTokenHandler {
+public:
+    virtual void on_entry_begin(const MyString& type, const MyString& key) = 0;
+    // value is complete and trimmed; the handler may move from it
+    virtual void on_field(const MyString& name, MyString& value) = 0;
+    virtual void on_entry_end() = 0;
+    virtual void on_error(const MyString& message) = 0;
+
+protected:
+    ~BibTokenHandler() {}
+};
+
+// Character-level BibTeX parser. Input is pushed in blocks of any size
+// with feed() and every byte is examined exactly once; all state (brace
+// depth, quotes, partial names and values) carries over between blocks,
+// so a mapped file can be fed whole and a BufferedReader block by block.
+//
+// Handles entries split over any number of lines or sharing one line,
+// {braced} and "quoted" values with nested braces, bare numbers and
+// @string macros, '#' concatenation, and {...} or (...) entry bodies.
+// @comment and @preamble bodies are skipped. Line breaks inside a value
+// (with their surrounding indentation) become a single space, and the
+// outer braces or quotes of each value piece are removed.
+class BibTokenizer {
+private:
+    enum State {
+        STATE_TOP,              // Between entries - everything but '@' is a comment
+        STATE_ENTRY_TYPE,       // After '@'
+        STATE_BEFORE_BODY,      // Expecting '{' or '(' after the entry type
+        STATE_SKIP_BODY,        // Skipping a @comment/@preamble or broken entry
+        STATE_KEY,
+        STATE_AFTER_KEY,
+        STATE_BEFORE_FIELD,
+        STATE_FIELD_NAME,
+        STATE_BEFORE_EQUALS,
+        STATE_BEFORE_VALUE,     // Expecting a value piece
+        STATE_BRACED_VALUE,
+        STATE_QUOTED_VALUE,
+        STATE_BARE_VALUE,       // Number or macro name
+        STATE_AFTER_VALUE,      // Expecting '#', ',' or the end of the entry
+        STATE_SKIP_FIELD        // Recovering from a malformed field
+    };
+
+    enum EntryKind {
+        ENTRY_REGULAR,
+        ENTRY_STRING,           // @string macro definitions
+        ENTRY_SKIPPED           // @comment, @preamble
+    };
+
+    BibTokenHandler* handler;
+    State state;
+    EntryKind kind;
+    char close_char;            // '}' or ')' depending on how the body opened
+    int depth;                  // Brace depth inside a value or skipped body
+    bool in_quotes;             // Inside "..." while skipping a field
+    bool in_line_break;         // Skipping whitespace after a line break in a value
+
+    MyString entry_type;
+    MyString entry_key;
+    MyString field_name;
+    MyString field_value;
+    MyString bare_word;
+
+    // @string macros, in definition order
+    MyString* macro_names;
+    MyString* macro_values;
+    int macro_count;
+    int macro_capacity;
+
+    unsigned long bytes_fed;
+    StructuralIndex index;      // Structural bytes of the block being fed
+
+    static bool is_name_char(char c);
+    unsigned long scan_delimited(const char* data, unsigned long i, unsigned long length);
+    void open_body(char open_char);
+    void begin_entry();
+    void finish_field();
+    void end_entry();
+    void header_error();
+    void field_error(const char* problem);
+    void define_macro(const MyString& name, const MyString& value);
+    const MyString* find_macro(const MyString& name) const;
+    void expand_bare_word();
+
+    // Disable copying - the tokenizer owns its macro table
+    BibTokenizer(const BibTokenizer& other);
+    BibTokenizer& operator=(const BibTokenizer& other);
+
+public:
+    // Constructor
+    BibTokenizer(BibTokenHandler* token_handler);
+
+    // Destructor
+    ~BibTokenizer();
+
+    // Input
+    void feed(const char* data, unsigned long length);
+    // Flushes an unterminated entry. Returns true if the input ended
+    // between entries.
+    bool finish();
+
+    // State and statistics
+    bool at_top_level() const;
+    bool has_macros() const;
+    unsigned long get_bytes_fed() const;
+};
+
+#endif // BIBTOKENIZER_H
@@ -0,0 +1,192 @@
+// bufferedreader.cpp - Implementation of the block-buffered file reader
+#include "bufferedreader.h"
+
+// System calls for file I/O
+extern "C" {
+    int open(const char* path, int flags, ...);
+    int close(int fd);
+    long read(int fd, void* buf, unsigned long count);
+}
+
+#ifndef O_RDONLY
+#define O_RDONLY 0
+#endif
+
+// Constructors
+BufferedReader::BufferedReader()
+    : fd(-1), buffer(nullptr), buffer_size(DEFAULT_BUFFER_SIZE), pos(0), end(0),
+      eof_reached(false), syscall_count(0), total_bytes(0) {
+    buffer = (char*)malloc(buffer_size);
+}
+
+BufferedReader::BufferedReader(unsigned long size)
+    : fd(-1), buffer(nullptr), buffer_size(size > 0 ? size : DEFAULT_BUFFER_SIZE), pos(0), end(0),
+      eof_reached(false), syscall_count(0), total_bytes(0) {
+    buffer = (char*)malloc(buffer_size);
+}
+
+// Destructor
+BufferedReader::~BufferedReader() {
+    close();
+    if (buffer) {
+        free(buffer);
+        buffer = nullptr;
+    }
+}
+
+// File management
+bool BufferedReader::open(const char* filename) {
+    if (!filename || !buffer) return false;
+    close();
+
+    int new_fd = ::open(filename, O_RDONLY);
+    if (new_fd < 0) return false;
+    syscall_count++;
+
+    return attach(new_fd);
+}
+
+bool BufferedReader::attach(int file_descriptor) {
+    if (file_descriptor < 0 || !buffer) return false;
+    fd = file_descriptor;
+    pos = 0;
+    end = 0;
+    eof_reached = false;
+    return true;
+}
+
+void BufferedReader::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        syscall_count++;
+        fd = -1;
+    }
+    pos = 0;
+    end = 0;
+    eof_reached = true;
+}
+
+bool BufferedReader::is_open() const {
+    return fd >= 0;
+}
+
+// Private helper methods
+bool BufferedReader::refill() {
+    if (eof_reached || fd < 0) return false;
+
+    long bytes = read(fd, buffer, buffer_size);
+    syscall_count++;
+    if (bytes <= 0) {
+        // End of file or error
+        eof_reached = true;
+        pos = 0;
+        end = 0;
+        return false;
+    }
+
+    pos = 0;
+    end = (unsigned long)bytes;
+    total_bytes += end;
+    return true;
+}
+
+// Character access
+int BufferedReader::peek() {
+    if (pos >= end && !refill()) return -1;
+    return (unsigned char)buffer[pos];
+}
+
+int BufferedReader::get() {
+    if (pos >= end && !refill()) return -1;
+    return (unsigned char)buffer[pos++];
+}
+
+// Line and token access
+bool BufferedReader::read_line(MyString& line) {
+    line.clear();
+    if (pos >= end && !refill()) return false;
+
+    while (true) {
+        // Scan the buffered block for the end of the line
+        unsigned long scan = pos;
+        while (scan < end && buffer[scan] != '\n') scan++;
+
+        line.append(buffer + pos, scan - pos);
+
+        if (scan < end) {
+            pos = scan + 1; // Consume the newline
+            break;
+        }
+
+        // Line continues past this block
+        pos = end;
+        if (!refill()) break;
+    }
+
+    // Tolerate CRLF line endings
+    if (!line.empty() && line[line.length() - 1] == '\r') {
+        line = line.substr(0, line.length() - 1);
+    }
+    return true;
+}
+
+void BufferedReader::skip_whitespace() {
+    while (true) {
+        int c = peek();
+        if (c < 0 || !MyString::isspace((char)c)) return;
+        pos++;
+    }
+}
+
+bool BufferedReader::read_token(MyString& token, const char* delimiters) {
+    token.clear();
+    skip_whitespace();
+    if (pos >= end && !refill()) return false;
+
+    while (true) {
+        unsigned long scan = pos;
+        while (scan < end) {
+            char c = buffer[scan];
+            if (MyString::isspace(c)) break;
+            bool is_delim = false;
+            for (const char* d = delimiters; d && *d; ++d) {
+                if (c == *d) {
+                    is_delim = true;
+                    break;
+                }
+            }
+            if (is_delim) break;
+            scan++;
+        }
+
+        token.append(buffer + pos, scan - pos);
+        pos = scan;
+
+        if (scan < end) break;
+        if (!refill()) break;
+    }
+
+    return !token.empty();
+}
+
+bool BufferedReader::read_block(const char*& block, unsigned long& length) {
+    if (pos >= end && !refill()) return false;
+
+    block = buffer + pos;
+    length = end - pos;
+    pos = end;
+    return true;
+}
+
+// State and statistics
+bool BufferedReader::at_eof() {
+    return peek() < 0;
+}
+
+unsigned long BufferedReader::get_syscall_count() const {
+    return syscall_count;
+}
+
+unsigned long BufferedReader::get_bytes_read() const {
+    return total_bytes;
+}
@@ -0,0 +1,69 @@
+// bufferedreader.h - Block-buffered file reader built on raw system calls
+#ifndef BUFFEREDREADER_H
+#define BUFFEREDREADER_H
+
+#include "mystring.h"
+
+// Reads a file through one large refillable buffer so that each read()
+// system call fetches a whole block instead of a single byte.
+// Lines are assembled across refills, so there is no maximum line length.
+class BufferedReader {
+private:
+    int fd;
+    char* buffer;
+    unsigned long buffer_size;
+    unsigned long pos;          // Next unread byte in buffer
+    unsigned long end;          // One past the last valid byte in buffer
+    bool eof_reached;
+
+    // Statistics
+    unsigned long syscall_count;
+    unsigned long total_bytes;
+
+    bool refill();
+
+    // Disable copying - the reader owns a file descriptor and a buffer
+    BufferedReader(const BufferedReader& other);
+    BufferedReader& operator=(const BufferedReader& other);
+
+public:
+    static const unsigned long DEFAULT_BUFFER_SIZE = 1UL << 20; // 1 MiB
+
+    // Constructors
+    BufferedReader();
+    BufferedReader(unsigned long size);
+
+    // Destructor
+    ~BufferedReader();
+
+    // File management
+    bool open(const char* filename);
+    bool attach(int file_descriptor);
+    void close();
+    bool is_open() const;
+
+    // Character access (-1 on end of file)
+    int peek();
+    int get();
+
+    // Reads the next line without its '\n' (a trailing '\r' is dropped too).
+    // Returns false only when the end of file is reached with no data left.
+    bool read_line(MyString& line);
+
+    // Skips leading whitespace, then reads characters up to (not including)
+    // the next whitespace or any character in delimiters.
+    bool read_token(MyString& token, const char* delimiters);
+    void skip_whitespace();
+
+    // Hands out all buffered bytes not yet consumed (refilling first when
+    // there are none) and consumes them. The block stays valid until the
+    // next call on this reader. Returns false at end of file.
+    bool read_block(const char*& block, unsigned long& length);
+
+    // State and statistics
+    bool at_eof();
+    unsigned long get_syscall_count() const;
+    unsigned long get_bytes_read() const;
+};
+
+#endif // BUFFEREDREADER_H
@@ -0,0 +1,159 @@
+// bufferedwriter.cpp - Implementation of the block-buffered file writer
+#include "bufferedwriter.h"
+
+// System calls for file I/O
+extern "C" {
+    int open(const char* path, int flags, ...);
+    int close(int fd);
+    long write(int fd, const void* buf, unsigned long count);
+    long pwrite(int fd, const void* buf, unsigned long count, long offset);
+}
+
+#ifndef O_WRONLY
+#define O_WRONLY 1
+#endif
+#ifndef O_CREAT
+#define O_CREAT 64
+#endif
+#ifndef O_TRUNC
+#define O_TRUNC 512
+#endif
+
+// Constructors
+BufferedWriter::BufferedWriter()
+    : fd(-1), buffer(nullptr), buffer_size(DEFAULT_BUFFER_SIZE), used(0), failed(false),
+      syscall_count(0), total_bytes(0) {
+    buffer = (char*)malloc(buffer_size);
+}
+
+BufferedWriter::BufferedWriter(unsigned long size)
+    : fd(-1), buffer(nullptr), buffer_size(size > 0 ? size : DEFAULT_BUFFER_SIZE), used(0),
+      failed(false), syscall_count(0), total_bytes(0) {
+    buffer = (char*)malloc(buffer_size);
+}
+
+// Destructor
+BufferedWriter::~BufferedWriter() {
+    close();
+    if (buffer) {
+        free(buffer);
+        buffer = nullptr;
+    }
+}
+
+// File management
+bool BufferedWriter::open(const char* filename) {
+    if (!filename || !buffer) return false;
+    close();
+
+    int new_fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    syscall_count++;
+    if (new_fd < 0) return false;
+
+    fd = new_fd;
+    used = 0;
+    failed = false;
+    return true;
+}
+
+bool BufferedWriter::close() {
+    if (fd < 0) return !failed;
+
+    flush();
+    ::close(fd);
+    syscall_count++;
+    fd = -1;
+    return !failed;
+}
+
+bool BufferedWriter::is_open() const {
+    return fd >= 0;
+}
+
+// Private helper methods
+bool BufferedWriter::write_fully(const char* data, unsigned long length) {
+    while (length > 0) {
+        long written = ::write(fd, data, length);
+        syscall_count++;
+        if (written <= 0) {
+            failed = true;
+            return false;
+        }
+        data += written;
+        length -= (unsigned long)written;
+    }
+    return true;
+}
+
+// Output
+bool BufferedWriter::write(const char* data, unsigned long length) {
+    if (fd < 0 || failed) return false;
+    total_bytes += length;
+
+    if (used + length <= buffer_size) {
+        memcpy(buffer + used, data, length);
+        used += length;
+        return true;
+    }
+
+    if (!flush()) return false;
+    if (length >= buffer_size) {
+        return write_fully(data, length);
+    }
+    memcpy(buffer, data, length);
+    used = length;
+    return true;
+}
+
+bool BufferedWriter::write(const MyString& text) {
+    return write(text.c_str(), text.length());
+}
+
+bool BufferedWriter::put(char c) {
+    if (used < buffer_size && fd >= 0 && !failed) {
+        buffer[used++] = c;
+        total_bytes++;
+        return true;
+    }
+    return write(&c, 1);
+}
+
+bool BufferedWriter::flush() {
+    if (fd < 0 || failed) return false;
+    if (used == 0) return true;
+
+    unsigned long pending = used;
+    used = 0;
+    return write_fully(buffer, pending);
+}
+
+bool BufferedWriter::write_at(unsigned long offset, const void* data, unsigned long length) {
+    if (!flush()) return false;
+
+    const char* bytes = (const char*)data;
+    while (length > 0) {
+        long written = pwrite(fd, bytes, length, (long)offset);
+        syscall_count++;
+        if (written <= 0) {
+            failed = true;
+            return false;
+        }
+        bytes += written;
+        offset += (unsigned long)written;
+        length -= (unsigned long)written;
+    }
+    return true;
+}
+
+// State and statistics
+bool BufferedWriter::has_failed() const {
+    return failed;
+}
+
+unsigned long BufferedWriter::get_syscall_count() const {
+    return syscall_count;
+}
+
+unsigned long BufferedWriter::get_bytes_written() const {
+    return total_bytes;
+}
@@ -0,0 +1,60 @@
+// bufferedwriter.h - Block-buffered file writer built on raw system calls
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include "mystring.h"
+
+// Collects output in one large buffer and hands it to write() a block at
+// a time, so many small pieces cost one system call. Writes at least as
+// large as the buffer go straight to the file. A failed write is
+// remembered; close() reports it.
+class BufferedWriter {
+private:
+    int fd;
+    char* buffer;
+    unsigned long buffer_size;
+    unsigned long used;         // Bytes waiting in buffer
+    bool failed;
+
+    // Statistics
+    unsigned long syscall_count;
+    unsigned long total_bytes;
+
+    bool write_fully(const char* data, unsigned long length);
+
+    // Disable copying - the writer owns a file descriptor and a buffer
+    BufferedWriter(const BufferedWriter& other);
+    BufferedWriter& operator=(const BufferedWriter& other);
+
+public:
+    static const unsigned long DEFAULT_BUFFER_SIZE = 1UL << 20; // 1 MiB
+
+    // Constructors
+    BufferedWriter();
+    BufferedWriter(unsigned long size);
+
+    // Destructor (closes without reporting errors)
+    ~BufferedWriter();
+
+    // File management - open() creates or truncates the file
+    bool open(const char* filename);
+    bool close();               // Flushes; false if any write failed
+    bool is_open() const;
+
+    // Output
+    bool write(const char* data, unsigned long length);
+    bool write(const MyString& text);
+    bool put(char c);
+    bool flush();
+
+    // Overwrites bytes already written (after flushing), such as a header
+    // whose contents are only known at the end
+    bool write_at(unsigned long offset, const void* data, unsigned long length);
+
+    // State and statistics
+    bool has_failed() const;
+    unsigned long get_syscall_count() const;
+    unsigned long get_bytes_written() const;
+};
+
+#endif // BUFFEREDWRITER_H
@@ -0,0 +1,150 @@
+// hashindex.cpp - Implementation of the open-addressing hash index
+#include "hashindex.h"
+#include "mystring.h"    // malloc, free, memcpy, memset
+
+// Constructors
+HashIndex::HashIndex() : slots(nullptr), capacity(0), count(0) {}
+
+HashIndex::HashIndex(const HashIndex& other) : slots(nullptr), capacity(0), count(0) {
+    *this = other;
+}
+
+HashIndex::HashIndex(HashIndex&& other) : slots(other.slots), capacity(other.capacity), count(other.count) {
+    other.slots = nullptr;
+    other.capacity = 0;
+    other.count = 0;
+}
+
+// Destructor
+HashIndex::~HashIndex() {
+    clear();
+}
+
+// Assignment operators
+HashIndex& HashIndex::operator=(const HashIndex& other) {
+    if (this != &other) {
+        clear();
+        if (other.slots) {
+            slots = (Slot*)malloc(sizeof(Slot) * other.capacity);
+            if (slots) {
+                memcpy(slots, other.slots, sizeof(Slot) * other.capacity);
+                capacity = other.capacity;
+                count = other.count;
+            }
+        }
+    }
+    return *this;
+}
+
+HashIndex& HashIndex::operator=(HashIndex&& other) {
+    if (this != &other) {
+        clear();
+        slots = other.slots;
+        capacity = other.capacity;
+        count = other.count;
+        other.slots = nullptr;
+        other.capacity = 0;
+        other.count = 0;
+    }
+    return *this;
+}
+
+// Private helper methods
+void HashIndex::allocate_slots(unsigned long new_capacity) {
+    slots = (Slot*)malloc(sizeof(Slot) * new_capacity);
+    if (!slots) {
+        capacity = 0;
+        return;
+    }
+    // All bytes 0xff marks every slot EMPTY_SLOT
+    memset(slots, 0xff, sizeof(Slot) * new_capacity);
+    capacity = new_capacity;
+}
+
+bool HashIndex::rehash(unsigned long new_capacity) {
+    Slot* old_slots = slots;
+    unsigned long old_capacity = capacity;
+
+    allocate_slots(new_capacity);
+    if (!slots) {
+        // Keep the old table on allocation failure
+        slots = old_slots;
+        capacity = old_capacity;
+        return false;
+    }
+
+    // Re-insert in probe order, which preserves insertion order within each
+    // chain. The walk starts just after an empty slot (the load factor
+    // guarantees one) so a chain that wraps past the end is not split.
+    unsigned long start = 0;
+    while (start < old_capacity && old_slots[start].position != EMPTY_SLOT) start++;
+    for (unsigned long n = 0; n < old_capacity; n++) {
+        const Slot& old_slot = old_slots[(start + n) & (old_capacity - 1)];
+        if (old_slot.position == EMPTY_SLOT) continue;
+        unsigned long pos = old_slot.hash & (capacity - 1);
+        while (slots[pos].position != EMPTY_SLOT) {
+            pos = (pos + 1) & (capacity - 1);
+        }
+        slots[pos] = old_slot;
+    }
+
+    if (old_slots) free(old_slots);
+    return true;
+}
+
+// Index management
+bool HashIndex::insert(unsigned long hash, unsigned long position) {
+    if ((count + 1) * 2 > capacity) {
+        if (!rehash(capacity == 0 ? MIN_CAPACITY : capacity * 2)) return false;
+    }
+
+    unsigned long pos = hash & (capacity - 1);
+    while (slots[pos].position != EMPTY_SLOT) {
+        pos = (pos + 1) & (capacity - 1);
+    }
+    slots[pos].hash = hash;
+    slots[pos].position = position;
+    count++;
+    return true;
+}
+
+void HashIndex::clear() {
+    if (slots) {
+        free(slots);
+        slots = nullptr;
+    }
+    capacity = 0;
+    count = 0;
+}
+
+bool HashIndex::reserve(unsigned long expected_count) {
+    unsigned long needed = MIN_CAPACITY;
+    while (needed < expected_count * 2) {
+        needed *= 2;
+    }
+    return needed <= capacity || rehash(needed);
+}
+
+unsigned long HashIndex::size() const {
+    return count;
+}
+
+// Candidate lookup
+unsigned long HashIndex::probe_start(unsigned long hash) const {
+    return capacity == 0 ? 0 : (hash & (capacity - 1));
+}
+
+bool HashIndex::next_candidate(unsigned long hash, unsigned long& cursor, unsigned long& position) const {
+    if (capacity == 0) return false;
+
+    // Walk the probe chain until an empty slot ends it
+    while (slots[cursor].position != EMPTY_SLOT) {
+        const Slot& slot = slots[cursor];
+        cursor = (cursor + 1) & (capacity - 1);
+        if (slot.hash == hash) {
+            position = slot.position;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+// hashindex.h - Open-addressing hash table from a key hash to a position
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+// Maps hashes to positions in some external array (for example entry
+// slots in a BibDatabase). The index only stores (hash, position) pairs;
+// the owner compares the real keys of the candidate positions, so the
+// same class can index any kind of key. Uses linear probing and keeps the
+// load factor at or below one half.
+class HashIndex {
+private:
+    struct Slot {
+        unsigned long hash;
+        unsigned long position;     // EMPTY_SLOT when unused
+    };
+
+    static const unsigned long EMPTY_SLOT = (unsigned long)-1;
+    static const unsigned long MIN_CAPACITY = 16;
+
+    Slot* slots;
+    unsigned long capacity;         // Always zero or a power of two
+    unsigned long count;
+
+    bool rehash(unsigned long new_capacity);
+    void allocate_slots(unsigned long new_capacity);
+
+public:
+    // Constructors
+    HashIndex();
+    HashIndex(const HashIndex& other);
+    HashIndex(HashIndex&& other);
+
+    // Destructor
+    ~HashIndex();
+
+    // Assignment operators
+    HashIndex& operator=(const HashIndex& other);
+    HashIndex& operator=(HashIndex&& other);
+
+    // Index management
+    bool insert(unsigned long hash, unsigned long position);
+    void clear();
+    bool reserve(unsigned long expected_count);
+    unsigned long size() const;
+
+    // Candidate lookup:
+    //   unsigned long cursor = index.probe_start(hash), position;
+    //   while (index.next_candidate(hash, cursor, position)) { compare keys... }
+    // Candidates come back in insertion order.
+    unsigned long probe_start(unsigned long hash) const;
+    bool next_candidate(unsigned long hash, unsigned long& cursor, unsigned long& position) const;
+};
+
+#endif // HASHINDEX_H
@@ -0,0 +1,63 @@
+// institutematcher.cpp - Boyer-Moore-Horspool search with ASCII case folding
+#include "institutematcher.h"
+
+// ASCII lowercase of every byte value, filled in before main() runs
+struct FoldTable {
+    unsigned char map[256];
+
+    FoldTable() {
+        for (int c = 0; c < 256; c++) {
+            map[c] = (unsigned char)MyString::tolower((char)c);
+        }
+    }
+};
+
+static const FoldTable fold_table;
+
+InstituteMatcher::InstituteMatcher(const MyStringView& institute_name)
+    : pattern(institute_name.data(), institute_name.length()) {
+    pattern.to_lower();
+
+    // Bytes absent from the pattern (all but its last byte) shift a whole
+    // pattern length; the others line up with their last occurrence
+    unsigned long m = pattern.length();
+    for (int c = 0; c < 256; c++) {
+        skip[c] = m;
+    }
+    for (unsigned long i = 0; i + 1 < m; i++) {
+        skip[(unsigned char)pattern[i]] = m - 1 - i;
+    }
+}
+
+bool InstituteMatcher::matches(const MyStringView& text) const {
+    return matches(text.data(), text.length());
+}
+
+bool InstituteMatcher::matches(const char* text, unsigned long length) const {
+    unsigned long m = pattern.length();
+    if (m == 0 || m > length) return false;
+
+    const unsigned char* haystack = (const unsigned char*)text;
+    const unsigned char* needle = (const unsigned char*)pattern.c_str();
+    unsigned char last = needle[m - 1];
+
+    unsigned long position = 0;
+    while (position + m <= length) {
+        unsigned char tail = fold_table.map[haystack[position + m - 1]];
+        if (tail == last) {
+            unsigned long j = m - 1;
+            while (j > 0 && fold_table.map[haystack[position + j - 1]] == needle[j - 1]) j--;
+            if (j == 0) return true;
+        }
+        position += skip[tail];
+    }
+    return false;
+}
+
+const MyString& InstituteMatcher::get_pattern() const {
+    return pattern;
+}
+
+bool InstituteMatcher::empty() const {
+    return pattern.empty();
+}
@@ -0,0 +1,33 @@
+// institutematcher.h - Case-insensitive substring search for institute names
+#ifndef INSTITUTEMATCHER_H
+#define INSTITUTEMATCHER_H
+
+#include "mystring.h"
+#include "mystringview.h"
+
+// Built once per query: the institute name is case-folded and a
+// Boyer-Moore-Horspool skip table is prepared, so each match runs in place
+// over the text without copying or allocating. Folding is ASCII-only,
+// like MyString::tolower.
+class InstituteMatcher {
+private:
+    MyString pattern;               // Case-folded institute name
+    unsigned long skip[256];        // Shift for the folded last byte of the window
+
+    // Disable copying - built once and passed by reference
+    InstituteMatcher(const InstituteMatcher& other);
+    InstituteMatcher& operator=(const InstituteMatcher& other);
+
+public:
+    explicit InstituteMatcher(const MyStringView& institute_name);
+
+    // True if text contains the institute name, ignoring case.
+    // An empty institute name matches nothing.
+    bool matches(const MyStringView& text) const;
+    bool matches(const char* text, unsigned long length) const;
+
+    const MyString& get_pattern() const;
+    bool empty() const;
+};
+
+#endif // INSTITUTEMATCHER_H
@@ -0,0 +1,248 @@
+// instituteset.cpp - Aho-Corasick automaton over several institute names
+#include "instituteset.h"
+#include "bufferedreader.h"
+#include "placement_new.h"
+#include "myutility.h"
+
+static const unsigned int NO_STATE = 0xffffffff;
+
+// Case-insensitive equality, with MyString::tolower folding
+static bool same_folded(const MyString& a, const MyStringView& b) {
+    if (a.length() != b.length()) return false;
+    for (unsigned long i = 0; i < a.length(); i++) {
+        if (MyString::tolower(a[i]) != MyString::tolower(b[i])) return false;
+    }
+    return true;
+}
+
+// Constructor
+InstituteSet::InstituteSet()
+    : names(nullptr), name_count(0), name_capacity(0), class_count(0), state_count(0),
+      transitions(nullptr), output_starts(nullptr), output_ids(nullptr), built(false) {
+    for (int c = 0; c < 256; c++) byte_class[c] = 0;
+}
+
+// Destructor
+InstituteSet::~InstituteSet() {
+    clear();
+    if (names) free(names);
+}
+
+void InstituteSet::free_automaton() {
+    if (transitions) free(transitions);
+    if (output_starts) free(output_starts);
+    if (output_ids) free(output_ids);
+    transitions = nullptr;
+    output_starts = nullptr;
+    output_ids = nullptr;
+    class_count = 0;
+    state_count = 0;
+    built = false;
+}
+
+bool InstituteSet::add(const MyStringView& institute_name) {
+    if (institute_name.empty()) return false;
+    for (unsigned int i = 0; i < name_count; i++) {
+        if (same_folded(names[i], institute_name)) return false;
+    }
+
+    if (name_count == name_capacity) {
+        unsigned int new_capacity = name_capacity == 0 ? 8 : name_capacity * 2;
+        MyString* new_names = (MyString*)malloc(sizeof(MyString) * new_capacity);
+        if (!new_names) return false;
+        for (unsigned int i = 0; i < name_count; i++) {
+            new (&new_names[i]) MyString(my_move(names[i]));
+            names[i].~MyString();
+        }
+        if (names) free(names);
+        names = new_names;
+        name_capacity = new_capacity;
+    }
+
+    new (&names[name_count]) MyString(institute_name.data(), institute_name.length());
+    name_count++;
+    built = false;
+    return true;
+}
+
+bool InstituteSet::load_from_file(const char* filename) {
+    BufferedReader reader;
+    if (!reader.open(filename)) return false;
+
+    MyString line;
+    while (reader.read_line(line)) {
+        line.trim();
+        if (line.empty() || line[0] == '#') continue;
+        add(line);
+    }
+    return true;
+}
+
+// Builds the trie of folded names, then completes it into a DFA in
+// breadth-first order: a missing edge follows the failure state's edge,
+// and each state reports its own name plus everything its failure state
+// reports.
+bool InstituteSet::build() {
+    free_automaton();
+
+    // Input classes: one per folded byte used by some name, 0 for the rest
+    unsigned char folded_class[256];
+    for (int c = 0; c < 256; c++) folded_class[c] = 0;
+    unsigned long total_length = 0;
+    for (unsigned int i = 0; i < name_count; i++) {
+        for (unsigned long j = 0; j < names[i].length(); j++) {
+            folded_class[(unsigned char)MyString::tolower(names[i][j])] = 1;
+        }
+        total_length += names[i].length();
+    }
+    class_count = 1;
+    for (int c = 0; c < 256; c++) {
+        if (folded_class[c]) folded_class[c] = (unsigned char)class_count++;
+    }
+    for (int c = 0; c < 256; c++) {
+        byte_class[c] = folded_class[(unsigned char)MyString::tolower((char)c)];
+    }
+
+    unsigned long max_states = total_length + 1;
+    transitions = (unsigned int*)malloc(sizeof(unsigned int) * max_states * class_count);
+    output_starts = (unsigned int*)malloc(sizeof(unsigned int) * (max_states + 1));
+    unsigned int* terminal = (unsigned int*)malloc(sizeof(unsigned int) * max_states);
+    unsigned int* failure = (unsigned int*)malloc(sizeof(unsigned int) * max_states);
+    unsigned int* order = (unsigned int*)malloc(sizeof(unsigned int) * max_states);
+    if (!transitions || !output_starts || !terminal || !failure || !order) {
+        if (terminal) free(terminal);
+        if (failure) free(failure);
+        if (order) free(order);
+        free_automaton();
+        return false;
+    }
+
+    // Trie
+    for (unsigned long i = 0; i < max_states * class_count; i++) transitions[i] = NO_STATE;
+    terminal[0] = NO_STATE;
+    state_count = 1;
+    for (unsigned int i = 0; i < name_count; i++) {
+        unsigned int state = 0;
+        for (unsigned long j = 0; j < names[i].length(); j++) {
+            unsigned int* edge = &transitions[state * class_count + byte_class[(unsigned char)names[i][j]]];
+            if (*edge == NO_STATE) {
+                terminal[state_count] = NO_STATE;
+                *edge = state_count++;
+            }
+            state = *edge;
+        }
+        terminal[state] = i;
+    }
+
+    // Failure links and the completed transition table
+    unsigned int head = 0, tail = 0;
+    failure[0] = 0;
+    for (unsigned int c = 0; c < class_count; c++) {
+        unsigned int child = transitions[c];
+        if (child == NO_STATE) {
+            transitions[c] = 0;
+        } else {
+            failure[child] = 0;
+            order[tail++] = child;
+        }
+    }
+    while (head < tail) {
+        unsigned int state = order[head++];
+        unsigned int* row = &transitions[state * class_count];
+        const unsigned int* fallback = &transitions[failure[state] * class_count];
+        for (unsigned int c = 0; c < class_count; c++) {
+            if (row[c] == NO_STATE) {
+                row[c] = fallback[c];
+            } else {
+                failure[row[c]] = fallback[c];
+                order[tail++] = row[c];
+            }
+        }
+    }
+
+    // Outputs; a failure state always comes earlier in order
+    unsigned long total_outputs = 0;
+    unsigned int* counts = (unsigned int*)malloc(sizeof(unsigned int) * state_count);
+    if (!counts) {
+        free(terminal);
+        free(failure);
+        free(order);
+        free_automaton();
+        return false;
+    }
+    counts[0] = 0;
+    for (unsigned int i = 0; i < tail; i++) {
+        unsigned int state = order[i];
+        counts[state] = (terminal[state] != NO_STATE ? 1 : 0) + counts[failure[state]];
+    }
+    for (unsigned int state = 0; state < state_count; state++) {
+        output_starts[state] = (unsigned int)total_outputs;
+        total_outputs += counts[state];
+    }
+    output_starts[state_count] = (unsigned int)total_outputs;
+
+    output_ids = (unsigned int*)malloc(sizeof(unsigned int) * (total_outputs > 0 ? total_outputs : 1));
+    if (output_ids) {
+        for (unsigned int i = 0; i < tail; i++) {
+            unsigned int state = order[i];
+            unsigned int* out = &output_ids[output_starts[state]];
+            if (terminal[state] != NO_STATE) *out++ = terminal[state];
+            unsigned int inherited = failure[state];
+            for (unsigned int k = output_starts[inherited]; k < output_starts[inherited + 1]; k++) {
+                *out++ = output_ids[k];
+            }
+        }
+    }
+
+    free(counts);
+    free(terminal);
+    free(failure);
+    free(order);
+    if (!output_ids) {
+        free_automaton();
+        return false;
+    }
+    built = true;
+    return true;
+}
+
+bool InstituteSet::is_built() const {
+    return built;
+}
+
+void InstituteSet::clear() {
+    free_automaton();
+    for (unsigned int i = 0; i < name_count; i++) {
+        names[i].~MyString();
+    }
+    name_count = 0;
+}
+
+unsigned int InstituteSet::size() const {
+    return name_count;
+}
+
+const MyString& InstituteSet::get_name(unsigned int id) const {
+    static const MyString empty_string;
+    return id < name_count ? names[id] : empty_string;
+}
+
+unsigned int InstituteSet::collect(const MyStringView& text, unsigned int* found, unsigned int found_count,
+                                   unsigned char* seen) const {
+    if (!built) return found_count;
+
+    const unsigned char* bytes = (const unsigned char*)text.data();
+    unsigned long length = text.length();
+    unsigned int state = 0;
+    for (unsigned long i = 0; i < length; i++) {
+        state = transitions[state * class_count + byte_class[bytes[i]]];
+        for (unsigned int k = output_starts[state]; k < output_starts[state + 1]; k++) {
+            unsigned int id = output_ids[k];
+            if (!seen[id]) {
+                seen[id] = 1;
+                found[found_count++] = id;
+            }
+        }
+    }
+    return found_count;
+}
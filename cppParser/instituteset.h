@@ -0,0 +1,63 @@
+// instituteset.h - Aho-Corasick automaton over several institute names
+#ifndef INSTITUTESET_H
+#define INSTITUTESET_H
+
+#include "mystring.h"
+#include "mystringview.h"
+
+// A list of institute names searched together: one pass over a text finds
+// every institute it contains, ignoring case, however many there are.
+// Names are added first, then build() turns them into a deterministic
+// automaton over the folded bytes that occur in them; every other byte
+// shares one input class that leads back to the root. Building again after
+// add() is required before searching.
+class InstituteSet {
+private:
+    MyString* names;                    // As given, in id order
+    unsigned int name_count;
+    unsigned int name_capacity;
+
+    unsigned char byte_class[256];      // Folded input byte -> class (0: in no name)
+    unsigned int class_count;
+    unsigned int state_count;
+    unsigned int* transitions;          // state * class_count + class -> state
+    unsigned int* output_starts;        // State s reports output_ids[output_starts[s]..output_starts[s + 1])
+    unsigned int* output_ids;
+    bool built;
+
+    void free_automaton();
+
+    // Disable copying - the automaton has a single owner
+    InstituteSet(const InstituteSet& other);
+    InstituteSet& operator=(const InstituteSet& other);
+
+public:
+    // Constructor
+    InstituteSet();
+
+    // Destructor
+    ~InstituteSet();
+
+    // Adds a name; empty names and repeats (ignoring case) are skipped
+    bool add(const MyStringView& institute_name);
+
+    // Adds every non-empty line of a file that does not start with '#',
+    // trimmed. Returns false if the file cannot be read.
+    bool load_from_file(const char* filename);
+
+    bool build();
+    bool is_built() const;
+    void clear();
+
+    unsigned int size() const;
+    const MyString& get_name(unsigned int id) const;
+
+    // Appends the ids of institutes found in text that are not yet marked
+    // in seen (one flag per institute), marks them, and returns the new
+    // found_count. found needs room for size() ids. Callers reset the flags
+    // of the ids they collected before reusing seen.
+    unsigned int collect(const MyStringView& text, unsigned int* found, unsigned int found_count,
+                         unsigned char* seen) const;
+};
+
+#endif // INSTITUTESET_H
@@ -0,0 +1,273 @@
+// internpool.cpp - Implementation of shared strings and the intern pool
+#include "internpool.h"
+#include "placement_new.h"
+#include "myutility.h"
+#include "stringarena.h"
+
+static unsigned int next_pool_serial = 1;
+
+// InternedString
+InternedString::InternedString() : node(nullptr) {}
+
+InternedString::InternedString(Node* shared) : node(shared) {
+    if (node) __atomic_fetch_add(&node->references, 1, __ATOMIC_RELAXED);
+}
+
+InternedString::InternedString(const MyString& text) : node(new_node(text.c_str(), text.length())) {}
+
+InternedString::InternedString(const MyStringView& text) : node(new_node(text.data(), text.length())) {}
+
+InternedString::InternedString(MyString&& text) : node(new_node(my_move(text))) {}
+
+InternedString::InternedString(const InternedString& other) : node(other.node) {
+    if (node) __atomic_fetch_add(&node->references, 1, __ATOMIC_RELAXED);
+}
+
+InternedString::InternedString(InternedString&& other) : node(other.node) {
+    other.node = nullptr;
+}
+
+// Destructor
+InternedString::~InternedString() {
+    release();
+}
+
+// Assignment operators
+InternedString& InternedString::operator=(const InternedString& other) {
+    if (node != other.node) {
+        if (other.node) __atomic_fetch_add(&other.node->references, 1, __ATOMIC_RELAXED);
+        release();
+        node = other.node;
+    }
+    return *this;
+}
+
+InternedString& InternedString::operator=(InternedString&& other) {
+    if (this != &other) {
+        release();
+        node = other.node;
+        other.node = nullptr;
+    }
+    return *this;
+}
+
+// Nodes are shared beyond the lifetime of any one database, so their
+// text is always malloc'd (or inline), never taken from a StringArena
+InternedString::Node* InternedString::new_node(const char* text, unsigned long length) {
+    if (length == 0) return nullptr;
+
+    StringArenaScope no_arena(nullptr);
+    Node* created = (Node*)malloc(sizeof(Node));
+    if (!created) return nullptr;
+    new (&created->text) MyString(text, length);
+    created->hash = MyString::hash_bytes(text, length);
+    created->id = NO_ID;
+    created->pool_serial = 0;
+    created->references = 1;
+    return created;
+}
+
+InternedString::Node* InternedString::new_node(MyString&& text) {
+    if (text.empty()) return nullptr;
+    if (text.is_arena_backed()) return new_node(text.c_str(), text.length());
+
+    Node* created = (Node*)malloc(sizeof(Node));
+    if (!created) return nullptr;
+    new (&created->text) MyString(my_move(text));
+    created->hash = created->text.hash();
+    created->id = NO_ID;
+    created->pool_serial = 0;
+    created->references = 1;
+    return created;
+}
+
+void InternedString::release_node(Node* shared) {
+    if (shared && __atomic_sub_fetch(&shared->references, 1, __ATOMIC_ACQ_REL) == 0) {
+        shared->text.~MyString();
+        free(shared);
+    }
+}
+
+void InternedString::release() {
+    release_node(node);
+    node = nullptr;
+}
+
+// Comparison
+bool InternedString::operator==(const InternedString& other) const {
+    if (node == other.node) return true;
+    if (!node || !other.node) return false;
+    if (node->pool_serial != 0 && node->pool_serial == other.node->pool_serial) return false;
+    return node->hash == other.node->hash && node->text == other.node->text;
+}
+
+bool InternedString::operator!=(const InternedString& other) const {
+    return !(*this == other);
+}
+
+// Accessors
+const MyString& InternedString::str() const {
+    static const MyString empty_string;
+    return node ? node->text : empty_string;
+}
+
+const char* InternedString::c_str() const {
+    return str().c_str();
+}
+
+unsigned long InternedString::length() const {
+    return node ? node->text.length() : 0;
+}
+
+bool InternedString::empty() const {
+    return node == nullptr;
+}
+
+unsigned int InternedString::get_id() const {
+    return node ? node->id : NO_ID;
+}
+
+bool InternedString::is_pooled() const {
+    return node && node->pool_serial != 0;
+}
+
+void InternedString::clear() {
+    release();
+}
+
+// InternPool
+unsigned int InternPool::new_serial() {
+    return __atomic_fetch_add(&next_pool_serial, 1, __ATOMIC_RELAXED);
+}
+
+InternPool::InternPool() : nodes(nullptr), count(0), capacity(0), serial(new_serial()), index() {}
+
+InternPool::InternPool(InternPool&& other)
+    : nodes(other.nodes), count(other.count), capacity(other.capacity), serial(other.serial),
+      index(my_move(other.index)) {
+    other.nodes = nullptr;
+    other.count = 0;
+    other.capacity = 0;
+    other.serial = new_serial();
+}
+
+// Destructor
+InternPool::~InternPool() {
+    clear();
+    if (nodes) free(nodes);
+}
+
+// Assignment operator
+InternPool& InternPool::operator=(InternPool&& other) {
+    if (this != &other) {
+        clear();
+        if (nodes) free(nodes);
+        nodes = other.nodes;
+        count = other.count;
+        capacity = other.capacity;
+        serial = other.serial;
+        index = my_move(other.index);
+        other.nodes = nullptr;
+        other.count = 0;
+        other.capacity = 0;
+        other.serial = new_serial();
+    }
+    return *this;
+}
+
+// Returns the id holding this text, or NO_ID
+unsigned int InternPool::find(const char* text, unsigned long length, unsigned long hash) const {
+    unsigned long cursor = index.probe_start(hash);
+    unsigned long position;
+    while (index.next_candidate(hash, cursor, position)) {
+        const MyString& candidate = nodes[position]->text;
+        if (candidate.length() == length && memcmp(candidate.c_str(), text, length) == 0) {
+            return (unsigned int)position;
+        }
+    }
+    return InternedString::NO_ID;
+}
+
+// Takes one reference to node and gives it the next id
+bool InternPool::add(InternedString::Node* node) {
+    if (count == capacity) {
+        unsigned int new_capacity = capacity == 0 ? 64 : capacity * 2;
+        InternedString::Node** new_nodes =
+            (InternedString::Node**)malloc(sizeof(InternedString::Node*) * new_capacity);
+        if (!new_nodes) return false;
+        if (nodes) {
+            memcpy(new_nodes, nodes, sizeof(InternedString::Node*) * count);
+            free(nodes);
+        }
+        nodes = new_nodes;
+        capacity = new_capacity;
+    }
+
+    node->id = count;
+    node->pool_serial = serial;
+    __atomic_fetch_add(&node->references, 1, __ATOMIC_RELAXED);
+    nodes[count] = node;
+    index.insert(node->hash, count);
+    count++;
+    return true;
+}
+
+InternedString InternPool::intern(const MyStringView& text) {
+    if (text.empty()) return InternedString();
+
+    unsigned long hash = text.hash();
+    unsigned int id = find(text.data(), text.length(), hash);
+    if (id != InternedString::NO_ID) {
+        return InternedString(nodes[id]);
+    }
+
+    InternedString result;
+    result.node = InternedString::new_node(text.data(), text.length());
+    if (result.node) add(result.node);
+    return result;
+}
+
+void InternPool::intern(InternedString& handle) {
+    InternedString::Node* node = handle.node;
+    if (!node || node->pool_serial == serial) return;
+
+    unsigned int id = find(node->text.c_str(), node->text.length(), node->hash);
+    if (id != InternedString::NO_ID) {
+        handle = InternedString(nodes[id]);
+    } else if (node->pool_serial == 0) {
+        add(node);
+    } else {
+        // Pooled elsewhere - its id belongs to that pool
+        handle = intern(MyStringView(node->text));
+    }
+}
+
+// Accessors
+unsigned int InternPool::size() const {
+    return count;
+}
+
+const MyString& InternPool::get(unsigned int id) const {
+    static const MyString empty_string;
+    return id < count ? nodes[id]->text : empty_string;
+}
+
+unsigned long InternPool::get_text_bytes() const {
+    unsigned long bytes = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        bytes += nodes[i]->text.length();
+    }
+    return bytes;
+}
+
+void InternPool::clear() {
+    for (unsigned int i = 0; i < count; i++) {
+        InternedString::release_node(nodes[i]);
+    }
+    count = 0;
+    index.clear();
+
+    // Nodes still held elsewhere keep the old serial, which no longer
+    // matches this pool
+    serial = new_serial();
+}
@@ -0,0 +1,115 @@
+// internpool.h - Shared immutable strings and a pool that de-duplicates them
+#ifndef INTERNPOOL_H
+#define INTERNPOOL_H
+
+#include "mystring.h"
+#include "mystringview.h"
+#include "hashindex.h"
+
+class InternPool;
+
+// Handle to a reference-counted immutable string. Copies share the text.
+// Handles from the same InternPool are equal exactly when they point at
+// the same node, so comparing them is a pointer (or 32-bit id) compare.
+// The empty string never allocates a node.
+class InternedString {
+private:
+    friend class InternPool;
+
+    struct Node {
+        MyString text;
+        unsigned long hash;
+        unsigned int id;            // Position in its pool, NO_ID until pooled
+        unsigned int pool_serial;   // 0 until pooled
+        int references;
+    };
+
+    Node* node;
+
+    explicit InternedString(Node* shared);     // Adds a reference
+    static Node* new_node(const char* text, unsigned long length);
+    static Node* new_node(MyString&& text);
+    static void release_node(Node* shared);
+    void release();
+
+public:
+    static const unsigned int NO_ID = 0xffffffffu;
+
+    // Constructors - the string ones copy the text into a node of their
+    // own (not pooled)
+    InternedString();
+    explicit InternedString(const MyString& text);
+    explicit InternedString(const MyStringView& text);
+    explicit InternedString(MyString&& text);   // Takes over a heap buffer; arena text is copied
+    InternedString(const InternedString& other);
+    InternedString(InternedString&& other);
+
+    // Destructor
+    ~InternedString();
+
+    // Assignment operators
+    InternedString& operator=(const InternedString& other);
+    InternedString& operator=(InternedString&& other);
+
+    // Comparison - a pointer compare, or an id compare within one pool;
+    // only handles from different pools compare their text
+    bool operator==(const InternedString& other) const;
+    bool operator!=(const InternedString& other) const;
+
+    // Accessors
+    const MyString& str() const;
+    const char* c_str() const;
+    unsigned long length() const;
+    bool empty() const;
+    unsigned int get_id() const;    // NO_ID when empty or not pooled
+    bool is_pooled() const;
+
+    void clear();
+};
+
+// Stores each distinct string once. intern() returns handles that share
+// the pooled node, and the pool keeps every node it has handed out alive
+// until clear() or destruction. Ids are dense: 0..size()-1.
+class InternPool {
+private:
+    InternedString::Node** nodes;
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int serial;            // Unique per pool and per clear(), never 0
+    HashIndex index;                // Text hash -> id
+
+    static unsigned int new_serial();
+    unsigned int find(const char* text, unsigned long length, unsigned long hash) const;
+    bool add(InternedString::Node* node);
+
+    // Disable copying - a pool's ids identify it
+    InternPool(const InternPool& other);
+    InternPool& operator=(const InternPool& other);
+
+public:
+    // Constructors
+    InternPool();
+    InternPool(InternPool&& other);
+
+    // Destructor
+    ~InternPool();
+
+    // Assignment operator
+    InternPool& operator=(InternPool&& other);
+
+    // Returns the pooled handle for text, adding it if needed
+    InternedString intern(const MyStringView& text);
+
+    // Points handle at this pool's node for its text. A node that is not
+    // pooled yet is adopted as is; otherwise its text is looked up or copied.
+    void intern(InternedString& handle);
+
+    // Accessors
+    unsigned int size() const;
+    const MyString& get(unsigned int id) const;
+    unsigned long get_text_bytes() const;
+
+    void clear();
+};
+
+#endif // INTERNPOOL_H
@@ -1,5 +1,6 @@
 // main.cpp - Main program implementation
 #include "bibdatabase.h"
+#include "textindex.h"
 #include "Author.h"
 
 extern "C" {
@@ -8,29 +9,42 @@ extern "C" {
 
 // Function prototypes
 void print_usage(const char* program_name);
-bool validate_arguments(int argc, char* argv[]);
+bool parse_arguments(int argc, char* argv[], InstituteSet& institutes, int& thread_count,
+                     bool& use_snapshot, MyString& search_query, unsigned int& top_authors);
+bool load_database(BibDatabase& database, const MyString& filename, bool use_snapshot);
+void search_database(const BibDatabase& database, const MyString& filename, const MyString& query,
+                     const SourceStamp* source, int thread_count);
+bool is_number(const char* text);
 void demonstrate_sorting(BibDatabase& db);
 void demonstrate_merging();
 
 int main(int argc, char* argv[]) {
     // Validate command line arguments
-    if (!validate_arguments(argc, argv)) {
+    InstituteSet institutes;
+    int thread_count = 1;
+    bool use_snapshot = true;
+    MyString search_query;
+    unsigned int top_authors = 0;
+    if (!parse_arguments(argc, argv, institutes, thread_count, use_snapshot, search_query, top_authors)) {
         print_usage(argv[0]);
         return 1;
     }
 
     const char* bib_file = argv[1];
-    const char* institute_name = argv[2];
 
     // Create database and load from file
     BibDatabase database("Main Bibliography Database");
+    database.set_thread_count(thread_count);
 
     printf("=== BibTeX Parser (C++ Version) ===\n");
     printf("Using OOP principles without standard libraries\n\n");
 
-    // Load the bibliography file
+    // Load the bibliography file (or its snapshot, when still fresh). A
+    // search index is cached too, stamped before loading like the snapshot.
     MyString filename(bib_file);
-    if (!database.load_from_file(filename)) {
+    SourceStamp index_source;
+    bool cache_index = !search_query.empty() && use_snapshot && index_source.capture(bib_file);
+    if (!load_database(database, filename, use_snapshot)) {
         printf("Failed to load bibliography file: %s\n", bib_file);
         return 1;
     }
@@ -38,10 +52,24 @@ int main(int argc, char* argv[]) {
     // Display database summary
     database.print_summary();
 
-    // Count and display institute authors
-    MyString institute(institute_name);
+    // Count and display institute authors, all institutes in one scan
     printf("=== Institute Author Analysis ===\n");
-    database.print_institute_authors(institute);
+    if (!institutes.build()) {
+        printf("Failed to build the institute matcher\n");
+        return 1;
+    }
+    database.print_institute_authors(institutes);
+
+    // Rank titles and abstracts before sorting changes entry positions
+    if (!search_query.empty()) {
+        printf("\n=== Full-Text Search ===\n");
+        search_database(database, filename, search_query, cache_index ? &index_source : nullptr, thread_count);
+    }
+
+    if (top_authors > 0) {
+        printf("\n=== Most Prolific Authors ===\n");
+        database.print_top_authors(top_authors);
+    }
 
     // Demonstrate sorting (requirement 2)
     printf("\n=== Sorting Demonstration ===\n");
@@ -56,11 +84,25 @@ int main(int argc, char* argv[]) {
 }
 
 void print_usage(const char* program_name) {
-    printf("Usage: %s <bib_file> <institute_name>\n", program_name);
+    printf("Usage: %s <bib_file> <institute_name>... [--institutes FILE] [--threads N] [--no-snapshot]\n"
+           "       [--search QUERY] [--top-authors N]\n",
+           program_name);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --institutes FILE  Also count the institutes listed in FILE, one per line\n");
+    printf("  --threads N        Parse the file on N threads (0 = all processors, default 1)\n");
+    printf("  --no-snapshot      Always parse the file; do not read or write <bib_file>.snap or .idx\n");
+    printf("  --search QUERY     Show the 10 entries whose title and abstract best match QUERY\n");
+    printf("  --top-authors N    Show the N authors with the most entries, merging spellings of a name\n");
     printf("\n");
     printf("Examples:\n");
     printf("  %s papers.bib \"IIIT\"\n", program_name);
     printf("  %s references.bib \"University of California\"\n", program_name);
+    printf("  %s large.bib \"IIIT\" --threads 4\n", program_name);
+    printf("  %s papers.bib IIITD \"IIT Delhi\" IISc\n", program_name);
+    printf("  %s papers.bib --institutes institutes.txt\n", program_name);
+    printf("  %s papers.bib IIITD --search \"energy efficient video streaming\"\n", program_name);
+    printf("  %s papers.bib IIITD --top-authors 20\n", program_name);
     printf("\n");
     printf("This program:\n");
     printf("1. Parses BibTeX files using C++ OOP principles\n");
@@ -69,8 +111,12 @@ void print_usage(const char* program_name) {
     printf("4. Does not use any standard C/C++ libraries\n");
 }
 
-bool validate_arguments(int argc, char* argv[]) {
-    if (argc != 3) {
+// Collects the institutes named on the command line or in --institutes
+// files, the --threads count, --no-snapshot, the --search query and the
+// --top-authors count
+bool parse_arguments(int argc, char* argv[], InstituteSet& institutes, int& thread_count,
+                     bool& use_snapshot, MyString& search_query, unsigned int& top_authors) {
+    if (argc < 3) {
         printf("Error: Incorrect number of arguments\n");
         return false;
     }
@@ -80,14 +126,124 @@ bool validate_arguments(int argc, char* argv[]) {
         return false;
     }
 
-    if (!argv[2] || MyString::strlen(argv[2]) == 0) {
-        printf("Error: Empty institute name\n");
+    for (int i = 2; i < argc; i++) {
+        MyString argument(argv[i]);
+        if (argument == "--threads" || argument == "-j") {
+            if (i + 1 == argc || !is_number(argv[i + 1])) {
+                printf("Error: Thread count must be a non-negative number\n");
+                return false;
+            }
+            int count = 0;
+            for (const char* c = argv[++i]; *c; c++) {
+                count = count * 10 + (*c - '0');
+                if (count > 1024) count = 1024;
+            }
+            thread_count = count == 0 ? online_cpu_count() : count;
+        } else if (argument == "--no-snapshot") {
+            use_snapshot = false;
+        } else if (argument == "--search") {
+            if (i + 1 == argc || MyString::strlen(argv[i + 1]) == 0) {
+                printf("Error: Missing search query\n");
+                return false;
+            }
+            search_query = MyString(argv[++i]);
+        } else if (argument == "--top-authors") {
+            if (i + 1 == argc || !is_number(argv[i + 1])) {
+                printf("Error: Author count must be a non-negative number\n");
+                return false;
+            }
+            unsigned int count = 0;
+            for (const char* c = argv[++i]; *c; c++) {
+                count = count * 10 + (*c - '0');
+                if (count > 100000) count = 100000;
+            }
+            top_authors = count;
+        } else if (argument == "--institutes") {
+            if (i + 1 == argc) {
+                printf("Error: Missing institute file\n");
+                return false;
+            }
+            if (!institutes.load_from_file(argv[++i])) {
+                printf("Error: Cannot read institute file %s\n", argv[i]);
+                return false;
+            }
+        } else if (argument.length() > 1 && argument[0] == '-' && argument[1] == '-') {
+            printf("Error: Unknown option %s\n", argv[i]);
+            return false;
+        } else if (argument.empty()) {
+            printf("Error: Empty institute name\n");
+            return false;
+        } else {
+            institutes.add(argument);
+        }
+    }
+
+    if (institutes.size() == 0) {
+        printf("Error: No institute names given\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool is_number(const char* text) {
+    if (*text == '\0') return false;
+    for (const char* c = text; *c; c++) {
+        if (*c < '0' || *c > '9') return false;
+    }
+    return true;
+}
+
+// A binary snapshot next to the .bib file replaces parsing while the
+// file is unchanged; after a parse, the snapshot is (re)written
+bool load_database(BibDatabase& database, const MyString& filename, bool use_snapshot) {
+    MyString snapshot_name = filename + MyString(".snap");
+    if (use_snapshot && database.load_snapshot(snapshot_name, filename)) {
+        return true;
+    }
+
+    // Stamped before parsing, so an edit made meanwhile makes the snapshot stale
+    SourceStamp source;
+    bool stamped = use_snapshot && source.capture(filename.c_str());
+
+    if (!database.load_from_file(filename)) {
         return false;
     }
 
+    if (stamped && !database.save_snapshot(snapshot_name, source)) {
+        printf("Note: Could not write snapshot %s\n", snapshot_name.c_str());
+    }
     return true;
 }
 
+// The index is read from <bib_file>.idx when source is given and the file
+// still matches it, and otherwise built and (with a source) written there
+void search_database(const BibDatabase& database, const MyString& filename, const MyString& query,
+                     const SourceStamp* source, int thread_count) {
+    TextIndex index;
+    MyString index_name = filename + MyString(".idx");
+    bool cached = source && index.load(index_name.c_str(), filename.c_str()) &&
+                  index.get_entry_count() == database.size();
+    if (!cached) {
+        if (!index.build(database, thread_count)) {
+            printf("Failed to build the search index\n");
+            return;
+        }
+        if (source && !index.save(index_name.c_str(), *source)) {
+            printf("Note: Could not write search index %s\n", index_name.c_str());
+        }
+    }
+
+    MyVector<TextHit> hits;
+    index.top_k(query, 10, hits);
+    printf("Best matches for \"%s\" (%lu terms indexed):\n", query.c_str(), index.get_term_count());
+    if (hits.empty()) printf("No entry matches.\n");
+    for (unsigned long i = 0; i < hits.get_size(); i++) {
+        const BibEntry& entry = database.get_entry(hits[i].entry);
+        printf("%lu. (%.2f) [%s] %s\n", i + 1, hits[i].score, entry.get_year().c_str(), entry.get_title().c_str());
+    }
+}
+
 void demonstrate_sorting(BibDatabase& db) {
     printf("Sorting entries by <year descending, title ascending>...\n");
 
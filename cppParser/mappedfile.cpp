@@ -0,0 +1,107 @@
+// mappedfile.cpp - Implementation of the read-only memory-mapped file
+#include "mappedfile.h"
+
+// System calls for file mapping
+extern "C" {
+    int open(const char* path, int flags, ...);
+    int close(int fd);
+    long lseek(int fd, long offset, int whence);
+    void* mmap(void* addr, unsigned long length, int prot, int flags, int fd, long offset);
+    int munmap(void* addr, unsigned long length);
+    int madvise(void* addr, unsigned long length, int advice);
+}
+
+#ifndef O_RDONLY
+#define O_RDONLY 0
+#endif
+#ifndef SEEK_END
+#define SEEK_END 2
+#endif
+#ifndef PROT_READ
+#define PROT_READ 1
+#endif
+#ifndef PROT_WRITE
+#define PROT_WRITE 2
+#endif
+#ifndef MAP_PRIVATE
+#define MAP_PRIVATE 2
+#endif
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void*)-1)
+#endif
+#ifndef MADV_SEQUENTIAL
+#define MADV_SEQUENTIAL 2
+#endif
+
+// Constructor
+MappedFile::MappedFile() : data(nullptr), length(0) {}
+
+// Destructor
+MappedFile::~MappedFile() {
+    close();
+}
+
+// File management
+bool MappedFile::open(const char* filename, bool private_copy) {
+    if (!filename) return false;
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    long file_size = lseek(fd, 0, SEEK_END);
+    if (file_size < 0) {
+        // Not seekable (pipe, terminal, ...) - cannot be mapped
+        ::close(fd);
+        return false;
+    }
+
+    if (file_size == 0) {
+        // Nothing to map; an empty file is still a valid input
+        ::close(fd);
+        length = 0;
+        return true;
+    }
+
+    int protection = private_copy ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* mapping = mmap(nullptr, (unsigned long)file_size, protection, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+    if (mapping == MAP_FAILED) return false;
+
+    madvise(mapping, (unsigned long)file_size, MADV_SEQUENTIAL);
+    data = (const char*)mapping;
+    length = (unsigned long)file_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) {
+        unmap(data, length);
+        data = nullptr;
+    }
+    length = 0;
+}
+
+bool MappedFile::is_open() const {
+    return data != nullptr;
+}
+
+// Accessors
+const char* MappedFile::get_data() const {
+    return data;
+}
+
+unsigned long MappedFile::size() const {
+    return length;
+}
+
+const char* MappedFile::detach() {
+    const char* mapping = data;
+    data = nullptr;
+    length = 0;
+    return mapping;
+}
+
+void MappedFile::unmap(const char* mapping, unsigned long length) {
+    if (mapping) munmap((void*)mapping, length);
+}
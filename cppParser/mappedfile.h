@@ -0,0 +1,39 @@
+// mappedfile.h - Read-only memory-mapped file
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+// Maps a whole file read-only into memory so the parser can work directly
+// on the file bytes without copying them into intermediate line buffers.
+class MappedFile {
+private:
+    const char* data;
+    unsigned long length;
+
+    // Disable copying - the mapping has a single owner
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+
+public:
+    // Constructor
+    MappedFile();
+
+    // Destructor
+    ~MappedFile();
+
+    // File management. A private copy is mapped writable: writes change
+    // only this process's pages, never the file.
+    bool open(const char* filename, bool private_copy = false);
+    void close();
+    bool is_open() const;       // True while a non-empty mapping is held
+
+    // Accessors (data may be null for an empty file)
+    const char* get_data() const;
+    unsigned long size() const;
+
+    // Gives up ownership of the mapping, which the caller must later pass
+    // to unmap(); the object ends up closed
+    const char* detach();
+    static void unmap(const char* mapping, unsigned long length);
+};
+
+#endif // MAPPEDFILE_H
@@ -1,5 +1,8 @@
 // mystring.cpp - Implementation of custom string class
 #include "mystring.h"
+#include "stringarena.h"
+
+unsigned long MyString::allocation_count = 0;
 
 // Constructor implementations
 MyString::MyString() : data(nullptr), len(0), capacity(0) {
@@ -11,7 +14,19 @@ MyString::MyString(const char* str) : data(nullptr), len(0), capacity(0) {
     if (str) {
         len = strlen(str);
         allocate(len + 1);
-        strcpy(data, str);
+        memcpy(data, str, len + 1);
+    } else {
+        allocate(1);
+        data[0] = '\0';
+    }
+}
+
+MyString::MyString(const char* str, unsigned long n) : data(nullptr), len(0), capacity(0) {
+    if (str && n > 0) {
+        len = n;
+        allocate(len + 1);
+        memcpy(data, str, len);
+        data[len] = '\0';
     } else {
         allocate(1);
         data[0] = '\0';
@@ -21,7 +36,11 @@ MyString::MyString(const char* str) : data(nullptr), len(0), capacity(0) {
 MyString::MyString(const MyString& other) : data(nullptr), len(0), capacity(0) {
     len = other.len;
     allocate(len + 1);
-    strcpy(data, other.data);
+    memcpy(data, other.data, len + 1);
+}
+
+MyString::MyString(MyString&& other) : data(nullptr), len(0), capacity(0) {
+    take(other);
 }
 
 // Destructor
@@ -31,26 +50,22 @@ MyString::~MyString() {
 
 // Assignment operators
 MyString& MyString::operator=(const MyString& other) {
+    if (this != &other) {
+        assign(other.data, other.len);
+    }
+    return *this;
+}
+
+MyString& MyString::operator=(MyString&& other) {
     if (this != &other) {
         deallocate();
-        len = other.len;
-        allocate(len + 1);
-        strcpy(data, other.data);
+        take(other);
     }
     return *this;
 }
 
 MyString& MyString::operator=(const char* str) {
-    deallocate();
-    if (str) {
-        len = strlen(str);
-        allocate(len + 1);
-        strcpy(data, str);
-    } else {
-        len = 0;
-        allocate(1);
-        data[0] = '\0';
-    }
+    assign(str, strlen(str));
     return *this;
 }
 
@@ -76,15 +91,15 @@ MyString MyString::operator+(const MyString& other) const {
     MyString result;
     result.len = len + other.len;
     result.allocate(result.len + 1);
-    strcpy(result.data, data);
-    strcpy(result.data + len, other.data);
+    memcpy(result.data, data, len);
+    memcpy(result.data + len, other.data, other.len + 1);
     return result;
 }
 
 MyString& MyString::operator+=(const MyString& other) {
     unsigned long new_len = len + other.len;
     if (new_len + 1 > capacity) {
-        resize(new_len + 1);
+        grow(new_len + 1);
     }
     strcpy(data + len, other.data);
     len = new_len;
@@ -96,7 +111,7 @@ MyString& MyString::operator+=(const char* str) {
         unsigned long str_len = strlen(str);
         unsigned long new_len = len + str_len;
         if (new_len + 1 > capacity) {
-            resize(new_len + 1);
+            grow(new_len + 1);
         }
         strcpy(data + len, str);
         len = new_len;
@@ -104,6 +119,19 @@ MyString& MyString::operator+=(const char* str) {
     return *this;
 }
 
+MyString& MyString::append(const char* str, unsigned long n) {
+    if (str && n > 0) {
+        unsigned long new_len = len + n;
+        if (new_len + 1 > capacity) {
+            grow(new_len + 1);
+        }
+        memcpy(data + len, str, n);
+        data[new_len] = '\0';
+        len = new_len;
+    }
+    return *this;
+}
+
 // Access operators
 char& MyString::operator[](unsigned long index) {
     return data[index];
@@ -128,11 +156,35 @@ bool MyString::empty() const {
 
 void MyString::clear() {
     deallocate();
-    len = 0;
     allocate(1);
     data[0] = '\0';
 }
 
+// Capacity
+void MyString::reserve(unsigned long n) {
+    if (n + 1 > capacity) resize(n + 1);
+}
+
+void MyString::shrink_to_fit() {
+    if (!data || is_small() || small_buffer[0] == ARENA_BUFFER || len + 1 == capacity) return;
+
+    char* old_data = data;
+    if (len + 1 <= SMALL_BUFFER_SIZE) {
+        memcpy(small_buffer, old_data, len + 1);
+        data = small_buffer;
+        capacity = SMALL_BUFFER_SIZE;
+    } else {
+        char source;
+        char* new_data = allocate_buffer(len + 1, source);
+        if (!new_data) return;
+        memcpy(new_data, old_data, len + 1);
+        data = new_data;
+        capacity = len + 1;
+        small_buffer[0] = source;
+    }
+    release_buffer(old_data, MALLOC_BUFFER);
+}
+
 // String manipulation methods
 MyString MyString::substr(unsigned long pos, unsigned long length) const {
     if (pos >= len) return MyString();
@@ -141,7 +193,7 @@ MyString MyString::substr(unsigned long pos, unsigned long length) const {
     MyString result;
     result.len = actual_len;
     result.allocate(actual_len + 1);
-    strncpy(result.data, data + pos, actual_len);
+    memcpy(result.data, data + pos, actual_len);
     result.data[actual_len] = '\0';
     return result;
 }
@@ -194,10 +246,59 @@ MyString& MyString::to_lower() {
     return *this;
 }
 
+unsigned long MyString::hash() const {
+    return hash_bytes(data, len);
+}
+
+MyString MyString::wrap_arena(char* text, unsigned long length) {
+    if (length + 1 <= SMALL_BUFFER_SIZE) return MyString(text, length);
+
+    MyString result;
+    result.data = text;
+    result.len = length;
+    result.capacity = length + 1;
+    result.small_buffer[0] = ARENA_BUFFER;
+    return result;
+}
+
 // Private helper methods
+bool MyString::is_small() const {
+    return data == small_buffer;
+}
+
+bool MyString::is_arena_backed() const {
+    return data && !is_small() && small_buffer[0] == ARENA_BUFFER;
+}
+
+// Gets a buffer from the calling thread's arena if one is installed,
+// otherwise from malloc; source receives the matching buffer tag
+char* MyString::allocate_buffer(unsigned long size, char& source) {
+    StringArena* arena = StringArena::current();
+    if (arena) {
+        source = ARENA_BUFFER;
+        return arena->allocate(size);
+    }
+    source = MALLOC_BUFFER;
+    __atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+    return (char*)malloc(size);
+}
+
+// Arena buffers are reclaimed with their arena, never one by one
+void MyString::release_buffer(char* buffer, char source) {
+    if (source != ARENA_BUFFER) {
+        free(buffer);
+    }
+}
+
 void MyString::allocate(unsigned long size) {
+    if (size <= SMALL_BUFFER_SIZE) {
+        data = small_buffer;
+        capacity = SMALL_BUFFER_SIZE;
+        return;
+    }
+
     capacity = size;
-    data = (char*)malloc(capacity);
+    data = allocate_buffer(capacity, small_buffer[0]);
     if (!data) {
         // Handle allocation failure - for simplicity, we'll just set to null
         capacity = 0;
@@ -207,7 +308,9 @@ void MyString::allocate(unsigned long size) {
 
 void MyString::deallocate() {
     if (data) {
-        free(data);
+        if (!is_small()) {
+            release_buffer(data, small_buffer[0]);
+        }
         data = nullptr;
         len = 0;
         capacity = 0;
@@ -217,16 +320,80 @@ void MyString::deallocate() {
 void MyString::resize(unsigned long new_size) {
     if (new_size <= capacity) return;
 
-    char* new_data = (char*)malloc(new_size);
+    char source;
+    char* new_data = allocate_buffer(new_size, source);
     if (!new_data) return; // Handle allocation failure
 
     if (data) {
         memcpy(new_data, data, len + 1);
-        free(data);
+        if (!is_small()) {
+            release_buffer(data, small_buffer[0]);
+        }
     }
 
     data = new_data;
     capacity = new_size;
+    small_buffer[0] = source;
+}
+
+// Appends at least double a heap buffer, so a string built from n appends
+// is copied O(n) times in total rather than once per append. Leaving the
+// inline buffer allocates exactly, since most strings are appended once.
+void MyString::grow(unsigned long min_size) {
+    unsigned long new_size = is_small() ? min_size : capacity * 2;
+    if (new_size < min_size) new_size = min_size;
+    resize(new_size);
+}
+
+// Steals other's heap buffer (or copies its inline bytes) and leaves it empty
+void MyString::take(MyString& other) {
+    len = other.len;
+    if (other.is_small()) {
+        data = small_buffer;
+        capacity = SMALL_BUFFER_SIZE;
+        memcpy(small_buffer, other.small_buffer, len + 1);
+    } else {
+        data = other.data;
+        capacity = other.capacity;
+        small_buffer[0] = other.small_buffer[0];
+        if (!data) {
+            // other lost its buffer to an allocation failure
+            allocate(1);
+            if (data) data[0] = '\0';
+        }
+    }
+
+    other.data = other.small_buffer;
+    other.capacity = SMALL_BUFFER_SIZE;
+    other.len = 0;
+    other.small_buffer[0] = '\0';
+}
+
+void MyString::assign(const char* str, unsigned long n) {
+    if (!str) n = 0;
+
+    if (data && n + 1 <= capacity) {
+        // Reuse the current buffer; str may point into it
+        if (n > 0) memmove(data, str, n);
+        data[n] = '\0';
+        len = n;
+        return;
+    }
+
+    // Build the new buffer before releasing the old one, in case str aliases it
+    char* old_data = data;
+    bool old_small = is_small();
+    char old_source = small_buffer[0];
+    data = nullptr;
+    len = n;
+    allocate(n + 1);
+    if (data) {
+        if (n > 0) memcpy(data, str, n);
+        data[n] = '\0';
+    }
+    if (old_data && !old_small) {
+        release_buffer(old_data, old_source);
+    }
 }
 
 // Static utility functions
@@ -314,3 +481,20 @@ char MyString::tolower(char c) {
 bool MyString::isspace(char c) {
     return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
 }
+
+unsigned long MyString::hash_bytes(const char* bytes, unsigned long n) {
+    unsigned long h = 14695981039346656037UL;  // FNV-1a offset basis
+    for (unsigned long i = 0; i < n; i++) {
+        h ^= (unsigned char)bytes[i];
+        h *= 1099511628211UL;                    // FNV-1a prime
+    }
+    return h;
+}
+
+unsigned long MyString::get_allocation_count() {
+    return __atomic_load_n(&allocation_count, __ATOMIC_RELAXED);
+}
+
+void MyString::reset_allocation_count() {
+    __atomic_store_n(&allocation_count, 0, __ATOMIC_RELAXED);
+}
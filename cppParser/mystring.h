@@ -14,25 +14,46 @@ extern "C" {
 
 class MyString {
 private:
-    char* data;
+    // Strings up to SMALL_BUFFER_SIZE - 1 characters (and the empty string)
+    // are stored inline and never touch the heap
+    static const unsigned long SMALL_BUFFER_SIZE = 16;
+
+    // While data points elsewhere, small_buffer[0] records where the
+    // buffer came from so it is released the right way
+    static const char MALLOC_BUFFER = 0;
+    static const char ARENA_BUFFER = 1;
+
+    char* data;             // Points at small_buffer, a malloc'd block or arena memory
     unsigned long len;
     unsigned long capacity;
+    char small_buffer[SMALL_BUFFER_SIZE];
 
+    static unsigned long allocation_count;
+
+    static char* allocate_buffer(unsigned long size, char& source);
+    static void release_buffer(char* buffer, char source);
     void allocate(unsigned long size);
     void deallocate();
     void resize(unsigned long new_size);
+    void grow(unsigned long min_size);
+    void assign(const char* str, unsigned long n);
+    bool is_small() const;
+    void take(MyString& other);
 
 public:
     // Constructors
     MyString();
     MyString(const char* str);
+    MyString(const char* str, unsigned long n);
     MyString(const MyString& other);
+    MyString(MyString&& other);
 
     // Destructor
     ~MyString();
 
     // Assignment operator
     MyString& operator=(const MyString& other);
+    MyString& operator=(MyString&& other);
     MyString& operator=(const char* str);
 
     // Comparison operators
@@ -45,6 +66,7 @@ public:
     MyString operator+(const MyString& other) const;
     MyString& operator+=(const MyString& other);
     MyString& operator+=(const char* str);
+    MyString& append(const char* str, unsigned long n);
 
     // Access operators
     char& operator[](unsigned long index);
@@ -55,6 +77,12 @@ public:
     const char* c_str() const;
     bool empty() const;
     void clear();
+    bool is_arena_backed() const;   // The characters live in a StringArena
+
+    // Capacity - reserve() makes room for at least n characters; shrink_to_fit()
+    // trims a malloc'd buffer to the length (arena buffers are left alone)
+    void reserve(unsigned long n);
+    void shrink_to_fit();
 
     // String manipulation
     MyString substr(unsigned long pos, unsigned long len = 0) const;
@@ -66,6 +94,9 @@ public:
     MyString& trim();
     MyString& to_lower();
 
+    // 64-bit FNV-1a hash of the characters (equal strings hash equally)
+    unsigned long hash() const;
+
     // Static utility functions
     static unsigned long strlen(const char* str);
     static char* strcpy(char* dest, const char* src);
@@ -75,6 +106,18 @@ public:
     static char* strstr(const char* haystack, const char* needle);
     static char tolower(char c);
     static bool isspace(char c);
+    static unsigned long hash_bytes(const char* bytes, unsigned long n);
+
+    // A string over length bytes of memory owned by a StringArena (such as
+    // a mapping it adopted), which must be writable and followed by '\0'.
+    // Nothing is copied unless the string is short enough to live inline;
+    // like any arena buffer, the bytes must outlive the string.
+    static MyString wrap_arena(char* text, unsigned long length);
+
+    // Heap allocation statistics (number of malloc calls made by MyString;
+    // buffers taken from a StringArena are not counted)
+    static unsigned long get_allocation_count();
+    static void reset_allocation_count();
 };
 
 #endif // MYSTRING_H
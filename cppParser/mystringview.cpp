@@ -0,0 +1,153 @@
+// mystringview.cpp - Implementation of the non-owning string view
+#include "mystringview.h"
+
+// Constructors
+MyStringView::MyStringView() : ptr(""), len(0) {}
+
+MyStringView::MyStringView(const char* str) : ptr(str ? str : ""), len(MyString::strlen(str)) {}
+
+MyStringView::MyStringView(const char* str, unsigned long n) : ptr(str ? str : ""), len(str ? n : 0) {}
+
+MyStringView::MyStringView(const MyString& str) : ptr(str.c_str() ? str.c_str() : ""), len(str.length()) {}
+
+// Comparison operators
+bool MyStringView::operator==(const MyStringView& other) const {
+    return len == other.len && memcmp(ptr, other.ptr, len) == 0;
+}
+
+bool MyStringView::operator!=(const MyStringView& other) const {
+    return !(*this == other);
+}
+
+bool MyStringView::operator<(const MyStringView& other) const {
+    return compare(other) < 0;
+}
+
+// Access operator
+char MyStringView::operator[](unsigned long index) const {
+    return ptr[index];
+}
+
+// Utility methods
+const char* MyStringView::data() const {
+    return ptr;
+}
+
+unsigned long MyStringView::length() const {
+    return len;
+}
+
+bool MyStringView::empty() const {
+    return len == 0;
+}
+
+MyString MyStringView::to_string() const {
+    return MyString(ptr, len);
+}
+
+// Searching
+unsigned long MyStringView::find(char c, unsigned long pos) const {
+    for (unsigned long i = pos; i < len; i++) {
+        if (ptr[i] == c) return i;
+    }
+    return len;
+}
+
+unsigned long MyStringView::find(const MyStringView& str, unsigned long pos) const {
+    if (pos > len || str.len > len - pos) return len;
+    if (str.len == 0) return pos;
+
+    unsigned long last = len - str.len;
+    for (unsigned long i = pos; i <= last; i++) {
+        if (ptr[i] == str.ptr[0] && memcmp(ptr + i, str.ptr, str.len) == 0) {
+            return i;
+        }
+    }
+    return len;
+}
+
+unsigned long MyStringView::find_first_of(const char* chars, unsigned long pos) const {
+    if (!chars) return len;
+
+    for (unsigned long i = pos; i < len; i++) {
+        for (const char* c = chars; *c; ++c) {
+            if (ptr[i] == *c) return i;
+        }
+    }
+    return len;
+}
+
+// Sub-ranges
+MyStringView MyStringView::substr(unsigned long pos, unsigned long n) const {
+    if (pos >= len) return MyStringView();
+    if (n > len - pos) n = len - pos;
+    return MyStringView(ptr + pos, n);
+}
+
+MyStringView& MyStringView::trim() {
+    while (len > 0 && MyString::isspace(*ptr)) {
+        ptr++;
+        len--;
+    }
+    while (len > 0 && MyString::isspace(ptr[len - 1])) {
+        len--;
+    }
+    return *this;
+}
+
+MyStringView MyStringView::trimmed() const {
+    MyStringView result = *this;
+    return result.trim();
+}
+
+void MyStringView::remove_prefix(unsigned long n) {
+    if (n > len) n = len;
+    ptr += n;
+    len -= n;
+}
+
+void MyStringView::remove_suffix(unsigned long n) {
+    if (n > len) n = len;
+    len -= n;
+}
+
+// Comparison
+int MyStringView::compare(const MyStringView& other) const {
+    unsigned long common = len < other.len ? len : other.len;
+    int result = memcmp(ptr, other.ptr, common);
+    if (result != 0) return result;
+    if (len == other.len) return 0;
+    return len < other.len ? -1 : 1;
+}
+
+int MyStringView::compare_ignore_case(const MyStringView& other) const {
+    unsigned long common = len < other.len ? len : other.len;
+    for (unsigned long i = 0; i < common; i++) {
+        unsigned char a = (unsigned char)MyString::tolower(ptr[i]);
+        unsigned char b = (unsigned char)MyString::tolower(other.ptr[i]);
+        if (a != b) return a - b;
+    }
+    if (len == other.len) return 0;
+    return len < other.len ? -1 : 1;
+}
+
+bool MyStringView::equals_ignore_case(const MyStringView& other) const {
+    return len == other.len && compare_ignore_case(other) == 0;
+}
+
+bool MyStringView::starts_with(const MyStringView& prefix) const {
+    return prefix.len <= len && memcmp(ptr, prefix.ptr, prefix.len) == 0;
+}
+
+bool MyStringView::starts_with_ignore_case(const MyStringView& prefix) const {
+    return prefix.len <= len && MyStringView(ptr, prefix.len).compare_ignore_case(prefix) == 0;
+}
+
+bool MyStringView::ends_with(const MyStringView& suffix) const {
+    return suffix.len <= len && memcmp(ptr + len - suffix.len, suffix.ptr, suffix.len) == 0;
+}
+
+// Hashing
+unsigned long MyStringView::hash() const {
+    return MyString::hash_bytes(ptr, len);
+}
@@ -0,0 +1,62 @@
+// mystringview.h - Non-owning view over a range of characters
+#ifndef MYSTRINGVIEW_H
+#define MYSTRINGVIEW_H
+
+#include "mystring.h"
+
+// A pointer and a length into characters owned by someone else (a MyString,
+// a mapped file, a read buffer). Views never allocate; the viewed memory
+// must outlive the view. The range is not necessarily null-terminated.
+class MyStringView {
+private:
+    const char* ptr;
+    unsigned long len;
+
+public:
+    static const unsigned long npos = (unsigned long)-1;
+
+    // Constructors
+    MyStringView();
+    MyStringView(const char* str);
+    MyStringView(const char* str, unsigned long n);
+    MyStringView(const MyString& str);
+
+    // Comparison operators
+    bool operator==(const MyStringView& other) const;
+    bool operator!=(const MyStringView& other) const;
+    bool operator<(const MyStringView& other) const;
+
+    // Access operator
+    char operator[](unsigned long index) const;
+
+    // Utility methods
+    const char* data() const;
+    unsigned long length() const;
+    bool empty() const;
+    MyString to_string() const;
+
+    // Searching (return length() when not found, like MyString)
+    unsigned long find(char c, unsigned long pos = 0) const;
+    unsigned long find(const MyStringView& str, unsigned long pos = 0) const;
+    unsigned long find_first_of(const char* chars, unsigned long pos = 0) const;
+
+    // Sub-ranges (n is clamped to the end of the view)
+    MyStringView substr(unsigned long pos, unsigned long n = npos) const;
+    MyStringView& trim();
+    MyStringView trimmed() const;
+    void remove_prefix(unsigned long n);
+    void remove_suffix(unsigned long n);
+
+    // Comparison
+    int compare(const MyStringView& other) const;
+    int compare_ignore_case(const MyStringView& other) const;
+    bool equals_ignore_case(const MyStringView& other) const;
+    bool starts_with(const MyStringView& prefix) const;
+    bool starts_with_ignore_case(const MyStringView& prefix) const;
+    bool ends_with(const MyStringView& suffix) const;
+
+    // Same hash as MyString::hash() for the same characters
+    unsigned long hash() const;
+};
+
+#endif // MYSTRINGVIEW_H
@@ -0,0 +1,35 @@
+// myutility.h - Move and forwarding helpers (replacements for std::move/std::forward)
+#ifndef MYUTILITY_H
+#define MYUTILITY_H
+
+// Strips references from a type
+template<typename T> struct MyRemoveReference { typedef T type; };
+template<typename T> struct MyRemoveReference<T&> { typedef T type; };
+template<typename T> struct MyRemoveReference<T&&> { typedef T type; };
+
+// Casts to an rvalue reference so the move constructor/assignment is chosen
+template<typename T>
+inline typename MyRemoveReference<T>::type&& my_move(T&& value) {
+    return static_cast<typename MyRemoveReference<T>::type&&>(value);
+}
+
+// Perfect forwarding for emplace-style constructors
+template<typename T>
+inline T&& my_forward(typename MyRemoveReference<T>::type& value) {
+    return static_cast<T&&>(value);
+}
+
+template<typename T>
+inline T&& my_forward(typename MyRemoveReference<T>::type&& value) {
+    return static_cast<T&&>(value);
+}
+
+// Swaps two objects with three moves instead of three deep copies
+template<typename T>
+inline void my_swap(T& a, T& b) {
+    T temp(my_move(a));
+    a = my_move(b);
+    b = my_move(temp);
+}
+
+#endif // MYUTILITY_H
@@ -0,0 +1,143 @@
+// parallel.cpp - Implementation of the pthread worker pool
+#include "parallel.h"
+
+// POSIX threads (pthread_t is an unsigned long and pthread_once_t an int on
+// Linux; mutexes and condition variables are only used through pointers)
+extern "C" {
+    int pthread_create(unsigned long* thread, const void* attr, void* (*start_routine)(void*), void* arg);
+    int pthread_detach(unsigned long thread);
+    int pthread_once(int* once_control, void (*init_routine)());
+    int pthread_mutex_init(void* mutex, const void* attr);
+    int pthread_mutex_lock(void* mutex);
+    int pthread_mutex_unlock(void* mutex);
+    int pthread_cond_init(void* cond, const void* attr);
+    int pthread_cond_wait(void* cond, void* mutex);
+    int pthread_cond_signal(void* cond);
+    int pthread_cond_broadcast(void* cond);
+    long sysconf(int name);
+}
+
+#ifndef _SC_NPROCESSORS_ONLN
+#define _SC_NPROCESSORS_ONLN 84
+#endif
+
+// Room for pthread_mutex_t or pthread_cond_t (at most 48 bytes on Linux)
+struct PthreadStorage {
+    union {
+        char bytes[64];
+        long align;
+    };
+};
+
+// State shared by all workers of one parallel_for call
+struct ParallelJob {
+    ParallelTask task;
+    void* context;
+    unsigned long task_count;
+    unsigned long next_index;   // Claimed with an atomic fetch-add
+};
+
+// Helper threads live for the rest of the process. Each call publishes its
+// job and wakes them; sleeping workers claim the helpers_wanted slots, and
+// the call returns once every claimed slot has run out of tasks.
+struct ParallelPool {
+    PthreadStorage mutex;
+    PthreadStorage wake;        // Signalled when a job is published
+    PthreadStorage finished;    // Signalled when the last helper slot is done
+    ParallelJob* job;           // Null between calls
+    unsigned long worker_count;
+    unsigned long helpers_wanted;
+    unsigned long helpers_joined;
+    unsigned long helpers_done;
+    bool busy;                  // A parallel_for call owns the pool
+};
+
+static ParallelPool pool;
+static int pool_once = 0;       // PTHREAD_ONCE_INIT
+
+static void init_pool() {
+    pthread_mutex_init(&pool.mutex, nullptr);
+    pthread_cond_init(&pool.wake, nullptr);
+    pthread_cond_init(&pool.finished, nullptr);
+}
+
+static void run_job(ParallelJob* job) {
+    while (true) {
+        unsigned long index = __atomic_fetch_add(&job->next_index, 1, __ATOMIC_RELAXED);
+        if (index >= job->task_count) break;
+        job->task(job->context, index);
+    }
+}
+
+static void* pool_worker(void*) {
+    pthread_mutex_lock(&pool.mutex);
+    while (true) {
+        while (!pool.job || pool.helpers_joined == pool.helpers_wanted) {
+            pthread_cond_wait(&pool.wake, &pool.mutex);
+        }
+        pool.helpers_joined++;
+        ParallelJob* job = pool.job;
+        pthread_mutex_unlock(&pool.mutex);
+        run_job(job);
+        pthread_mutex_lock(&pool.mutex);
+        if (++pool.helpers_done == pool.helpers_wanted) pthread_cond_signal(&pool.finished);
+    }
+    return nullptr;
+}
+
+void parallel_for(int thread_count, unsigned long task_count, ParallelTask task, void* context) {
+    if (!task || task_count == 0) return;
+
+    ParallelJob job;
+    job.task = task;
+    job.context = context;
+    job.task_count = task_count;
+    job.next_index = 0;
+
+    // No point waking more threads than there are tasks
+    unsigned long helpers = thread_count > 1 ? (unsigned long)(thread_count - 1) : 0;
+    if (helpers > task_count - 1) helpers = task_count - 1;
+    if (helpers == 0) {
+        run_job(&job);
+        return;
+    }
+
+    pthread_once(&pool_once, init_pool);
+    pthread_mutex_lock(&pool.mutex);
+    if (pool.busy) {
+        // Nested or concurrent call: the pool's workers are taken
+        pthread_mutex_unlock(&pool.mutex);
+        run_job(&job);
+        return;
+    }
+    pool.busy = true;
+
+    while (pool.worker_count < helpers) {
+        unsigned long thread;
+        if (pthread_create(&thread, nullptr, pool_worker, nullptr) != 0) break;
+        pthread_detach(thread);
+        pool.worker_count++;
+    }
+    if (helpers > pool.worker_count) helpers = pool.worker_count;
+
+    pool.job = &job;
+    pool.helpers_wanted = helpers;
+    pool.helpers_joined = 0;
+    pool.helpers_done = 0;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.mutex);
+
+    // The calling thread works too; it finishes the loop alone if no worker started
+    run_job(&job);
+
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.helpers_done < helpers) pthread_cond_wait(&pool.finished, &pool.mutex);
+    pool.job = nullptr;
+    pool.busy = false;
+    pthread_mutex_unlock(&pool.mutex);
+}
+
+int online_cpu_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
@@ -0,0 +1,22 @@
+// parallel.h - Minimal pthread worker pool for data-parallel loops
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Called once per task index; context is passed through unchanged
+typedef void (*ParallelTask)(void* context, unsigned long index);
+
+// Runs task(context, i) for every i in [0, task_count) on up to
+// thread_count threads (the calling thread is one of them). Workers pull
+// the next index from a shared atomic counter, so tasks of uneven size
+// balance out. Returns once every task has finished. Helper threads are
+// started the first time they are needed and then sleep until the next
+// call, so later calls only wake them. With thread_count <= 1, if no
+// thread can be started, or while another call holds the pool (a task
+// calling parallel_for, or a second thread), the tasks run on the calling
+// thread in index order.
+void parallel_for(int thread_count, unsigned long task_count, ParallelTask task, void* context);
+
+// Number of online processors (at least 1)
+int online_cpu_count();
+
+#endif // PARALLEL_H
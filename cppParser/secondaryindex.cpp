@@ -0,0 +1,173 @@
+// secondaryindex.cpp - Entry positions grouped by year, entry type or venue
+#include "secondaryindex.h"
+
+// Constructor
+SecondaryIndex::SecondaryIndex() : built(false) {}
+
+// Building
+void SecondaryIndex::add(long key, unsigned long position) {
+    Posting posting;
+    posting.key = key;
+    posting.position = position;
+    pending.push_back(posting);
+}
+
+long SecondaryIndex::key_id(const MyStringView& name) {
+    long id = find_key_id(name);
+    if (id >= 0) return id;
+
+    id = (long)names.get_size();
+    names.push_back(MyString(name.data(), name.length()));
+    name_lookup.insert(name.hash(), (unsigned long)id);
+    return id;
+}
+
+// Postings arrive in position order and both orderings below are stable,
+// so positions stay ascending within each key. Years and string ids span a
+// small range, where a counting sort is linear; anything else is merged.
+void SecondaryIndex::finish() {
+    positions.clear();
+    group_keys.clear();
+    group_starts.clear();
+
+    unsigned long count = pending.get_size();
+    long min_key = count > 0 ? pending[0].key : 0, max_key = min_key;
+    for (unsigned long i = 1; i < count; i++) {
+        if (pending[i].key < min_key) min_key = pending[i].key;
+        if (pending[i].key > max_key) max_key = pending[i].key;
+    }
+
+    unsigned long range = (unsigned long)(max_key - min_key) + 1;
+    unsigned long* starts = count > 0 && range <= count * 2 ?
+                            (unsigned long*)malloc(sizeof(unsigned long) * (range + 1)) : nullptr;
+    positions.reserve(count);
+    if (starts) {
+        for (unsigned long k = 0; k <= range; k++) starts[k] = 0;
+        for (unsigned long i = 0; i < count; i++) starts[pending[i].key - min_key + 1]++;
+        for (unsigned long k = 0; k < range; k++) {
+            if (starts[k + 1] > 0) {
+                group_keys.push_back(min_key + (long)k);
+                group_starts.push_back(starts[k]);
+            }
+            starts[k + 1] += starts[k];
+        }
+        for (unsigned long i = 0; i < count; i++) positions.push_back(0);
+        for (unsigned long i = 0; i < count; i++) {
+            positions[starts[pending[i].key - min_key]++] = pending[i].position;
+        }
+        free(starts);
+    } else {
+        pending.stable_sort();
+        for (unsigned long i = 0; i < count; i++) {
+            if (i == 0 || pending[i].key != pending[i - 1].key) {
+                group_keys.push_back(pending[i].key);
+                group_starts.push_back(i);
+            }
+            positions.push_back(pending[i].position);
+        }
+    }
+    group_starts.push_back(count);
+
+    pending.clear();
+    built = true;
+}
+
+bool SecondaryIndex::is_built() const {
+    return built;
+}
+
+void SecondaryIndex::clear() {
+    pending.clear();
+    positions.clear();
+    group_keys.clear();
+    group_starts.clear();
+    names.clear();
+    name_lookup.clear();
+    built = false;
+}
+
+// Queries
+unsigned long SecondaryIndex::lower_group(long key) const {
+    unsigned long low = 0, high = group_keys.get_size();
+    while (low < high) {
+        unsigned long middle = low + (high - low) / 2;
+        if (group_keys[middle] < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+unsigned long SecondaryIndex::find(long key, const unsigned long*& found) const {
+    return find_range(key, key, found);
+}
+
+unsigned long SecondaryIndex::find_range(long first_key, long last_key, const unsigned long*& found) const {
+    found = nullptr;
+    if (!built || first_key > last_key) return 0;
+
+    unsigned long first = lower_group(first_key);
+    unsigned long last = last_key == first_key ? first : lower_group(last_key);
+    if (last < group_keys.get_size() && group_keys[last] == last_key) last++;
+    if (first >= last) return 0;
+
+    found = &positions[group_starts[first]];
+    return group_starts[last] - group_starts[first];
+}
+
+long SecondaryIndex::find_key_id(const MyStringView& name) const {
+    unsigned long hash = name.hash();
+    unsigned long cursor = name_lookup.probe_start(hash);
+    unsigned long id;
+    while (name_lookup.next_candidate(hash, cursor, id)) {
+        const MyString& candidate = names[id];
+        if (candidate.length() == name.length() &&
+            memcmp(candidate.c_str(), name.data(), name.length()) == 0) {
+            return (long)id;
+        }
+    }
+    return -1;
+}
+
+unsigned long SecondaryIndex::get_group_count() const {
+    return group_keys.get_size();
+}
+
+long SecondaryIndex::get_group_key(unsigned long group) const {
+    return group_keys[group];
+}
+
+unsigned long SecondaryIndex::get_group_size(unsigned long group) const {
+    return group_starts[group + 1] - group_starts[group];
+}
+
+const MyString& SecondaryIndex::get_name(long id) const {
+    static const MyString empty_string;
+    return id >= 0 && (unsigned long)id < names.get_size() ? names[id] : empty_string;
+}
+
+MyString SecondaryIndex::normalize(const MyStringView& text) {
+    MyString result;
+    result.reserve(text.length());
+    bool pending_space = false;
+    for (unsigned long i = 0; i < text.length(); i++) {
+        char c = text[i];
+        if (c == '{' || c == '}') continue;
+
+        bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                    (unsigned char)c >= 0x80;
+        if (!word) {
+            pending_space = !result.empty();
+            continue;
+        }
+        if (pending_space) {
+            result.append(" ", 1);
+            pending_space = false;
+        }
+        char folded = MyString::tolower(c);
+        result.append(&folded, 1);
+    }
+    return result;
+}
@@ -0,0 +1,60 @@
+// secondaryindex.h - Entry positions grouped by year, entry type or venue
+#ifndef SECONDARYINDEX_H
+#define SECONDARYINDEX_H
+
+#include "bibdatabase.h"
+
+// Positions of the entries of a BibDatabase grouped by one numeric key, so
+// queries like "papers from 2020 to 2024" read a run of positions instead
+// of scanning every entry. String keys (entry types, venues) are first
+// given dense ids by key_id(). Postings are collected with add() and
+// grouped by finish(); groups are ordered by key with positions ascending
+// inside each, so any key range is one contiguous run.
+class SecondaryIndex {
+private:
+    struct Posting {
+        long key;
+        unsigned long position;
+
+        bool operator<(const Posting& other) const { return key < other.key; }
+    };
+
+    MyVector<Posting> pending;              // Collected postings, before finish()
+    MyVector<unsigned long> positions;      // Grouped by key
+    MyVector<long> group_keys;              // Ascending
+    MyVector<unsigned long> group_starts;   // group_keys.get_size() + 1 offsets into positions
+    MyVector<MyString> names;               // String key id -> normalized text
+    HashIndex name_lookup;                  // Hash of a name -> its id
+    bool built;
+
+    // First group whose key is >= key
+    unsigned long lower_group(long key) const;
+
+public:
+    SecondaryIndex();
+
+    // Building
+    void add(long key, unsigned long position);     // Positions in ascending order
+    long key_id(const MyStringView& name);          // name must be normalized
+    void finish();
+    bool is_built() const;
+    void clear();
+
+    // Queries return how many positions match and point found at the first
+    unsigned long find(long key, const unsigned long*& found) const;
+    unsigned long find_range(long first_key, long last_key, const unsigned long*& found) const;
+    long find_key_id(const MyStringView& name) const;   // -1 if no entry has it
+
+    // Groups in key order, for reports such as entries per year
+    unsigned long get_group_count() const;
+    long get_group_key(unsigned long group) const;
+    unsigned long get_group_size(unsigned long group) const;
+    const MyString& get_name(long id) const;
+
+    // Lowercase, without braces, with every run of spaces and punctuation
+    // turned into one space: "{USENIX} Annual Technical Conference (ATC)"
+    // becomes "usenix annual technical conference atc"
+    static MyString normalize(const MyStringView& text);
+};
+
+#endif // SECONDARYINDEX_H
@@ -0,0 +1,173 @@
+// stringarena.cpp - Implementation of the string bump allocator
+#include "stringarena.h"
+#include "mystring.h"    // malloc, free
+#include "mappedfile.h"
+
+// Arena installed by the innermost StringArenaScope of each thread
+static __thread StringArena* current_arena = nullptr;
+
+// Constructors
+StringArena::StringArena()
+    : head(nullptr), mappings(nullptr), block_count(0), bytes_used(0), bytes_reserved(0) {}
+
+StringArena::StringArena(StringArena&& other)
+    : head(other.head), mappings(other.mappings), block_count(other.block_count),
+      bytes_used(other.bytes_used), bytes_reserved(other.bytes_reserved) {
+    other.head = nullptr;
+    other.mappings = nullptr;
+    other.block_count = 0;
+    other.bytes_used = 0;
+    other.bytes_reserved = 0;
+}
+
+// Destructor
+StringArena::~StringArena() {
+    release();
+}
+
+// Assignment operator
+StringArena& StringArena::operator=(StringArena&& other) {
+    if (this != &other) {
+        release();
+        head = other.head;
+        mappings = other.mappings;
+        block_count = other.block_count;
+        bytes_used = other.bytes_used;
+        bytes_reserved = other.bytes_reserved;
+        other.head = nullptr;
+        other.mappings = nullptr;
+        other.block_count = 0;
+        other.bytes_used = 0;
+        other.bytes_reserved = 0;
+    }
+    return *this;
+}
+
+StringArena::Block* StringArena::new_block(unsigned long size) {
+    Block* block = (Block*)malloc(sizeof(Block) + size);
+    if (!block) return nullptr;
+
+    block->next = nullptr;
+    block->size = size;
+    block->used = 0;
+    block_count++;
+    bytes_reserved += size;
+    return block;
+}
+
+char* StringArena::allocate(unsigned long size) {
+    if (head && head->size - head->used >= size) {
+        char* result = (char*)(head + 1) + head->used;
+        head->used += size;
+        bytes_used += size;
+        return result;
+    }
+
+    if (size > LARGE_REQUEST) {
+        // Exact-size block linked behind the head, which keeps filling
+        Block* block = new_block(size);
+        if (!block) return nullptr;
+        block->used = size;
+        bytes_used += size;
+        if (head) {
+            block->next = head->next;
+            head->next = block;
+        } else {
+            head = block;
+        }
+        return (char*)(block + 1);
+    }
+
+    Block* block = new_block(BLOCK_SIZE);
+    if (!block) return nullptr;
+    block->next = head;
+    head = block;
+
+    block->used = size;
+    bytes_used += size;
+    return (char*)(block + 1);
+}
+
+void StringArena::adopt(StringArena& other) {
+    if (this == &other) return;
+
+    while (other.mappings) {
+        Mapping* mapping = other.mappings;
+        other.mappings = mapping->next;
+        mapping->next = mappings;
+        mappings = mapping;
+    }
+    if (!other.head) return;
+
+    if (!head) {
+        head = other.head;
+    } else {
+        // Splice other's chain in behind our head
+        Block* tail = other.head;
+        while (tail->next) tail = tail->next;
+        tail->next = head->next;
+        head->next = other.head;
+    }
+    block_count += other.block_count;
+    bytes_used += other.bytes_used;
+    bytes_reserved += other.bytes_reserved;
+
+    other.head = nullptr;
+    other.block_count = 0;
+    other.bytes_used = 0;
+    other.bytes_reserved = 0;
+}
+
+bool StringArena::adopt_mapping(MappedFile& file) {
+    Mapping* mapping = (Mapping*)malloc(sizeof(Mapping));
+    if (!mapping) return false;
+
+    mapping->length = file.size();
+    mapping->address = file.detach();
+    mapping->next = mappings;
+    mappings = mapping;
+    return true;
+}
+
+void StringArena::release() {
+    while (head) {
+        Block* next = head->next;
+        free(head);
+        head = next;
+    }
+    while (mappings) {
+        Mapping* next = mappings->next;
+        MappedFile::unmap(mappings->address, mappings->length);
+        free(mappings);
+        mappings = next;
+    }
+    block_count = 0;
+    bytes_used = 0;
+    bytes_reserved = 0;
+}
+
+// Statistics
+unsigned long StringArena::get_block_count() const {
+    return block_count;
+}
+
+unsigned long StringArena::get_bytes_used() const {
+    return bytes_used;
+}
+
+unsigned long StringArena::get_bytes_reserved() const {
+    return bytes_reserved;
+}
+
+StringArena* StringArena::current() {
+    return current_arena;
+}
+
+// StringArenaScope
+StringArenaScope::StringArenaScope(StringArena* arena) : previous(current_arena) {
+    current_arena = arena;
+}
+
+StringArenaScope::~StringArenaScope() {
+    current_arena = previous;
+}
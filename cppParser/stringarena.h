@@ -0,0 +1,91 @@
+// stringarena.h - Bump allocator for string buffers
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+// Hands out string buffers from a chain of large blocks. Individual
+// buffers are never freed; release() returns every block at once, so
+// tearing down millions of strings costs one free() per block.
+// An arena can also own file mappings whose bytes strings point into
+// (see MyString::wrap_arena); release() unmaps them.
+//
+// MyString allocates from the arena installed on the current thread by
+// a StringArenaScope. Buffers stay owned by the arena even when their
+// MyString is moved, so they must not outlive it.
+class MappedFile;
+
+class StringArena {
+private:
+    struct Block {
+        Block* next;
+        unsigned long size;     // Usable bytes after the header
+        unsigned long used;
+    };
+
+    static const unsigned long BLOCK_SIZE = 1024 * 1024;
+    static const unsigned long LARGE_REQUEST = BLOCK_SIZE / 4;  // Gets a block of its own
+
+    struct Mapping {
+        Mapping* next;
+        const char* address;
+        unsigned long length;
+    };
+
+    Block* head;                // Block currently being filled
+    Mapping* mappings;
+    unsigned long block_count;
+    unsigned long bytes_used;
+    unsigned long bytes_reserved;
+
+    Block* new_block(unsigned long size);
+
+    // Disable copying - the blocks have a single owner
+    StringArena(const StringArena& other);
+    StringArena& operator=(const StringArena& other);
+
+public:
+    // Constructors
+    StringArena();
+    StringArena(StringArena&& other);
+
+    // Destructor
+    ~StringArena();
+
+    // Assignment operator
+    StringArena& operator=(StringArena&& other);
+
+    // Returns size bytes (no alignment), or null when out of memory
+    char* allocate(unsigned long size);
+
+    // Takes over all of other's blocks and mappings; other ends up empty
+    void adopt(StringArena& other);
+
+    // Takes over an open mapping; false (file left open) when out of memory
+    bool adopt_mapping(MappedFile& file);
+
+    // Frees every block and mapping; all buffers handed out become invalid
+    void release();
+
+    // Statistics
+    unsigned long get_block_count() const;
+    unsigned long get_bytes_used() const;
+    unsigned long get_bytes_reserved() const;
+
+    // Arena used by MyString on the calling thread (null: malloc)
+    static StringArena* current();
+};
+
+// Installs an arena (or null for plain malloc) on the calling thread for
+// the lifetime of the scope, restoring the previous one afterwards
+class StringArenaScope {
+private:
+    StringArena* previous;
+
+    StringArenaScope(const StringArenaScope& other);
+    StringArenaScope& operator=(const StringArenaScope& other);
+
+public:
+    explicit StringArenaScope(StringArena* arena);
+    ~StringArenaScope();
+};
+
+#endif // STRINGARENA_H
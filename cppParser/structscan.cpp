@@ -0,0 +1,175 @@
+// structscan.cpp - Scalar, SSE2 and AVX2 structural character classifiers
+#include "structscan.h"
+
+// Structural byte lookup for the scalar path and block tails:
+// @ { } ( ) = , " \n \r
+static const unsigned char structural_table[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 1, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0,
+    1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static void scalar_tail(const char* data, unsigned long start, unsigned long length, unsigned long* bits) {
+    // start is always a multiple of 64
+    for (unsigned long i = start; i < length; i += 64) {
+        unsigned long end = length - i < 64 ? length - i : 64;
+        unsigned long word = 0;
+        for (unsigned long k = 0; k < end; k++) {
+            word |= (unsigned long)structural_table[(unsigned char)data[i + k]] << k;
+        }
+        bits[i >> 6] = word;
+    }
+}
+
+static void bitmap_scalar(const char* data, unsigned long length, unsigned long* bits) {
+    scalar_tail(data, 0, length, bits);
+}
+
+#if defined(__x86_64__)
+// GCC vector extensions; no intrinsics headers needed
+typedef char ScanVec16 __attribute__((vector_size(16)));
+typedef char ScanVec32 __attribute__((vector_size(32)));
+
+static void bitmap_sse2(const char* data, unsigned long length, unsigned long* bits) {
+    unsigned long full = length & ~63UL;
+    for (unsigned long i = 0; i < full; i += 64) {
+        unsigned long word = 0;
+        for (int part = 0; part < 4; part++) {
+            ScanVec16 v;
+            __builtin_memcpy(&v, data + i + part * 16, 16);
+            ScanVec16 hit = (v == '@') | (v == '{') | (v == '}') | (v == '(') | (v == ')') |
+                            (v == '=') | (v == ',') | (v == '"') | (v == '\n') | (v == '\r');
+            unsigned long mask = (unsigned int)__builtin_ia32_pmovmskb128(hit);
+            word |= mask << (part * 16);
+        }
+        bits[i >> 6] = word;
+    }
+    scalar_tail(data, full, length, bits);
+}
+
+__attribute__((target("avx2")))
+static void bitmap_avx2(const char* data, unsigned long length, unsigned long* bits) {
+    unsigned long full = length & ~63UL;
+    for (unsigned long i = 0; i < full; i += 64) {
+        ScanVec32 lo, hi;
+        __builtin_memcpy(&lo, data + i, 32);
+        __builtin_memcpy(&hi, data + i + 32, 32);
+        ScanVec32 hit_lo = (lo == '@') | (lo == '{') | (lo == '}') | (lo == '(') | (lo == ')') |
+                           (lo == '=') | (lo == ',') | (lo == '"') | (lo == '\n') | (lo == '\r');
+        ScanVec32 hit_hi = (hi == '@') | (hi == '{') | (hi == '}') | (hi == '(') | (hi == ')') |
+                           (hi == '=') | (hi == ',') | (hi == '"') | (hi == '\n') | (hi == '\r');
+        unsigned long mask_lo = (unsigned int)__builtin_ia32_pmovmskb256(hit_lo);
+        unsigned long mask_hi = (unsigned int)__builtin_ia32_pmovmskb256(hit_hi);
+        bits[i >> 6] = mask_lo | (mask_hi << 32);
+    }
+    scalar_tail(data, full, length, bits);
+}
+#endif
+
+// Runtime dispatch
+typedef void (*BitmapFunction)(const char* data, unsigned long length, unsigned long* bits);
+
+static BitmapFunction bitmap_function = nullptr;
+static StructuralScanLevel current_level = SCAN_SCALAR;
+
+StructuralScanLevel best_structural_scan_level() {
+#if defined(__x86_64__)
+    // CPUID (and the OS's YMM state support) via libgcc
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SCAN_AVX2;
+    return SCAN_SSE2;
+#else
+    return SCAN_SCALAR;
+#endif
+}
+
+StructuralScanLevel set_structural_scan_level(StructuralScanLevel level) {
+    StructuralScanLevel best = best_structural_scan_level();
+    if (level > best) level = best;
+
+    BitmapFunction function = bitmap_scalar;
+#if defined(__x86_64__)
+    if (level == SCAN_AVX2) function = bitmap_avx2;
+    else if (level == SCAN_SSE2) function = bitmap_sse2;
+#endif
+
+    // Racing first uses store the same values, so relaxed atomics suffice
+    __atomic_store_n(&current_level, level, __ATOMIC_RELAXED);
+    __atomic_store_n(&bitmap_function, function, __ATOMIC_RELAXED);
+    return level;
+}
+
+StructuralScanLevel get_structural_scan_level() {
+    if (!__atomic_load_n(&bitmap_function, __ATOMIC_RELAXED)) {
+        set_structural_scan_level(SCAN_AVX2);
+    }
+    return __atomic_load_n(&current_level, __ATOMIC_RELAXED);
+}
+
+const char* structural_scan_level_name(StructuralScanLevel level) {
+    switch (level) {
+    case SCAN_AVX2: return "avx2";
+    case SCAN_SSE2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+void structural_bitmap(const char* data, unsigned long length, unsigned long* bits) {
+    BitmapFunction function = __atomic_load_n(&bitmap_function, __ATOMIC_RELAXED);
+    if (!function) {
+        get_structural_scan_level();
+        function = __atomic_load_n(&bitmap_function, __ATOMIC_RELAXED);
+    }
+    function(data, length, bits);
+}
+
+// StructuralIndex
+StructuralIndex::StructuralIndex() : block(nullptr), block_length(0), window_start(0), window_end(0) {}
+
+void StructuralIndex::reset(const char* data, unsigned long length) {
+    block = data;
+    block_length = length;
+    window_start = 0;
+    window_end = 0;
+}
+
+void StructuralIndex::build_window(unsigned long from) {
+    window_start = from & ~63UL;    // Keep words aligned to block offsets
+    window_end = window_start + WINDOW_SIZE;
+    if (window_end > block_length) window_end = block_length;
+    structural_bitmap(block + window_start, window_end - window_start, bits);
+}
+
+unsigned long StructuralIndex::next(unsigned long from) {
+    while (from < block_length) {
+        if (from < window_start || from >= window_end) build_window(from);
+
+        unsigned long word_index = (from - window_start) >> 6;
+        unsigned long word = bits[word_index] & (~0UL << ((from - window_start) & 63));
+        unsigned long words = (window_end - window_start + 63) >> 6;
+
+        while (true) {
+            if (word) {
+                unsigned long position = window_start + (word_index << 6) + __builtin_ctzl(word);
+                return position < block_length ? position : block_length;
+            }
+            if (++word_index >= words) break;
+            word = bits[word_index];
+        }
+        from = window_end;
+    }
+    return block_length;
+}
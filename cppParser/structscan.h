@@ -0,0 +1,54 @@
+// structscan.h - SIMD structural character index for the tokenizer
+#ifndef STRUCTSCAN_H
+#define STRUCTSCAN_H
+
+// The bytes the tokenizer stops at: @ { } ( ) = , " \n \r
+// Everything else inside a value is copied in bulk.
+
+// Instruction set used to classify bytes
+enum StructuralScanLevel {
+    SCAN_SCALAR,    // Portable byte loop
+    SCAN_SSE2,      // 16 bytes per compare (baseline on x86-64)
+    SCAN_AVX2       // 32 bytes per compare
+};
+
+// Sets bit (i % 64) of bits[i / 64] for every structural byte data[i];
+// bits must hold (length + 63) / 64 words. Uses the level chosen by
+// CPUID on first use unless one was forced with set_structural_scan_level.
+void structural_bitmap(const char* data, unsigned long length, unsigned long* bits);
+
+StructuralScanLevel get_structural_scan_level();
+// Forces a level (capped at what the CPU supports); returns the level in use
+StructuralScanLevel set_structural_scan_level(StructuralScanLevel level);
+StructuralScanLevel best_structural_scan_level();
+const char* structural_scan_level_name(StructuralScanLevel level);
+
+// Walks one input block in fixed windows, building each window's bitmap
+// just before it is needed, so every byte is classified once while the
+// tokenizer only visits structural positions.
+class StructuralIndex {
+private:
+    static const unsigned long WINDOW_SIZE = 16 * 1024;    // Bytes per bitmap
+    static const unsigned long WINDOW_WORDS = WINDOW_SIZE / 64;
+
+    const char* block;
+    unsigned long block_length;
+    unsigned long window_start;     // Offset of bits[0] in the block
+    unsigned long window_end;
+    unsigned long bits[WINDOW_WORDS];
+
+    void build_window(unsigned long from);
+
+public:
+    // Constructor
+    StructuralIndex();
+
+    // Starts over on a new block
+    void reset(const char* data, unsigned long length);
+
+    // Offset of the first structural byte at or after from, or the block
+    // length if there is none
+    unsigned long next(unsigned long from);
+};
+
+#endif // STRUCTSCAN_H
@@ -0,0 +1,970 @@
+// textindex.cpp - Inverted full-text index over entry titles and abstracts
+#include "textindex.h"
+
+// C runtime functions
+extern "C" {
+    double log(double x);
+}
+
+const double TextIndex::BM25_K1 = 1.2;
+const double TextIndex::BM25_B = 0.75;
+
+static const unsigned int TEXT_INDEX_VERSION = 1;
+static const unsigned long BUILD_CHUNK_ENTRIES = 4096;  // Entries per parallel build task
+static const unsigned long SKIP_TASK_TERMS = 4096;      // Terms per parallel skip task
+
+// Tokenizer
+static bool is_term_byte(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           (unsigned char)c >= 0x80;
+}
+
+TextTokenizer::TextTokenizer(const MyStringView& input)
+    : text(input.data()), length(input.length()), cursor(0) {}
+
+unsigned int TextTokenizer::next(char* term) {
+    while (cursor < length && !is_term_byte(text[cursor])) cursor++;
+
+    unsigned int term_length = 0;
+    while (cursor < length && is_term_byte(text[cursor])) {
+        if (term_length < MAX_TERM_LENGTH) term[term_length++] = MyString::tolower(text[cursor]);
+        cursor++;
+    }
+    return term_length;
+}
+
+// Varints: seven bits per byte, low bits first, high bit set on all but the last
+static unsigned int varint_size(unsigned long value) {
+    unsigned int size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static unsigned char* write_varint(unsigned char* out, unsigned long value) {
+    while (value >= 0x80) {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+static void append_varint(MyVector<unsigned char>& out, unsigned long value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+static bool read_varint(const unsigned char*& in, const unsigned char* end, unsigned long& value) {
+    value = 0;
+    for (unsigned int shift = 0; shift < 64 && in < end; shift += 7) {
+        unsigned char byte = *in++;
+        value |= (unsigned long)(byte & 0x7f) << shift;
+        if (byte < 0x80) return true;
+    }
+    return false;
+}
+
+// Walks one posting list. Every value read from the list is checked, so a
+// damaged index file gives wrong answers at worst, never a bad access.
+struct TextIndex::PostingCursor {
+    const unsigned char* start;
+    const unsigned char* next_byte;
+    const unsigned char* end;
+    const SkipRecord* skips;
+    unsigned long skip_count;
+    unsigned long entry_limit;      // Entries in the index
+    unsigned long list_size;        // Entries in this list
+    unsigned long consumed;         // Entries read so far
+    unsigned long base;             // Entry the next delta is relative to
+    unsigned long entry;            // Current entry, once consumed > 0
+    unsigned int frequency;
+    unsigned int unread_positions;
+    bool done;
+
+    unsigned int query_offset;      // Position of the term in the query
+    double weight;                  // BM25 idf
+    double bound;                   // Largest possible BM25 contribution
+
+    void open(const TermRecord& term, const unsigned char* postings, const SkipRecord* all_skips,
+              unsigned long entry_count) {
+        start = postings + term.postings_offset;
+        next_byte = start;
+        end = start + term.postings_length;
+        list_size = term.entry_count;
+        skips = all_skips + term.first_skip;
+        skip_count = list_size > SKIP_INTERVAL ? (list_size - 1) / SKIP_INTERVAL : 0;
+        entry_limit = entry_count;
+        consumed = 0;
+        base = 0;
+        entry = 0;
+        frequency = 0;
+        unread_positions = 0;
+        done = false;
+        query_offset = 0;
+        weight = 0;
+        bound = 0;
+    }
+
+    bool stop() {
+        done = true;
+        return false;
+    }
+
+    // Moves to the next entry of the list; false at the end
+    bool next() {
+        if (done) return false;
+        unsigned long value;
+        while (unread_positions > 0) {
+            if (!read_varint(next_byte, end, value)) return stop();
+            unread_positions--;
+        }
+        if (consumed >= list_size || !read_varint(next_byte, end, value)) return stop();
+        if ((consumed > 0 && value == 0) || value >= entry_limit - base) return stop();
+        entry = base + value;
+        base = entry;
+        if (!read_varint(next_byte, end, value) || value == 0 ||
+            value > (unsigned long)(end - next_byte)) {
+            return stop();
+        }
+        frequency = (unsigned int)value;
+        unread_positions = frequency;
+        consumed++;
+        return true;
+    }
+
+    // Moves to the first entry >= target, jumping over whole blocks through
+    // the skip records; false if there is none
+    bool advance_to(unsigned long target) {
+        if (done) return false;
+        if (consumed > 0 && entry >= target) return true;
+
+        // Skip j starts block j + 1; find the last block starting before target
+        unsigned long first = consumed / SKIP_INTERVAL, low = first, high = skip_count;
+        while (low < high) {
+            unsigned long middle = low + (high - low) / 2;
+            if (skips[middle].previous_entry < target) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low > first) {
+            const SkipRecord& skip = skips[low - 1];
+            if (skip.offset <= (unsigned long)(end - start) && skip.previous_entry < entry_limit &&
+                (consumed == 0 || skip.previous_entry >= entry)) {
+                next_byte = start + skip.offset;
+                base = skip.previous_entry;
+                consumed = low * SKIP_INTERVAL;
+                unread_positions = 0;
+            }
+        }
+
+        while (next()) {
+            if (entry >= target) return true;
+        }
+        return false;
+    }
+
+    // Positions of the current entry, ascending; call at most once per entry
+    unsigned int read_positions(unsigned int* positions) {
+        unsigned long position = 0, delta;
+        unsigned int count = 0;
+        while (unread_positions > 0) {
+            if (!read_varint(next_byte, end, delta)) {
+                done = true;
+                break;
+            }
+            position += delta;
+            positions[count++] = (unsigned int)position;
+            unread_positions--;
+        }
+        return count;
+    }
+};
+
+// Building. Each chunk of entries is indexed on its own with a private
+// dictionary; the chunks' lists are then concatenated in entry order.
+struct ChunkTerm {
+    unsigned long text_offset;      // In BuildChunk::text
+    unsigned int text_length;
+    unsigned int entry_count;
+    unsigned long first_entry;
+    unsigned long last_entry;
+    unsigned long counted_entry;    // Entry that frequency belongs to
+    unsigned int frequency;
+    unsigned int last_position;
+    MyVector<unsigned char> postings;   // The list after the first entry delta
+};
+
+struct TextIndex::BuildChunk {
+    const BibDatabase& database;
+    unsigned long first_entry;
+    unsigned long end_entry;
+    unsigned int* entry_lengths;        // Shared by all chunks, indexed by entry
+    MyString text;                      // Term text, back to back
+    MyVector<ChunkTerm> terms;
+    HashIndex lookup;                   // Hash of a term -> its index in terms
+    unsigned int* tokens;               // Term of each token of the current entry
+    unsigned long token_capacity;
+    unsigned long token_count;
+    unsigned int* global_ids;           // Term -> merged term, filled by build()
+
+    BuildChunk(const BibDatabase& source, unsigned long first, unsigned long end, unsigned int* lengths)
+        : database(source), first_entry(first), end_entry(end), entry_lengths(lengths), tokens(nullptr),
+          token_capacity(0), token_count(0), global_ids(nullptr) {}
+
+    ~BuildChunk() {
+        if (tokens) free(tokens);
+        if (global_ids) free(global_ids);
+    }
+
+    const char* term_text(const ChunkTerm& term) const {
+        return text.c_str() + term.text_offset;
+    }
+
+    // NO_TERM when a new term cannot be stored; add_token drops it
+    static const unsigned int NO_TERM = 0xffffffffu;
+
+    unsigned int term_id(const char* term, unsigned int length) {
+        unsigned long hash = MyString::hash_bytes(term, length);
+        unsigned long cursor = lookup.probe_start(hash), id;
+        while (lookup.next_candidate(hash, cursor, id)) {
+            const ChunkTerm& candidate = terms[id];
+            if (candidate.text_length == length && memcmp(term_text(candidate), term, length) == 0) {
+                return (unsigned int)id;
+            }
+        }
+
+        id = terms.get_size();
+        ChunkTerm* created = terms.emplace_back();
+        if (!created) return NO_TERM;
+        ChunkTerm& added = *created;
+        added.text_offset = text.length();
+        added.text_length = length;
+        added.entry_count = 0;
+        added.first_entry = 0;
+        added.last_entry = 0;
+        added.counted_entry = (unsigned long)-1;
+        added.frequency = 0;
+        added.last_position = 0;
+        text.append(term, length);
+        lookup.insert(hash, id);
+        return (unsigned int)id;
+    }
+
+    void add_token(unsigned int id, unsigned long entry) {
+        if (id == NO_TERM) return;
+        if (token_count == token_capacity) {
+            unsigned long capacity = token_capacity == 0 ? 256 : token_capacity * 2;
+            unsigned int* grown = (unsigned int*)malloc(sizeof(unsigned int) * capacity);
+            if (!grown) return;
+            if (tokens) {
+                memcpy(grown, tokens, sizeof(unsigned int) * token_count);
+                free(tokens);
+            }
+            tokens = grown;
+            token_capacity = capacity;
+        }
+        tokens[token_count++] = id;
+
+        ChunkTerm& term = terms[id];
+        if (term.counted_entry != entry) {
+            term.counted_entry = entry;
+            term.frequency = 0;
+        }
+        term.frequency++;
+    }
+
+    // Frequencies are counted first so each term's record can be written
+    // in one pass: entry delta and frequency at its first occurrence, then
+    // one position delta per occurrence
+    void add_entry(unsigned long entry) {
+        const BibEntry& source = database.get_entry(entry);
+        char term[TextTokenizer::MAX_TERM_LENGTH];
+        unsigned int length;
+
+        token_count = 0;
+        TextTokenizer title(source.get_title());
+        while ((length = title.next(term)) > 0) add_token(term_id(term, length), entry);
+        unsigned long title_terms = token_count;
+        TextTokenizer abstract(source.get_abstract());
+        while ((length = abstract.next(term)) > 0) add_token(term_id(term, length), entry);
+        entry_lengths[entry] = (unsigned int)token_count;
+
+        for (unsigned long i = 0; i < token_count; i++) {
+            ChunkTerm& indexed = terms[tokens[i]];
+            unsigned int position = (unsigned int)(i < title_terms ? i : i + 1);
+            if (indexed.entry_count == 0 || indexed.last_entry != entry) {
+                if (indexed.entry_count == 0) {
+                    indexed.first_entry = entry;
+                } else {
+                    append_varint(indexed.postings, entry - indexed.last_entry);
+                }
+                append_varint(indexed.postings, indexed.frequency);
+                indexed.last_entry = entry;
+                indexed.entry_count++;
+                indexed.last_position = 0;
+            }
+            append_varint(indexed.postings, position - indexed.last_position);
+            indexed.last_position = position;
+        }
+    }
+};
+
+void TextIndex::build_chunk_task(void* context, unsigned long index) {
+    BuildChunk& chunk = ((BuildChunk*)context)[index];
+    for (unsigned long entry = chunk.first_entry; entry < chunk.end_entry; entry++) {
+        chunk.add_entry(entry);
+    }
+}
+
+// A term of the finished index while the chunks are merged
+struct MergedTerm {
+    unsigned long chunk;            // First chunk with the term, which holds its text
+    unsigned int local_id;
+    unsigned int entry_count;
+    unsigned long postings_length;
+    unsigned long last_entry;
+    unsigned long written;          // Bytes of the list copied so far
+};
+
+// Skip records come from decoding each finished list once
+struct SkipTask {
+    const TextIndex::TermRecord* terms;
+    unsigned long term_count;
+    const unsigned char* postings;
+    TextIndex::SkipRecord* skips;
+};
+
+static void fill_skips_task(void* context, unsigned long index) {
+    const SkipTask& task = *(const SkipTask*)context;
+    unsigned long end = (index + 1) * SKIP_TASK_TERMS;
+    if (end > task.term_count) end = task.term_count;
+
+    for (unsigned long t = index * SKIP_TASK_TERMS; t < end; t++) {
+        const TextIndex::TermRecord& term = task.terms[t];
+        if (term.entry_count <= TextIndex::SKIP_INTERVAL) continue;
+
+        const unsigned char* start = task.postings + term.postings_offset;
+        const unsigned char* in = start;
+        const unsigned char* list_end = start + term.postings_length;
+        unsigned long entry = 0, value;
+        for (unsigned long i = 0; i < term.entry_count; i++) {
+            if (i > 0 && i % TextIndex::SKIP_INTERVAL == 0) {
+                TextIndex::SkipRecord& skip = task.skips[term.first_skip + i / TextIndex::SKIP_INTERVAL - 1];
+                skip.offset = (unsigned long)(in - start);
+                skip.previous_entry = entry;
+            }
+            read_varint(in, list_end, value);
+            entry += value;
+            read_varint(in, list_end, value);
+            for (unsigned long occurrences = value; occurrences > 0; occurrences--) {
+                read_varint(in, list_end, value);
+            }
+        }
+    }
+}
+
+static unsigned long align8(unsigned long offset) {
+    return (offset + 7) & ~7UL;
+}
+
+static unsigned long table_slot(const char* term, unsigned long length, unsigned long table_size) {
+    return MyString::hash_bytes(term, length) & (table_size - 1);
+}
+
+// Constructor and destructor
+TextIndex::TextIndex()
+    : block(nullptr), mapping(nullptr), mapping_size(0), header(nullptr), terms(nullptr), table(nullptr),
+      skips(nullptr), entry_lengths(nullptr), text(nullptr), postings(nullptr) {}
+
+TextIndex::~TextIndex() {
+    clear();
+}
+
+void TextIndex::clear() {
+    if (block) free(block);
+    if (mapping) MappedFile::unmap(mapping, mapping_size);
+    block = nullptr;
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    terms = nullptr;
+    table = nullptr;
+    skips = nullptr;
+    entry_lengths = nullptr;
+    text = nullptr;
+    postings = nullptr;
+}
+
+void TextIndex::attach(const char* data) {
+    header = (const Header*)data;
+    terms = (const TermRecord*)(data + header->terms_offset);
+    table = (const unsigned int*)(data + header->table_offset);
+    skips = (const SkipRecord*)(data + header->skips_offset);
+    entry_lengths = (const unsigned int*)(data + header->lengths_offset);
+    text = data + header->text_offset;
+    postings = (const unsigned char*)(data + header->postings_offset);
+}
+
+bool TextIndex::build(const BibDatabase& database, int thread_count) {
+    clear();
+
+    unsigned long entry_count = database.size();
+    unsigned long chunk_count = (entry_count + BUILD_CHUNK_ENTRIES - 1) / BUILD_CHUNK_ENTRIES;
+    unsigned int* lengths = (unsigned int*)malloc(sizeof(unsigned int) * (entry_count > 0 ? entry_count : 1));
+    BuildChunk* chunks = (BuildChunk*)malloc(sizeof(BuildChunk) * (chunk_count > 0 ? chunk_count : 1));
+    if (!lengths || !chunks) {
+        if (lengths) free(lengths);
+        if (chunks) free(chunks);
+        return false;
+    }
+    for (unsigned long c = 0; c < chunk_count; c++) {
+        unsigned long first = c * BUILD_CHUNK_ENTRIES;
+        unsigned long end = first + BUILD_CHUNK_ENTRIES < entry_count ? first + BUILD_CHUNK_ENTRIES : entry_count;
+        new (&chunks[c]) BuildChunk(database, first, end, lengths);
+    }
+    parallel_for(thread_count, chunk_count, build_chunk_task, chunks);
+
+    // Merge the dictionaries, numbering terms in order of first appearance.
+    // A chunk's first entry delta depends on where the previous chunk with
+    // the term ended, so list sizes are only known after this pass.
+    MyVector<MergedTerm> merged;
+    HashIndex merged_lookup;
+    unsigned long text_size = 0, skip_count = 0, postings_size = 0, total_length = 0;
+    bool complete = true;
+    for (unsigned long c = 0; c < chunk_count && complete; c++) {
+        BuildChunk& chunk = chunks[c];
+        unsigned long local_count = chunk.terms.get_size();
+        chunk.global_ids = (unsigned int*)malloc(sizeof(unsigned int) * (local_count > 0 ? local_count : 1));
+        if (!chunk.global_ids) {
+            complete = false;
+            break;
+        }
+        for (unsigned long t = 0; t < local_count; t++) {
+            const ChunkTerm& term = chunk.terms[t];
+            const char* term_text = chunk.term_text(term);
+            unsigned long hash = MyString::hash_bytes(term_text, term.text_length);
+            unsigned long cursor = merged_lookup.probe_start(hash), id;
+            bool found = false;
+            while (!found && merged_lookup.next_candidate(hash, cursor, id)) {
+                const MergedTerm& candidate = merged[id];
+                const ChunkTerm& owner = chunks[candidate.chunk].terms[candidate.local_id];
+                found = owner.text_length == term.text_length &&
+                        memcmp(chunks[candidate.chunk].term_text(owner), term_text, term.text_length) == 0;
+            }
+            if (!found) {
+                id = merged.get_size();
+                MergedTerm added = {c, (unsigned int)t, 0, 0, 0, 0};
+                merged.push_back(added);
+                merged_lookup.insert(hash, id);
+                text_size += term.text_length;
+            }
+
+            MergedTerm& target = merged[id];
+            unsigned long base = target.entry_count > 0 ? target.last_entry : 0;
+            target.postings_length += varint_size(term.first_entry - base) + term.postings.get_size();
+            target.last_entry = term.last_entry;
+            target.entry_count += term.entry_count;
+            chunk.global_ids[t] = (unsigned int)id;
+        }
+    }
+
+    unsigned long term_count = merged.get_size();
+    unsigned long table_size = 16;
+    while (table_size < term_count * 2) table_size *= 2;
+    for (unsigned long t = 0; t < term_count; t++) {
+        if (merged[t].entry_count > SKIP_INTERVAL) skip_count += (merged[t].entry_count - 1) / SKIP_INTERVAL;
+        postings_size += merged[t].postings_length;
+    }
+
+    Header layout = Header();
+    memcpy(layout.magic, "BIBTEXT", 8);
+    layout.version = TEXT_INDEX_VERSION;
+    layout.header_size = sizeof(Header);
+    layout.byte_order = SNAPSHOT_BYTE_ORDER;
+    layout.entry_count = entry_count;
+    layout.term_count = term_count;
+    layout.table_size = table_size;
+    layout.skip_count = skip_count;
+    layout.terms_offset = sizeof(Header);
+    layout.table_offset = layout.terms_offset + term_count * sizeof(TermRecord);
+    layout.skips_offset = align8(layout.table_offset + table_size * sizeof(unsigned int));
+    layout.lengths_offset = layout.skips_offset + skip_count * sizeof(SkipRecord);
+    layout.text_offset = align8(layout.lengths_offset + entry_count * sizeof(unsigned int));
+    layout.text_size = text_size;
+    layout.postings_offset = align8(layout.text_offset + text_size);
+    layout.postings_size = postings_size;
+    layout.file_size = layout.postings_offset + postings_size;
+
+    char* data = complete ? (char*)malloc(layout.file_size) : nullptr;
+    if (data) {
+        // Everything but the postings is zeroed so saved padding is deterministic
+        memset(data, 0, layout.postings_offset);
+        TermRecord* records = (TermRecord*)(data + layout.terms_offset);
+        unsigned int* slots = (unsigned int*)(data + layout.table_offset);
+        char* term_text = data + layout.text_offset;
+        unsigned char* lists = (unsigned char*)(data + layout.postings_offset);
+
+        unsigned long next_text = 0, next_postings = 0, next_skip = 0;
+        for (unsigned long t = 0; t < term_count; t++) {
+            const MergedTerm& term = merged[t];
+            const ChunkTerm& owner = chunks[term.chunk].terms[term.local_id];
+            TermRecord& record = records[t];
+            record.text_offset = next_text;
+            record.text_length = owner.text_length;
+            record.postings_offset = next_postings;
+            record.postings_length = term.postings_length;
+            record.entry_count = term.entry_count;
+            record.first_skip = next_skip;
+            memcpy(term_text + next_text, chunks[term.chunk].term_text(owner), owner.text_length);
+
+            unsigned long slot = table_slot(term_text + next_text, owner.text_length, table_size);
+            while (slots[slot] != 0) slot = (slot + 1) & (table_size - 1);
+            slots[slot] = (unsigned int)(t + 1);
+
+            next_text += owner.text_length;
+            next_postings += term.postings_length;
+            if (term.entry_count > SKIP_INTERVAL) next_skip += (term.entry_count - 1) / SKIP_INTERVAL;
+        }
+
+        for (unsigned long e = 0; e < entry_count; e++) total_length += lengths[e];
+        layout.total_length = total_length;
+        memcpy(data + layout.lengths_offset, lengths, entry_count * sizeof(unsigned int));
+        memcpy(data, &layout, sizeof(Header));
+
+        // Append each chunk's lists, freeing chunks as they are used up
+        for (unsigned long c = 0; c < chunk_count; c++) {
+            const BuildChunk& chunk = chunks[c];
+            for (unsigned long t = 0; t < chunk.terms.get_size(); t++) {
+                const ChunkTerm& term = chunk.terms[t];
+                MergedTerm& target = merged[chunk.global_ids[t]];
+                unsigned char* out = lists + records[chunk.global_ids[t]].postings_offset + target.written;
+                unsigned char* list_start = out;
+                out = write_varint(out, term.first_entry - (target.written > 0 ? target.last_entry : 0));
+                if (term.postings.get_size() > 0) {
+                    memcpy(out, &term.postings[0], term.postings.get_size());
+                    out += term.postings.get_size();
+                }
+                target.written += (unsigned long)(out - list_start);
+                target.last_entry = term.last_entry;
+            }
+            chunks[c].~BuildChunk();
+        }
+        chunk_count = 0;
+
+        SkipTask task = {records, term_count, lists, (SkipRecord*)(data + layout.skips_offset)};
+        parallel_for(thread_count, (term_count + SKIP_TASK_TERMS - 1) / SKIP_TASK_TERMS, fill_skips_task, &task);
+
+        block = data;
+        attach(block);
+    }
+
+    for (unsigned long c = 0; c < chunk_count; c++) chunks[c].~BuildChunk();
+    free(chunks);
+    free(lengths);
+    return block != nullptr;
+}
+
+// Files
+bool TextIndex::save(const char* filename, const SourceStamp& source) const {
+    BufferedWriter writer;
+    if (!header || !filename || !writer.open(filename)) return false;
+
+    Header stamped = *header;
+    stamped.source = source;
+    writer.write((const char*)&stamped, sizeof(stamped));
+    writer.write((const char*)header + sizeof(Header), header->file_size - sizeof(Header));
+    return writer.close();
+}
+
+// True if count elements of element_size starting at offset fit in size bytes
+static bool index_section_fits(unsigned long offset, unsigned long count, unsigned long element_size,
+                               unsigned long size) {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / element_size;
+}
+
+// Checks the header, every term record and the hash table, but not the
+// postings themselves, which the cursors check as they read them
+bool TextIndex::load(const char* filename, const char* source_filename) {
+    MappedFile file;
+    if (!filename || !file.open(filename)) return false;
+
+    const char* data = file.get_data();
+    unsigned long size = file.size();
+    if (!data || size < sizeof(Header)) return false;
+
+    const Header& loaded = *(const Header*)data;
+    if (memcmp(loaded.magic, "BIBTEXT", 8) != 0 || loaded.version != TEXT_INDEX_VERSION ||
+        loaded.header_size != sizeof(Header) || loaded.byte_order != SNAPSHOT_BYTE_ORDER ||
+        loaded.file_size != size || loaded.table_size == 0 ||
+        (loaded.table_size & (loaded.table_size - 1)) != 0 || loaded.term_count >= loaded.table_size ||
+        !index_section_fits(loaded.terms_offset, loaded.term_count, sizeof(TermRecord), size) ||
+        !index_section_fits(loaded.table_offset, loaded.table_size, sizeof(unsigned int), size) ||
+        !index_section_fits(loaded.skips_offset, loaded.skip_count, sizeof(SkipRecord), size) ||
+        !index_section_fits(loaded.lengths_offset, loaded.entry_count, sizeof(unsigned int), size) ||
+        !index_section_fits(loaded.text_offset, loaded.text_size, 1, size) ||
+        !index_section_fits(loaded.postings_offset, loaded.postings_size, 1, size)) {
+        return false;
+    }
+    if (source_filename && !loaded.source.matches(source_filename)) return false;
+
+    const TermRecord* records = (const TermRecord*)(data + loaded.terms_offset);
+    for (unsigned long t = 0; t < loaded.term_count; t++) {
+        const TermRecord& record = records[t];
+        unsigned long skip_total = record.entry_count > SKIP_INTERVAL ? (record.entry_count - 1) / SKIP_INTERVAL : 0;
+        if (record.text_offset > loaded.text_size || record.text_length > loaded.text_size - record.text_offset ||
+            record.postings_offset > loaded.postings_size ||
+            record.postings_length > loaded.postings_size - record.postings_offset ||
+            record.first_skip > loaded.skip_count || skip_total > loaded.skip_count - record.first_skip) {
+            return false;
+        }
+    }
+    const unsigned int* slots = (const unsigned int*)(data + loaded.table_offset);
+    for (unsigned long s = 0; s < loaded.table_size; s++) {
+        if (slots[s] > loaded.term_count) return false;
+    }
+
+    clear();
+    mapping_size = size;
+    mapping = file.detach();
+    attach(mapping);
+    return true;
+}
+
+// Statistics
+bool TextIndex::empty() const {
+    return header == nullptr;
+}
+
+unsigned long TextIndex::get_entry_count() const {
+    return header ? header->entry_count : 0;
+}
+
+unsigned long TextIndex::get_term_count() const {
+    return header ? header->term_count : 0;
+}
+
+unsigned long TextIndex::get_size() const {
+    return header ? header->file_size : 0;
+}
+
+// Queries
+long TextIndex::find_term(const MyStringView& term) const {
+    unsigned long mask = header->table_size - 1;
+    unsigned long slot = table_slot(term.data(), term.length(), header->table_size);
+    for (unsigned long probes = 0; probes < header->table_size && table[slot] != 0; probes++) {
+        const TermRecord& record = terms[table[slot] - 1];
+        if (record.text_length == term.length() &&
+            memcmp(text + record.text_offset, term.data(), term.length()) == 0) {
+            return (long)table[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+unsigned int TextIndex::open_cursors(const MyStringView& query, PostingCursor* cursors, bool keep_repeats,
+                                     unsigned int& missing) const {
+    missing = 0;
+    if (!header) return 0;
+
+    TextTokenizer tokens(query);
+    char term[TextTokenizer::MAX_TERM_LENGTH];
+    long ids[MAX_QUERY_TERMS];
+    unsigned int count = 0, length, offset = 0;
+    for (; offset < MAX_QUERY_TERMS && (length = tokens.next(term)) > 0; offset++) {
+        long id = find_term(MyStringView(term, length));
+        if (id < 0) {
+            missing++;
+            continue;
+        }
+        bool repeated = false;
+        for (unsigned int i = 0; i < count && !keep_repeats; i++) repeated = repeated || ids[i] == id;
+        if (repeated) continue;
+
+        ids[count] = id;
+        cursors[count].open(terms[id], postings, skips, header->entry_count);
+        cursors[count].query_offset = offset;
+        count++;
+    }
+    return count;
+}
+
+double TextIndex::idf(unsigned int entry_count) const {
+    double entries = (double)header->entry_count;
+    return log(1.0 + (entries - entry_count + 0.5) / (entry_count + 0.5));
+}
+
+// Binary search of an entry's ascending positions
+static bool positions_contain(const unsigned int* positions, unsigned int count, unsigned long position) {
+    unsigned int low = 0, high = count;
+    while (low < high) {
+        unsigned int middle = low + (high - low) / 2;
+        if (positions[middle] < position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < count && positions[low] == position;
+}
+
+// Leapfrog intersection: the rarest list proposes an entry and every other
+// list advances to it, or past it to propose a later one. For a phrase,
+// each start the rarest term's positions allow is checked in the others.
+unsigned long TextIndex::intersect(PostingCursor* cursors, unsigned int count, bool phrase,
+                                   MyVector<unsigned long>& entries) const {
+    for (unsigned int i = 1; i < count; i++) {
+        for (unsigned int j = i; j > 0 && cursors[j].list_size < cursors[j - 1].list_size; j--) {
+            PostingCursor swapped = cursors[j];
+            cursors[j] = cursors[j - 1];
+            cursors[j - 1] = swapped;
+        }
+    }
+    for (unsigned int i = 0; i < count; i++) {
+        if (!cursors[i].next()) return 0;
+    }
+
+    unsigned int* positions = nullptr;
+    unsigned long position_capacity = 0;
+    unsigned int starts[MAX_QUERY_TERMS + 1];
+    unsigned long matched = 0;
+    bool more = true;
+    while (more) {
+        unsigned long candidate = cursors[0].entry;
+        unsigned int i = 1;
+        while (i < count && cursors[i].advance_to(candidate) && cursors[i].entry == candidate) i++;
+        if (i < count) {
+            more = !cursors[i].done && cursors[0].advance_to(cursors[i].entry);
+            continue;
+        }
+
+        bool accepted = true;
+        if (phrase && count > 1) {
+            unsigned long needed = 0;
+            for (unsigned int c = 0; c < count; c++) needed += cursors[c].frequency;
+            if (needed > position_capacity) {
+                if (positions) free(positions);
+                position_capacity = needed * 2;
+                positions = (unsigned int*)malloc(sizeof(unsigned int) * position_capacity);
+                if (!positions) {
+                    position_capacity = 0;
+                    break;
+                }
+            }
+            starts[0] = 0;
+            for (unsigned int c = 0; c < count; c++) {
+                starts[c + 1] = starts[c] + cursors[c].read_positions(positions + starts[c]);
+            }
+
+            accepted = false;
+            const PostingCursor& rarest = cursors[0];
+            for (unsigned int p = starts[0]; p < starts[1] && !accepted; p++) {
+                if (positions[p] < rarest.query_offset) continue;
+                unsigned long phrase_start = positions[p] - rarest.query_offset;
+                accepted = true;
+                for (unsigned int c = 1; c < count && accepted; c++) {
+                    accepted = positions_contain(positions + starts[c], starts[c + 1] - starts[c],
+                                                 phrase_start + cursors[c].query_offset);
+                }
+            }
+        }
+        if (accepted) {
+            entries.push_back(candidate);
+            matched++;
+        }
+        more = cursors[0].next();
+    }
+
+    if (positions) free(positions);
+    return matched;
+}
+
+unsigned long TextIndex::find_all(const MyStringView& query, MyVector<unsigned long>& entries) const {
+    PostingCursor cursors[MAX_QUERY_TERMS];
+    unsigned int missing;
+    unsigned int count = open_cursors(query, cursors, false, missing);
+    if (count == 0 || missing > 0) return 0;
+    return intersect(cursors, count, false, entries);
+}
+
+unsigned long TextIndex::find_phrase(const MyStringView& query, MyVector<unsigned long>& entries) const {
+    PostingCursor cursors[MAX_QUERY_TERMS];
+    unsigned int missing;
+    unsigned int count = open_cursors(query, cursors, true, missing);
+    if (count == 0 || missing > 0) return 0;
+    return intersect(cursors, count, true, entries);
+}
+
+// Union by repeatedly taking the smallest entry any list is on
+unsigned long TextIndex::find_any(const MyStringView& query, MyVector<unsigned long>& entries) const {
+    PostingCursor cursors[MAX_QUERY_TERMS];
+    unsigned int missing;
+    unsigned int count = open_cursors(query, cursors, false, missing);
+    for (unsigned int i = 0; i < count; i++) cursors[i].next();
+
+    unsigned long matched = 0;
+    for (;;) {
+        bool found = false;
+        unsigned long smallest = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            if (!cursors[i].done && (!found || cursors[i].entry < smallest)) {
+                smallest = cursors[i].entry;
+                found = true;
+            }
+        }
+        if (!found) break;
+
+        entries.push_back(smallest);
+        matched++;
+        for (unsigned int i = 0; i < count; i++) {
+            if (!cursors[i].done && cursors[i].entry == smallest) cursors[i].next();
+        }
+    }
+    return matched;
+}
+
+// Ranking heap: the worst hit is at the root, and of equal scores the
+// later entry is worse
+static bool hit_worse(const TextHit& a, const TextHit& b) {
+    return a.score < b.score || (a.score == b.score && a.entry > b.entry);
+}
+
+static void hit_sift_down(TextHit* heap, unsigned long root, unsigned long count) {
+    for (;;) {
+        unsigned long worst = root, left = root * 2 + 1, right = left + 1;
+        if (left < count && hit_worse(heap[left], heap[worst])) worst = left;
+        if (right < count && hit_worse(heap[right], heap[worst])) worst = right;
+        if (worst == root) return;
+        TextHit swapped = heap[root];
+        heap[root] = heap[worst];
+        heap[worst] = swapped;
+        root = worst;
+    }
+}
+
+static void hit_sift_up(TextHit* heap, unsigned long child) {
+    while (child > 0) {
+        unsigned long parent = (child - 1) / 2;
+        if (!hit_worse(heap[child], heap[parent])) return;
+        TextHit swapped = heap[child];
+        heap[child] = heap[parent];
+        heap[parent] = swapped;
+        child = parent;
+    }
+}
+
+// Document-at-a-time scoring with MaxScore pruning. Lists are ordered by
+// their largest possible contribution; once the k-th best score exceeds
+// what the weakest lists could add up to, those lists stop proposing
+// entries and are only probed (through their skips) for entries the
+// others propose, and probing stops as soon as an entry cannot make it.
+unsigned long TextIndex::top_k(const MyStringView& query, unsigned int k, MyVector<TextHit>& hits) const {
+    if (!header) return 0;
+
+    PostingCursor cursors[MAX_QUERY_TERMS];
+    unsigned int missing;
+    unsigned int count = open_cursors(query, cursors, false, missing);
+    if (k > header->entry_count) k = (unsigned int)header->entry_count;
+    if (count == 0 || k == 0) return 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        cursors[i].weight = idf(cursors[i].list_size);
+        cursors[i].bound = cursors[i].weight * (BM25_K1 + 1.0);
+        cursors[i].next();
+    }
+    for (unsigned int i = 1; i < count; i++) {
+        for (unsigned int j = i; j > 0 && cursors[j].bound < cursors[j - 1].bound; j--) {
+            PostingCursor swapped = cursors[j];
+            cursors[j] = cursors[j - 1];
+            cursors[j - 1] = swapped;
+        }
+    }
+    double bound_sums[MAX_QUERY_TERMS];     // Of lists 0..i
+    for (unsigned int i = 0; i < count; i++) {
+        bound_sums[i] = cursors[i].bound + (i > 0 ? bound_sums[i - 1] : 0.0);
+    }
+
+    TextHit* heap = (TextHit*)malloc(sizeof(TextHit) * k);
+    if (!heap) return 0;
+    unsigned long heap_size = 0;
+    double average_length = header->entry_count > 0 && header->total_length > 0 ?
+                            (double)header->total_length / header->entry_count : 1.0;
+    double contributions[MAX_QUERY_TERMS];
+    unsigned int essential = 0;     // Lists before it only confirm entries
+    double threshold = 0.0;
+
+    while (essential < count) {
+        bool found = false;
+        unsigned long candidate = 0;
+        for (unsigned int i = essential; i < count; i++) {
+            if (!cursors[i].done && (!found || cursors[i].entry < candidate)) {
+                candidate = cursors[i].entry;
+                found = true;
+            }
+        }
+        if (!found) break;
+
+        double length_norm = BM25_K1 * (1.0 - BM25_B + BM25_B * entry_lengths[candidate] / average_length);
+        double score = 0.0;
+        for (unsigned int i = essential; i < count; i++) {
+            contributions[i] = 0.0;
+            if (!cursors[i].done && cursors[i].entry == candidate) {
+                double frequency = cursors[i].frequency;
+                contributions[i] = cursors[i].weight * frequency * (BM25_K1 + 1.0) / (frequency + length_norm);
+                score += contributions[i];
+                cursors[i].next();
+            }
+        }
+        bool pruned = false;
+        for (unsigned int i = essential; i-- > 0 && !pruned;) {
+            contributions[i] = 0.0;
+            if (heap_size == k && score + bound_sums[i] <= threshold) {
+                pruned = true;
+            } else if (cursors[i].advance_to(candidate) && cursors[i].entry == candidate) {
+                double frequency = cursors[i].frequency;
+                contributions[i] = cursors[i].weight * frequency * (BM25_K1 + 1.0) / (frequency + length_norm);
+                score += contributions[i];
+            }
+        }
+        if (pruned) continue;
+
+        // Summed in list order so a score never depends on how it was reached
+        score = 0.0;
+        for (unsigned int i = 0; i < count; i++) score += contributions[i];
+        TextHit hit = {candidate, score};
+        if (heap_size < k) {
+            heap[heap_size++] = hit;
+            hit_sift_up(heap, heap_size - 1);
+        } else if (hit_worse(heap[0], hit)) {
+            heap[0] = hit;
+            hit_sift_down(heap, 0, heap_size);
+        } else {
+            continue;
+        }
+
+        if (heap_size == k) {
+            threshold = heap[0].score;
+            while (essential < count && bound_sums[essential] <= threshold) essential++;
+        }
+    }
+
+    // Popping the worst hit to the back leaves the heap sorted best first
+    for (unsigned long size = heap_size; size > 1; size--) {
+        TextHit worst = heap[0];
+        heap[0] = heap[size - 1];
+        heap[size - 1] = worst;
+        hit_sift_down(heap, 0, size - 1);
+    }
+    hits.reserve(hits.get_size() + heap_size);
+    for (unsigned long i = 0; i < heap_size; i++) hits.push_back(heap[i]);
+    free(heap);
+    return heap_size;
+}
@@ -0,0 +1,159 @@
+// textindex.h - Inverted full-text index over entry titles and abstracts
+#ifndef TEXTINDEX_H
+#define TEXTINDEX_H
+
+#include "bibdatabase.h"
+
+// One ranked result of TextIndex::top_k
+struct TextHit {
+    unsigned long entry;    // Position in the indexed database
+    double score;           // BM25
+};
+
+// Splits text into index terms: lowercase runs of ASCII letters and digits
+// (bytes >= 0x80 count as letters, so UTF-8 words stay whole). Braces,
+// backslashes and all other punctuation only separate terms. Terms longer
+// than MAX_TERM_LENGTH keep their first MAX_TERM_LENGTH bytes.
+class TextTokenizer {
+private:
+    const char* text;
+    unsigned long length;
+    unsigned long cursor;
+
+public:
+    static const unsigned int MAX_TERM_LENGTH = 64;
+
+    TextTokenizer(const MyStringView& input);
+
+    // Writes the next term to term (MAX_TERM_LENGTH bytes, not terminated)
+    // and returns its length, or 0 at the end of the text
+    unsigned int next(char* term);
+};
+
+// Maps every term of the entries' titles and abstracts to a posting list
+// of the entries containing it. Each list is a run of varints:
+//
+//   per entry:  entry delta, term frequency, position delta per occurrence
+//
+// Positions count the terms of the title and then, after a gap, those of
+// the abstract, so a phrase never spans the two. Every SKIP_INTERVAL
+// entries a skip record notes the byte offset and preceding entry, which
+// lets AND, phrase and ranked queries jump over long lists.
+//
+// The whole index is one block laid out exactly like its file: save()
+// writes the block and load() maps the file and queries it in place. An
+// index describes one database as it was when built; rebuild or reload it
+// after entries change.
+class TextIndex {
+public:
+    static const unsigned int SKIP_INTERVAL = 64;
+
+    // Index file layout (all sections 8-byte aligned, native byte order):
+    //   Header, TermRecord[term_count], unsigned int table[table_size]
+    //   (term ids by hash, open addressing), SkipRecord[skip_count],
+    //   unsigned int entry_lengths[entry_count], term text, postings
+    struct Header {
+        char magic[8];              // "BIBTEXT" and a terminator
+        unsigned int version;
+        unsigned int header_size;
+        unsigned long byte_order;
+        unsigned long file_size;
+        SourceStamp source;
+        unsigned long entry_count;
+        unsigned long term_count;
+        unsigned long table_size;   // Power of two
+        unsigned long skip_count;
+        unsigned long total_length; // Sum of entry_lengths
+        unsigned long terms_offset;
+        unsigned long table_offset;
+        unsigned long skips_offset;
+        unsigned long lengths_offset;
+        unsigned long text_offset;
+        unsigned long text_size;
+        unsigned long postings_offset;
+        unsigned long postings_size;
+    };
+
+    struct TermRecord {
+        unsigned long text_offset;
+        unsigned long postings_offset;
+        unsigned long postings_length;
+        unsigned long first_skip;
+        unsigned int text_length;
+        unsigned int entry_count;       // Document frequency
+    };
+
+    // Start of posting block b (b >= 1) of a term: entry b * SKIP_INTERVAL
+    struct SkipRecord {
+        unsigned long offset;           // From the start of the term's postings
+        unsigned long previous_entry;   // Entry the block's first delta is relative to
+    };
+
+private:
+    char* block;                // Built index (null when loaded or empty)
+    const char* mapping;        // Loaded index file
+    unsigned long mapping_size;
+    const Header* header;
+    const TermRecord* terms;
+    const unsigned int* table;
+    const SkipRecord* skips;
+    const unsigned int* entry_lengths;
+    const char* text;
+    const unsigned char* postings;
+
+    struct PostingCursor;       // Defined in textindex.cpp
+    struct BuildChunk;
+    static void build_chunk_task(void* context, unsigned long index);
+
+    void attach(const char* data);
+    long find_term(const MyStringView& term) const;
+    // One cursor per query term (per distinct term unless keep_repeats);
+    // missing counts the terms no entry contains
+    unsigned int open_cursors(const MyStringView& query, PostingCursor* cursors, bool keep_repeats,
+                              unsigned int& missing) const;
+    unsigned long intersect(PostingCursor* cursors, unsigned int count, bool phrase,
+                            MyVector<unsigned long>& entries) const;
+    double idf(unsigned int entry_count) const;
+
+    // Disable copying - the index may own a large block or a mapping
+    TextIndex(const TextIndex& other);
+    TextIndex& operator=(const TextIndex& other);
+
+public:
+    static const unsigned int MAX_QUERY_TERMS = 32;
+    static const double BM25_K1;
+    static const double BM25_B;
+
+    TextIndex();
+    ~TextIndex();
+
+    // Indexes every entry of database, on up to thread_count threads
+    bool build(const BibDatabase& database, int thread_count = 1);
+
+    // Index files; load() fails if the file is damaged, from another
+    // version, or (when source_filename is given) stale for that source
+    bool save(const char* filename, const SourceStamp& source) const;
+    bool load(const char* filename, const char* source_filename);
+    void clear();
+
+    // Statistics
+    bool empty() const;
+    unsigned long get_entry_count() const;
+    unsigned long get_term_count() const;
+    unsigned long get_size() const;     // Bytes of the whole index
+
+    // Boolean queries over the terms of query, appending matching entry
+    // positions in ascending order and returning how many matched.
+    // find_all wants every term, find_any at least one, find_phrase the
+    // terms next to each other in order. At most MAX_QUERY_TERMS are used.
+    unsigned long find_all(const MyStringView& query, MyVector<unsigned long>& entries) const;
+    unsigned long find_any(const MyStringView& query, MyVector<unsigned long>& entries) const;
+    unsigned long find_phrase(const MyStringView& query, MyVector<unsigned long>& entries) const;
+
+    // The k best entries for any of the query terms by Okapi BM25
+    // (k1 = 1.2, b = 0.75), best first; ties go to the earlier entry
+    unsigned long top_k(const MyStringView& query, unsigned int k, MyVector<TextHit>& hits) const;
+
+};
+
+#endif // TEXTINDEX_H